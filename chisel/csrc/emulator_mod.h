@@ -29,6 +29,11 @@
 #include <iostream>
 #include <fstream>
 #include <stdexcept>
+#if __cplusplus >= 201103L
+#include <atomic>
+#include <exception>
+#include <thread>
+#endif
 
 using namespace std;
 
@@ -1544,10 +1549,24 @@ inline dat_t<1> reduction_xor(dat_t<w1> d) {
   return res;
 }
 
+// Walks the architectural state (registers and memories) of a module in a
+// fixed order; see mod_t::visit_state and snapshot_ring_t.
+class state_visitor_t {
+ public:
+  virtual void visit ( val_t* words, int n_words ) = 0;
+  // rows holds depth rows of row_words each; dirty has one bit per row that
+  // is set by every write and left for the visitor to clear.
+  virtual void visit ( val_t* rows, int row_words, int depth, val_t* dirty ) = 0;
+};
+
 template <int w, int d>
 class mem_t {
  public:
   dat_t<w> contents[d];
+  val_t dirty[val_n_words(d)];
+  // Bumped on every change to contents, so a reader can tell whether
+  // the memory may have changed since it last looked.
+  val_t writes;
 
   int width() {
     return w;
@@ -1576,12 +1595,24 @@ class mem_t {
     put(idx.lo_word(), val);
   }
   void put (val_t idx, dat_t<w> val) {
-    if (ispow2(d) || idx < d)
+    if (ispow2(d) || idx < d) {
       contents[idx] = val;
+      mark_dirty(idx);
+    }
   }
-  val_t put (val_t idx, int word, val_t val) {
-    if (ispow2(d) || idx < d)
+  void put (val_t idx, int word, val_t val) {
+    if (ispow2(d) || idx < d) {
       contents[idx].values[word] = val;
+      mark_dirty(idx);
+    }
+  }
+  inline void mark_dirty (val_t idx) {
+    dirty[idx / val_n_bits()] |= (val_t)1 << (idx % val_n_bits());
+    writes++;
+  }
+  void visit_state (state_visitor_t* v) {
+    v->visit(contents[0].values, dat_t<w>::n_words, d, dirty);
+    writes++;
   }
 
   void print ( void ) {
@@ -1596,10 +1627,14 @@ class mem_t {
   mem_t<w,d> () {
     for (int i = 0; i < d; i++)
       contents[i] = DAT<w>(0);
+    memset(dirty, 0, sizeof(dirty));
+    writes = 0;
   }
   void randomize() {
     for (int i = 0; i < d; i++)
       contents[i].randomize();
+    memset(dirty, 0xff, sizeof(dirty));
+    writes++;
   }
   size_t read_hex(const char *hexFileName) {
     ifstream ifp(hexFileName);
@@ -1612,6 +1647,7 @@ class mem_t {
     for (int addr = 0; addr < d && !ifp.eof();) {
       getline(ifp, hex_line);
       if (dat_from_hex(hex_line, hex_dat) > 0) {
+	mark_dirty(addr);
 	contents[addr++] = hex_dat;
       }
     }
@@ -1771,6 +1807,34 @@ void dat_dump(FILE* file, const mem_t<w,d>& val, val_t name) {
 
 template <int w, int d> mem_t<w,d> MEM( void );
 
+// Evaluation counts of one partition of a module that skips partitions
+// whose inputs did not change since they were last evaluated.
+struct activity_stats_t {
+  uint64_t evals;
+  uint64_t skips;
+};
+
+// Prints the skip rate of every partition and the total, weighting each
+// partition by its number of nodes.
+inline void print_activity_stats ( FILE* f, const activity_stats_t* const* stats,
+                                  const int* nodes, int n ) {
+  uint64_t work = 0, skipped = 0, evals = 0, skips = 0;
+  fprintf(f, "%8s %8s %12s %12s %7s\n", "vertex", "nodes", "evals", "skips", "skip%");
+  for (int i = 0; i < n; i++) {
+    uint64_t calls = stats[i]->evals + stats[i]->skips;
+    fprintf(f, "%8d %8d %12llu %12llu %6.2f%%\n", i, nodes[i],
+            (unsigned long long)stats[i]->evals, (unsigned long long)stats[i]->skips,
+            calls ? 100.0 * stats[i]->skips / calls : 0.0);
+    evals += stats[i]->evals;
+    skips += stats[i]->skips;
+    work += calls * nodes[i];
+    skipped += stats[i]->skips * nodes[i];
+  }
+  fprintf(f, "vertices skipped: %.2f%%, nodes skipped: %.2f%%\n",
+          evals + skips ? 100.0 * skips / (evals + skips) : 0.0,
+          work ? 100.0 * skipped / work : 0.0);
+}
+
 class mod_t {
  public:
 	mod_t():
@@ -1792,6 +1856,12 @@ class mod_t {
   // Returns true on success, and false on failure. Currently, no guarantees
   // are made about state consistency on failure,
   virtual bool set_circuit_from(mod_t* src) = 0;
+  // Hands every register and memory to v, always in the same order. Wires
+  // are not visited; they are recomputed by the next clock_lo.
+  virtual void visit_state ( state_visitor_t* v ) { };
+  // Reports how often clock_lo skipped unchanged partitions; nothing for
+  // modules generated without --activityEval.
+  virtual void print_activity ( FILE* f ) { };
 
   virtual void print ( FILE* f ) { };
   virtual void dump ( FILE* f, int t ) { };
@@ -1820,6 +1890,235 @@ class mod_t {
   FILE* dumpfile;
 };
 
+// Bounded ring of incremental snapshots of a module's registers and memories.
+// The ring keeps one full image of the state at the newest snapshot, and each
+// snapshot after the first stores only the old values of the words that
+// changed since the one before it. Memories are scanned by dirty row, so the
+// cost of take() is proportional to the registers plus the rows written.
+// restore() rolls the image back through those undo records.
+class snapshot_ring_t : private state_visitor_t {
+ public:
+  snapshot_ring_t(mod_t* mod, int depth) :
+    mod(mod), depth(depth), head(0), count(0), deltas(depth) {
+    assert(depth > 0);
+  }
+
+  // Records the current state as the snapshot for the given cycle.
+  void take ( uint64_t cycle ) {
+    delta_t& delta = deltas[(head + count) % depth];
+    if (count == depth) {
+      head = (head + 1) % depth;
+      // The new oldest snapshot no longer needs a way back.
+      deltas[head].undo.clear();
+    } else {
+      count++;
+    }
+    delta.cycle = cycle;
+    delta.undo.clear();
+    undo = count == 1 ? NULL : &delta.undo;
+    mode = count == 1 && image.empty() ? SNAP_INIT : SNAP_TAKE;
+    walk();
+  }
+
+  // Loads the newest snapshot taken at or before cycle into the module and
+  // drops the snapshots after it. Returns false if cycle is older than the
+  // ring reaches.
+  bool restore ( uint64_t cycle, uint64_t* at ) {
+    if (count == 0 || cycle < deltas[head].cycle)
+      return false;
+    while (deltas[(head + count - 1) % depth].cycle > cycle) {
+      std::vector< std::pair<size_t, val_t> >& u = deltas[(head + count - 1) % depth].undo;
+      for (size_t i = 0; i < u.size(); i++)
+        image[u[i].first] = u[i].second;
+      u.clear();
+      count--;
+    }
+    *at = deltas[(head + count - 1) % depth].cycle;
+    mode = SNAP_LOAD;
+    walk();
+    return true;
+  }
+
+  bool empty ( void ) { return count == 0; }
+  uint64_t oldest ( void ) { return deltas[head].cycle; }
+  uint64_t newest ( void ) { return deltas[(head + count - 1) % depth].cycle; }
+  // Number of val_t words held by the undo records, excluding the image.
+  size_t delta_words ( void ) {
+    size_t n = 0;
+    for (int i = 0; i < count; i++)
+      n += deltas[(head + i) % depth].undo.size();
+    return n;
+  }
+
+ private:
+  enum snap_mode_t { SNAP_INIT, SNAP_TAKE, SNAP_LOAD };
+  struct delta_t {
+    uint64_t cycle;
+    std::vector< std::pair<size_t, val_t> > undo;
+  };
+
+  void walk ( void ) {
+    pos = 0;
+    mod->visit_state(this);
+    assert(pos == image.size());
+  }
+
+  void sync ( val_t* words, int n_words ) {
+    if (mode == SNAP_INIT) {
+      image.insert(image.end(), words, words + n_words);
+    } else if (mode == SNAP_LOAD) {
+      memcpy(words, &image[pos], n_words * sizeof(val_t));
+    } else {
+      for (int i = 0; i < n_words; i++) {
+        if (image[pos + i] != words[i]) {
+          if (undo) undo->push_back(std::make_pair(pos + i, image[pos + i]));
+          image[pos + i] = words[i];
+        }
+      }
+    }
+    pos += n_words;
+  }
+
+  void visit ( val_t* words, int n_words ) {
+    sync(words, n_words);
+  }
+
+  void visit ( val_t* rows, int row_words, int n_rows, val_t* dirty ) {
+    size_t base = pos;
+    if (mode == SNAP_TAKE) {
+      for (int i = 0; i < val_n_words(n_rows); i++) {
+        for (val_t bits = dirty[i]; bits; bits &= bits - 1) {
+          size_t row = i * val_n_bits() + __builtin_ctzll(bits);
+          if (row >= n_rows) break;
+          pos = base + row * row_words;
+          sync(rows + row * row_words, row_words);
+        }
+      }
+      pos = base + (size_t)n_rows * row_words;
+    } else {
+      sync(rows, row_words * n_rows);
+    }
+    memset(dirty, 0, val_n_words(n_rows) * sizeof(val_t));
+  }
+
+  mod_t* mod;
+  int depth;
+  int head;
+  int count;
+  std::vector<delta_t> deltas;
+  std::vector<val_t> image;
+  std::vector< std::pair<size_t, val_t> >* undo;
+  snap_mode_t mode;
+  size_t pos;
+};
+
+#if __cplusplus >= 201103L
+// Persistent worker threads for evaluating the independent partitions of a
+// module generated by ModularCppBackend with --threads. run() publishes the
+// tasks of one topological level, every thread (the caller included) pulls
+// tasks until none are left, and all of them meet at a spinning barrier
+// before run() returns. An exception thrown by a task (e.g. ASSERT) is
+// rethrown on the calling thread. Each module instance owns its pool; the
+// workers start on the first run(), so clones kept only as snapshots cost
+// no threads.
+class level_pool_t {
+ public:
+  typedef void (*task_fn_t)(void* arg, int task);
+
+  level_pool_t(int n_threads) : n_threads(n_threads), generation(0), stop(false) { }
+  // a copy (a module's clone()) gets workers of its own
+  level_pool_t(const level_pool_t& other) : n_threads(other.n_threads), generation(0), stop(false) { }
+  level_pool_t& operator= ( const level_pool_t& other ) { return *this; }
+  ~level_pool_t() {
+    stop.store(true, std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_release);
+    for (size_t i = 0; i < workers.size(); i++)
+      workers[i].join();
+  }
+
+  void run ( const int* tasks, int n, task_fn_t fn, void* arg ) {
+    if (n_threads <= 1 || n == 1) {
+      for (int i = 0; i < n; i++)
+        fn(arg, tasks[i]);
+      return;
+    }
+    if (workers.empty()) {
+      for (int i = 1; i < n_threads; i++)
+        workers.push_back(std::thread(&level_pool_t::work, this));
+    }
+    cur_tasks = tasks;
+    cur_n = n;
+    cur_fn = fn;
+    cur_arg = arg;
+    next.store(0, std::memory_order_relaxed);
+    pending.store(workers.size() + 1, std::memory_order_relaxed);
+    failed.store(false, std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_release);
+    drain();
+    int spins = 0;
+    while (pending.load(std::memory_order_acquire) != 0)
+      pause(spins);
+    if (error) {
+      std::exception_ptr e = error;
+      error = std::exception_ptr();
+      std::rethrow_exception(e);
+    }
+  }
+
+ private:
+  // Spins briefly, then yields so an oversubscribed host still progresses.
+  static inline void pause ( int& spins ) {
+    if (++spins < 1024) {
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#endif
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  void drain ( void ) {
+    for (int i = next.fetch_add(1, std::memory_order_relaxed); i < cur_n;
+         i = next.fetch_add(1, std::memory_order_relaxed)) {
+      try {
+        cur_fn(cur_arg, cur_tasks[i]);
+      } catch (...) {
+        if (!failed.exchange(true))
+          error = std::current_exception();
+      }
+    }
+    pending.fetch_sub(1, std::memory_order_acq_rel);
+  }
+
+  void work ( void ) {
+    unsigned seen = 0;
+    for (;;) {
+      unsigned g;
+      int spins = 0;
+      while ((g = generation.load(std::memory_order_acquire)) == seen)
+        pause(spins);
+      seen = g;
+      if (stop.load(std::memory_order_relaxed))
+        return;
+      drain();
+    }
+  }
+
+  int n_threads;
+  std::vector<std::thread> workers;
+  std::atomic<unsigned> generation;
+  std::atomic<bool> stop;
+  std::atomic<int> next;
+  std::atomic<int> pending;
+  std::atomic<bool> failed;
+  std::exception_ptr error;
+  const int* cur_tasks;
+  int cur_n;
+  task_fn_t cur_fn;
+  void* cur_arg;
+};
+#endif /* C++11 */
+
 #define ASSERT(cond, msg) { \
   if (!(cond)) \
     throw std::runtime_error("Assertion failed: " msg); \
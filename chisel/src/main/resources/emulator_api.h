@@ -156,6 +156,11 @@ public:
 	virtual bool set_value(std::string value) = 0;
 	// returns the bitwidth of this wire
 	virtual std::string get_width() = 0;
+	// returns the number of val_t words in this wire's value
+	virtual int get_n_words() = 0;
+	// copies the value into / out of get_n_words() raw words
+	virtual void get_words(val_t* dst) = 0;
+	virtual void set_words(const val_t* src) = 0;
 };
 
 // dat_api dummy class, does nothing except for return errors
@@ -176,6 +181,14 @@ public:
 	std::string get_width() {
 		return "error";
 	}
+
+	int get_n_words() {
+		return 0;
+	}
+
+	void get_words(val_t* dst) {}
+
+	void set_words(const val_t* src) {}
 };
 
 template<int w> class dat_api : public dat_api_base {
@@ -197,6 +210,20 @@ public:
 		return itos(w);
 	}
 
+	int get_n_words() {
+		return dat_t<w>::n_words;
+	}
+
+	void get_words(val_t* dst) {
+		memcpy(dst, dat_ptr->values, sizeof(dat_ptr->values));
+	}
+
+	void set_words(const val_t* src) {
+		memcpy(dat_ptr->values, src, sizeof(dat_ptr->values));
+		if (val_n_word_bits(w))
+			dat_ptr->values[dat_t<w>::n_words-1] &= mask_val(val_n_word_bits(w));
+	}
+
 protected:
 	dat_t<w>* dat_ptr;
 };
@@ -215,6 +242,12 @@ public:
 	virtual std::string get_width() = 0;
 	// returns the number of memory elements
 	virtual std::string get_depth() = 0;
+	// returns the number of val_t words in one element
+	virtual int get_n_words() = 0;
+	// copies an element into / out of get_n_words() raw words, returning
+	// false if the index is out of range
+	virtual bool get_element_words(val_t index, val_t* dst) = 0;
+	virtual bool set_element_words(val_t index, const val_t* src) = 0;
 };
 
 // mem_api dummy class, does nothing except for return errors
@@ -239,6 +272,18 @@ public:
 	std::string get_depth() {
 		return "error";
 	}
+
+	int get_n_words() {
+		return 0;
+	}
+
+	bool get_element_words(val_t index, val_t* dst) {
+		return false;
+	}
+
+	bool set_element_words(val_t index, const val_t* src) {
+		return false;
+	}
 };
 
 template<int w, int d> class mem_api : public mem_api_base {
@@ -255,6 +300,7 @@ public:
 
 	bool set_element(std::string index, std::string value) {
 		int index_int = atoi(index.c_str());
+		mem_ptr->mark_dirty(index_int);
 		return dat_from_str<w>(value, mem_ptr->contents[index_int]);
 	}
 
@@ -266,14 +312,61 @@ public:
 		return itos(d);
 	}
 
+	int get_n_words() {
+		return dat_t<w>::n_words;
+	}
+
+	bool get_element_words(val_t index, val_t* dst) {
+		if (index >= d) return false;
+		memcpy(dst, mem_ptr->contents[index].values, sizeof(mem_ptr->contents[index].values));
+		return true;
+	}
+
+	bool set_element_words(val_t index, const val_t* src) {
+		if (index >= d) return false;
+		dat_t<w>& elt = mem_ptr->contents[index];
+		memcpy(elt.values, src, sizeof(elt.values));
+		if (val_n_word_bits(w))
+			elt.values[dat_t<w>::n_words-1] &= mask_val(val_n_word_bits(w));
+		mem_ptr->mark_dirty(index);
+		return true;
+	}
+
 protected:
 	mem_t<w, d>* mem_ptr;
 };
 
+// Binary protocol, entered with the text command "binary_mode".
+// Every request and reply starts with one api_record_t, followed by n_words
+// raw val_t words of payload for pokes (requests) and peeks (replies).
+// Names are resolved once to handles with wire_handle / mem_handle.
+// Replies are buffered and only written out on API_OP_FLUSH, so a client
+// can send a batch of pokes, a step and its peeks in a single write.
+enum api_op_t {
+	API_OP_PEEK = 1,      // handle                -> value
+	API_OP_POKE,          // handle, value         -> (no reply)
+	API_OP_MEM_PEEK,      // handle, index         -> value
+	API_OP_MEM_POKE,      // handle, index, value  -> (no reply)
+	API_OP_STEP,          // index = cycles        -> index = cycles stepped (at most INT_MAX)
+	API_OP_RESET,         // index = cycles        -> index = cycles in reset (at most INT_MAX)
+	API_OP_FLUSH,         // writes pending replies, ending with this record
+	API_OP_QUIT,          // returns to the text protocol
+	API_OP_ERROR = 0xff   // reply only: bad op, handle, index or length
+};
+
+struct api_record_t {
+	uint32_t op;
+	uint32_t handle;
+	uint64_t index;
+	uint32_t n_words;
+	uint32_t reserved;
+};
+
 class mod_api_t {
 public:
 	mod_api_t():
-		teefile(NULL)
+		teefile(NULL),
+		binary_mode(false)
 	{}
 
 	void init(mod_t* new_module) {
@@ -292,7 +385,7 @@ public:
 	// API basic functions
 	std::string get_host_name() {return "C++ Emulator API";}
 	std::string get_api_version() {return "0";}
-	std::string get_api_support() {return "PeekPoke Introspection";}
+	std::string get_api_support() {return "PeekPoke Introspection Binary";}
 
 	// External access functions & helpers
 	std::vector< std::string > tokenize(std::string str) {
@@ -511,6 +604,41 @@ public:
 			if (!check_command_length(tokens, 1, 1)) { return "error"; }
 			return get_mem_by_name(tokens[1])->get_depth();
 
+		} else if (tokens[0] == "wire_handle") {
+			// IN:  wire_handle <node_name>
+			// OUT: integer handle for the binary protocol
+			if (!check_command_length(tokens, 1, 1)) { return "error"; }
+			if (dat_table.find(tokens[1]) == dat_table.end()) {
+				std::cerr << "Unable to find dat '" << tokens[1] << "'" << std::endl;
+				return "error";
+			}
+			// asking again for the same name gives the same handle
+			if (dat_handle_ids.find(tokens[1]) == dat_handle_ids.end()) {
+				dat_handle_ids[tokens[1]] = dat_handles.size();
+				dat_handles.push_back(dat_table[tokens[1]]);
+			}
+			return itos(dat_handle_ids[tokens[1]]);
+		} else if (tokens[0] == "mem_handle") {
+			// IN:  mem_handle <mem_name>
+			// OUT: integer handle for the binary protocol
+			if (!check_command_length(tokens, 1, 1)) { return "error"; }
+			if (mem_table.find(tokens[1]) == mem_table.end()) {
+				std::cerr << "Unable to find mem '" << tokens[1] << "'" << std::endl;
+				return "error";
+			}
+			if (mem_handle_ids.find(tokens[1]) == mem_handle_ids.end()) {
+				mem_handle_ids[tokens[1]] = mem_handles.size();
+				mem_handles.push_back(mem_table[tokens[1]]);
+			}
+			return itos(mem_handle_ids[tokens[1]]);
+		} else if (tokens[0] == "binary_mode") {
+			// IN:  binary_mode
+			// OUT: ok, after which stdin/stdout carry api_record_t
+			//      requests and replies until API_OP_QUIT
+			if (!check_command_length(tokens, 0, 0)) { return "error"; }
+			binary_mode = true;
+			return "ok";
+
 		} else if (tokens[0] == "referenced_snapshot_save") {
 			// BETA FUNCTION: semantics subject to change, use with caution
 			// IN:  referenced_snapshot_save <name>
@@ -539,6 +667,130 @@ public:
 		return "error";
 	}
 
+	// Evaluates one binary request with its payload (if any), appending
+	// the reply to binary_reply. Returns false on API_OP_QUIT.
+	bool eval_binary(const api_record_t& req, const val_t* payload) {
+		api_record_t rep = req;
+		rep.n_words = 0;
+		std::vector<val_t> value;
+		switch (req.op) {
+		case API_OP_PEEK:
+		case API_OP_POKE:
+			if (req.handle >= dat_handles.size() ||
+			    req.n_words != (req.op == API_OP_POKE ? dat_handles[req.handle]->get_n_words() : 0)) {
+				rep.op = API_OP_ERROR;
+			} else if (req.op == API_OP_POKE) {
+				dat_handles[req.handle]->set_words(payload);
+				return true;
+			} else {
+				value.resize(dat_handles[req.handle]->get_n_words());
+				dat_handles[req.handle]->get_words(&value[0]);
+			}
+			break;
+		case API_OP_MEM_PEEK:
+		case API_OP_MEM_POKE:
+			if (req.handle >= mem_handles.size() ||
+			    req.n_words != (req.op == API_OP_MEM_POKE ? mem_handles[req.handle]->get_n_words() : 0)) {
+				rep.op = API_OP_ERROR;
+			} else if (req.op == API_OP_MEM_POKE) {
+				if (mem_handles[req.handle]->set_element_words(req.index, payload))
+					return true;
+				rep.op = API_OP_ERROR;
+			} else {
+				value.resize(mem_handles[req.handle]->get_n_words());
+				if (!mem_handles[req.handle]->get_element_words(req.index, &value[0])) {
+					rep.op = API_OP_ERROR;
+					value.clear();
+				}
+			}
+			break;
+		case API_OP_STEP:
+			// mod_t::step counts cycles in an int
+			if (req.index > INT_MAX)
+				rep.op = API_OP_ERROR;
+			else
+				rep.index = module->step(false, (int)req.index);
+			break;
+		case API_OP_RESET:
+			// bounded like API_OP_STEP
+			if (req.index > INT_MAX) {
+				rep.op = API_OP_ERROR;
+				break;
+			}
+			for (uint64_t i = 0; i < req.index; i++) {
+				module->clock_lo(dat_t<1>(1));
+				module->clock_hi(dat_t<1>(1));
+			}
+			module->clock_lo(dat_t<1>(0));
+			break;
+		case API_OP_FLUSH:
+			break;
+		case API_OP_QUIT:
+			return false;
+		default:
+			rep.op = API_OP_ERROR;
+			break;
+		}
+		rep.n_words = value.size();
+		const char* rep_bytes = (const char*)&rep;
+		binary_reply.insert(binary_reply.end(), rep_bytes, rep_bytes + sizeof(rep));
+		const char* value_bytes = (const char*)value.data();
+		binary_reply.insert(binary_reply.end(), value_bytes, value_bytes + value.size() * sizeof(val_t));
+		return true;
+	}
+
+	// The payload length a request has to carry, from its op and handle
+	uint32_t payload_words(const api_record_t& req) {
+		if (req.op == API_OP_POKE && req.handle < dat_handles.size())
+			return dat_handles[req.handle]->get_n_words();
+		if (req.op == API_OP_MEM_POKE && req.handle < mem_handles.size())
+			return mem_handles[req.handle]->get_n_words();
+		return 0;
+	}
+
+	// Reads the n_words of payload following a request, a few at a time,
+	// copying them to the tee file. They are kept in payload only if keep
+	// is set, so a request with a bad length can't make us allocate for it.
+	// Returns false at end of input.
+	bool read_payload(uint32_t n_words, bool keep, std::vector<val_t>& payload) {
+		val_t chunk[64];
+		payload.clear();
+		while (n_words > 0) {
+			uint32_t n = n_words < 64 ? n_words : 64;
+			if (fread(chunk, sizeof(val_t), n, stdin) != n)
+				return false;
+			if (teefile != NULL)
+				fwrite(chunk, sizeof(val_t), n, teefile);
+			if (keep)
+				payload.insert(payload.end(), chunk, chunk + n);
+			n_words -= n;
+		}
+		return true;
+	}
+
+	// Serves binary requests from stdin until API_OP_QUIT or end of input.
+	void binary_loop() {
+		api_record_t req;
+		std::vector<val_t> payload;
+		while (fread(&req, sizeof(req), 1, stdin) == 1) {
+			if (teefile != NULL)
+				fwrite(&req, sizeof(req), 1, teefile);
+			// a payload of the wrong length is skipped; eval_binary
+			// answers the request with API_OP_ERROR
+			if (!read_payload(req.n_words, req.n_words == payload_words(req), payload))
+				break;
+			if (!eval_binary(req, payload.data()))
+				break;
+			if (req.op == API_OP_FLUSH) {
+				fwrite(binary_reply.data(), 1, binary_reply.size(), stdout);
+				fflush(stdout);
+				binary_reply.clear();
+			}
+		}
+		if (teefile != NULL) fflush(teefile);
+		binary_mode = false;
+	}
+
 	void read_eval_print_loop() {
 		while (true) {
 		    std::string str_in;
@@ -552,6 +804,9 @@ public:
 		    } else {
 		    	cout << eval_command(str_in) << std::endl;
 		    }
+		    if (binary_mode) {
+		    	binary_loop();
+		    }
 		}
 	}
 
@@ -559,6 +814,15 @@ protected:
 	FILE* teefile;
 	mod_t* module;
 
+	// Binary protocol state: handles index into these in the order they
+	// were handed out
+	bool binary_mode;
+	std::vector<dat_api_base*> dat_handles;
+	std::vector<mem_api_base*> mem_handles;
+	std::map<std::string, uint32_t> dat_handle_ids;
+	std::map<std::string, uint32_t> mem_handle_ids;
+	std::vector<char> binary_reply;
+
 	// Mapping table functions
 	virtual void init_mapping_table() = 0;
 
@@ -59,6 +59,21 @@ abstract class Backend {
     new java.io.FileWriter(baseDir + name)
   }
 
+  /** Writes *contents* to the output file *name* unless the file already
+    holds exactly that, so that its timestamp only moves when it changed
+    and make does not rebuild what depends on it. */
+  def writeOutputFileIfChanged(name: String, contents: String) {
+    val file = new File(ensureDir(Driver.targetDir) + name)
+    if (file.exists && file.length == contents.length) {
+      val source = scala.io.Source.fromFile(file)
+      val same = try { source.mkString == contents } finally { source.close() }
+      if (same) return
+    }
+    val out = createOutputFile(name)
+    out.write(contents)
+    out.close()
+  }
+
   def depthString(depth: Int): String = {
     var res = "";
     for (i <- 0 until depth)
@@ -62,6 +62,12 @@ object CString {
 class CppBackend extends Backend {
   val keywords = new HashSet[String]();
   private var hasPrintfs = false
+  protected def needsThreads = false
+  /* Temporaries computed in one chunk of clock_lo and read in another;
+   these are declared as members instead of locals. */
+  val sharedTemps = new HashSet[Node]
+  /* Generated .cpp files, without extension, that make up the model. */
+  val cppFiles = new ArrayBuffer[String]
 
   override def emitTmp(node: Node): String = {
     require(false)
@@ -153,17 +159,77 @@ class CppBackend extends Backend {
     out.toString()
   }
 
+  def emitVisitState(node: Node): String = {
+    node match {
+      case x: Reg =>
+        s"  v->visit(${emitRef(node)}.values, ${words(node)});\n"
+      case m: Mem[_] =>
+        s"  ${emitRef(m)}.visit_state(v);\n"
+      case _ =>
+        ""
+    }
+  }
+
   val bpw = 64
   def words(node: Node): Int = (node.width - 1) / bpw + 1
   def fullWords(node: Node): Int = node.width/bpw
   def emitLoWordRef(node: Node): String = emitWordRef(node, 0)
   def emitTmpDec(node: Node): String = {
-    if (!node.isInObject) {
+    if (!node.isInObject && !sharedTemps.contains(node)) {
       "  val_t " + (0 until words(node)).map(emitRef(node) + "__w" + _).reduceLeft(_ + ", " + _) + ";\n"
     } else {
       ""
     }
   }
+  def emitSharedTempDec(node: Node): String = {
+    if (sharedTemps.contains(node)) {
+      "  val_t " + (0 until words(node)).map(emitRef(node) + "__w" + _).reduceLeft(_ + ", " + _) + ";\n"
+    } else {
+      ""
+    }
+  }
+
+  /** The node whose storage emitRef names when x is referenced. */
+  def storageOf(x: Node): Node = {
+    x match {
+      case b: Binding => storageOf(b.inputs(0))
+      case b: Bits if !b.isInObject && b.inputs.length == 1 => storageOf(b.inputs(0))
+      case _ => x
+    }
+  }
+
+  /** Marks the temporaries that are read in another chunk than the one
+    computing them. */
+  def findSharedTemps(chunks: Seq[Seq[Node]]) {
+    val chunkOf = new HashMap[Node, Int]
+    for ((chunk, k) <- chunks.zipWithIndex; m <- chunk) chunkOf(m) = k
+    for ((chunk, k) <- chunks.zipWithIndex; m <- chunk; i <- m.inputs; if i != null) {
+      val s = storageOf(i)
+      if (!s.isLit && !s.isInObject && chunkOf.getOrElse(s, k) != k)
+        sharedTemps += s
+    }
+  }
+
+  /** Estimated number of operations in emitted code: one per statement. */
+  def opCount(code: String): Int = code.count(_ == ';')
+
+  /** Cuts items, in order, into runs of about Driver.opsPerChunk
+    operations. */
+  def splitChunks[T](items: Seq[T], ops: T => Int): ArrayBuffer[ArrayBuffer[T]] = {
+    val res = ArrayBuffer(new ArrayBuffer[T])
+    var n = 0
+    for (item <- items) {
+      val k = ops(item)
+      if (n > 0 && n + k > Driver.opsPerChunk) {
+        res += new ArrayBuffer[T]
+        n = 0
+      }
+      res.last += item
+      n += k
+    }
+    res
+  }
+
   def block(s: Seq[String]): String = 
     if (s.length == 0)
       ""
@@ -611,24 +677,36 @@ class CppBackend extends Backend {
     val flags = if (flagsIn == null) "-O2" else flagsIn
 
     val chiselENV = java.lang.System.getenv("CHISEL")
-    val c11 = if (hasPrintfs) " -std=c++11 " else ""
-    val allFlags = flags + c11 + " -I../ -I" + chiselENV + "/csrc/"
+    val c11 = if (hasPrintfs || needsThreads) " -std=c++11 " else ""
+    val pthread = if (needsThreads) " -pthread" else ""
+    val allFlags = flags + c11 + pthread + " -I../ -I" + chiselENV + "/csrc/"
     val dir = Driver.targetDir + "/"
     def run(cmd: String) {
       val bashCmd = Seq("bash", "-c", cmd)
       val c = bashCmd.!
       ChiselError.info(cmd + " RET " + c)
     }
+    def file(name: String) = new java.io.File(dir + name)
+    def newer(a: String, b: String) = file(a).exists && file(a).lastModified >= file(b).lastModified
+    val units = if (cppFiles.isEmpty) List(c.name) else cppFiles.toList
     def link(name: String) {
-      val ac = "g++ -o " + dir + name + " " + dir + name + ".o " + dir + name + "-emulator.o"
+      val ac = "g++" + pthread + " -o " + dir + name + " " + units.map(dir + _ + ".o ").mkString + dir + name + "-emulator.o"
       run(ac)
     }
     def cc(name: String) {
       val cmd = "g++ -c -o " + dir + name + ".o " + allFlags + " " + dir + name + ".cpp"
       run(cmd)
     }
+    // every generated file includes emulator.h first, so g++ picks up
+    // emulator.h.gch instead of parsing the runtime again
+    if (List("emulator.h", "emulator_mod.h", "emulator_api.h").exists(!newer("emulator.h.gch", _)))
+      run("g++ -x c++-header -o " + dir + "emulator.h.gch " + allFlags + " " + dir + "emulator.h")
     cc(c.name + "-emulator")
-    cc(c.name)
+    // files left untouched by elaborate keep their objects
+    for (unit <- units) {
+      if (!newer(unit + ".o", unit + ".cpp") || !newer(unit + ".o", c.name + ".h"))
+        cc(unit)
+    }
     link(c.name)
   }
 
@@ -740,19 +818,26 @@ class CppBackend extends Backend {
       ChiselError.info("NUM " + numNodes + " MAX-WIDTH " + maxWidth + " MAX-DEPTH " + maxDepth);
     }
 
-    val clkDomains = new HashMap[Clock, (StringBuilder, StringBuilder)]
+    // Split the clock_lo and clock_hi of every clock domain into chunks of
+    // about Driver.opsPerChunk operations, each a function in a file of its
+    // own, so no single function dominates the build and make can skip
+    // the chunks whose code did not change.
+    def clockOf(m: Node) = if (m.clock == null) Driver.implicitClock else m.clock
+    val loChunks = new HashMap[Clock, ArrayBuffer[ArrayBuffer[Node]]]
+    val hiChunks = new HashMap[Clock, ArrayBuffer[ArrayBuffer[String]]]
     for (clock <- Driver.clocks) {
-      val clock_lo = new StringBuilder
-      val clock_hi = new StringBuilder
-      clkDomains += (clock -> ((clock_lo, clock_hi)))
-      clock_lo.append("void " + c.name + "_t::clock_lo" + clkName(clock) + " ( dat_t<1> reset ) {\n")
-      clock_hi.append("void " + c.name + "_t::clock_hi" + clkName(clock) + " ( dat_t<1> reset ) {\n")
+      val mods = c.omods.filter(clockOf(_) == clock)
+      loChunks(clock) = splitChunks(mods, (m: Node) => opCount(emitDefLo(m)))
+      // MemWrites are scheduled before Reg updates in case a MemWrite input is a Reg
+      val hi = (mods.map(emitInitHi) ++ mods.map(emitDefHi)).filter(_ != "")
+      hiChunks(clock) = splitChunks(hi, (code: String) => opCount(code))
     }
+    findSharedTemps(loChunks.values.flatten.toSeq)
 
     if (Driver.isGenHarness) {
       genHarness(c, c.name);
     }
-    val out_h = createOutputFile(c.name + ".h");
+    val out_h = new java.io.StringWriter
     if (!Params.space.isEmpty) {
       val out_p = createOutputFile(c.name + ".p");
       out_p.write(Params.toDotpStringParams);
@@ -776,6 +861,7 @@ class CppBackend extends Backend {
         if (m.isInVCD) {
           out_h.write(vcd.emitDec(m));
         }
+        out_h.write(emitSharedTempDec(m))
       }
     }
     for (clock <- Driver.clocks)
@@ -786,6 +872,10 @@ class CppBackend extends Backend {
     for ( clock <- Driver.clocks) {
       out_h.write("  void clock_lo" + clkName(clock) + " ( dat_t<1> reset );\n")
       out_h.write("  void clock_hi" + clkName(clock) + " ( dat_t<1> reset );\n")
+      for (k <- 0 until loChunks(clock).length; if loChunks(clock).length > 1)
+        out_h.write("  void clock_lo" + clkName(clock) + "_" + k + " ( dat_t<1> reset );\n")
+      for (k <- 0 until hiChunks(clock).length; if hiChunks(clock).length > 1)
+        out_h.write("  void clock_hi" + clkName(clock) + "_" + k + " ( dat_t<1> reset );\n")
     }
     out_h.write("  int clock ( dat_t<1> reset );\n")
     if (Driver.clocks.length > 1) {
@@ -793,6 +883,7 @@ class CppBackend extends Backend {
     }
     out_h.write("  mod_t* clone();\n");
     out_h.write("  bool set_circuit_from(mod_t* src);\n");
+    out_h.write("  void visit_state ( state_visitor_t* v );\n");
     out_h.write("  void print ( FILE* f );\n");
     out_h.write("  void dump ( FILE* f, int t );\n");
     out_h.write("  void dump_init ( FILE* f );\n");
@@ -806,22 +897,41 @@ class CppBackend extends Backend {
     
     out_h.write("\n\n#endif\n");
     out_h.close();
+    writeOutputFileIfChanged(c.name + ".h", out_h.toString)
 
-    // Generate CPP files
-    val out_cpps = ArrayBuffer[java.io.FileWriter]()
+    // Generate CPP files; emulator.h comes first so that a precompiled
+    // emulator.h.gch can stand in for it
+    val out_cpps = ArrayBuffer[(String, StringBuilder)]()
     val all_cpp = new StringBuilder
     def createCppFile(suffix: String = "-" + out_cpps.length) = {
-      val f = createOutputFile(c.name + suffix + ".cpp")
-      f.write("#include \"" + c.name + ".h\"\n")
-      for (str <- Driver.includeArgs) f.write("#include \"" + str + "\"\n")
-      f.write("\n")
-      out_cpps += f
+      val f = new StringBuilder
+      f.append("#include \"emulator.h\"\n")
+      f.append("#include \"" + c.name + ".h\"\n")
+      for (str <- Driver.includeArgs) f.append("#include \"" + str + "\"\n")
+      f.append("\n")
+      out_cpps += ((c.name + suffix, f))
       f
     }
     def writeCppFile(s: String) = {
-      out_cpps.last.write(s)
+      out_cpps.last._2.append(s)
       all_cpp.append(s)
     }
+    // Emits fn, calling one function per chunk if there is more than one
+    def writeChunkedFunction(fn: String, chunks: Seq[String]) {
+      if (chunks.length == 1) {
+        createCppFile("-" + fn)
+        writeCppFile("void " + c.name + "_t::" + fn + " ( dat_t<1> reset ) {\n" + chunks(0) + "}\n")
+      } else {
+        for ((chunk, k) <- chunks.zipWithIndex) {
+          createCppFile("-" + fn + "_" + k)
+          writeCppFile("void " + c.name + "_t::" + fn + "_" + k + " ( dat_t<1> reset ) {\n" + chunk + "}\n")
+        }
+        writeCppFile("void " + c.name + "_t::" + fn + " ( dat_t<1> reset ) {\n")
+        for (k <- 0 until chunks.length)
+          writeCppFile("  " + fn + "_" + k + "( reset );\n")
+        writeCppFile("}\n")
+      }
+    }
 
     createCppFile()
     
@@ -835,26 +945,6 @@ class CppBackend extends Backend {
     }
     writeCppFile("}\n")
 
-    for (m <- c.omods) {
-      val clock = if (m.clock == null) Driver.implicitClock else m.clock
-      clkDomains(clock)._1.append(emitDefLo(m))
-    }
-
-    for (m <- c.omods) {
-      val clock = if (m.clock == null) Driver.implicitClock else m.clock
-      clkDomains(clock)._2.append(emitInitHi(m))
-    }
-
-    for (m <- c.omods) {
-      val clock = if (m.clock == null) Driver.implicitClock else m.clock
-      clkDomains(clock)._2.append(emitDefHi(m))
-    }
-
-    for (clk <- clkDomains.keys) {
-      clkDomains(clk)._1.append("}\n")
-      clkDomains(clk)._2.append("}\n")
-    }
-
     // generate clock(...) function
     writeCppFile("int " + c.name + "_t::clock ( dat_t<1> reset ) {\n")
     writeCppFile("  uint32_t min = ((uint32_t)1<<31)-1;\n")
@@ -898,6 +988,15 @@ class CppBackend extends Backend {
     }
     writeCppFile("  return true;\n")
     writeCppFile(s"}\n")
+
+    // generate visit_state function
+    writeCppFile(s"void ${c.name}_t::visit_state ( state_visitor_t* v ) {\n")
+    for (m <- c.omods) {
+      if(m.name != "reset" && m.isInObject) {
+        writeCppFile(emitVisitState(m))
+      }
+    }
+    writeCppFile(s"}\n")
     
     // generate print(...) function
     writeCppFile("void " + c.name + "_t::print ( FILE* f ) {\n")
@@ -920,11 +1019,6 @@ class CppBackend extends Backend {
     createCppFile()
     vcd.dumpVCD(writeCppFile)
 
-    for (out <- clkDomains.values.map(_._1) ++ clkDomains.values.map(_._2)) {
-      createCppFile()
-      writeCppFile(out.result)
-    }
-
     // Generate API functions
     createCppFile()
     writeCppFile(s"void ${c.name}_api_t::init_mapping_table() {\n");
@@ -938,19 +1032,34 @@ class CppBackend extends Backend {
       }
     }
     writeCppFile(s"}\n");
-    
+
+    for (clock <- Driver.clocks) {
+      writeChunkedFunction("clock_lo" + clkName(clock), loChunks(clock).map(_.map(emitDefLo).mkString))
+      writeChunkedFunction("clock_hi" + clkName(clock), hiChunks(clock).map(_.mkString))
+    }
+
+    cppFiles.clear()
+    cppFiles ++= out_cpps.map(_._1)
     createCppFile("")
     writeCppFile(all_cpp.result)
-    out_cpps.foreach(_.close)
+    for ((name, contents) <- out_cpps)
+      writeOutputFileIfChanged(name + ".cpp", contents.result)
+
+    // Drop chunk files of an earlier elaboration that was split differently,
+    // with their objects, so neither build links a chunk that is gone
+    val chunkFile = (java.util.regex.Pattern.quote(c.name) + "-(\\d+|clock_(lo|hi)\\w*)\\.(cpp|o)").r
+    for (f <- new java.io.File(ensureDir(Driver.targetDir)).listFiles) {
+      val m = chunkFile.pattern.matcher(f.getName)
+      if (m.matches && !cppFiles.contains(f.getName.stripSuffix("." + m.group(3))))
+        f.delete()
+    }
 
     def copyToTarget(filename: String) = {
 	  val resourceStream = getClass().getResourceAsStream("/" + filename)
 	  if( resourceStream != null ) {
-	    val classFile = createOutputFile(filename)
-	    while(resourceStream.available > 0) {
-	      classFile.write(resourceStream.read())
-	    }
-	    classFile.close()
+	    val source = scala.io.Source.fromInputStream(resourceStream)
+	    writeOutputFileIfChanged(filename, source.mkString)
+	    source.close()
 	    resourceStream.close()
 	  } else {
 		println(s"WARNING: Unable to copy '$filename'" )
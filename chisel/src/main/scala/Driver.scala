@@ -108,6 +108,10 @@ object Driver {
     isIoDebug = true
     isVCD = false
     isReportDims = false
+    threads = 1
+    isBinaryTester = false
+    activityEval = false
+    opsPerChunk = 10000
     targetDir = "."
     components.clear()
     compStack.clear()
@@ -199,6 +203,10 @@ object Driver {
         case "--targetDir" => targetDir = args(i + 1); i += 1
         case "--include" => includeArgs = args(i + 1).split(' ').toList; i += 1
         case "--checkPorts" => isCheckingPorts = true
+        case "--threads" => threads = args(i + 1).toInt; i += 1
+        case "--binaryTester" => isBinaryTester = true
+        case "--activityEval" => activityEval = true
+        case "--opsPerChunk" => opsPerChunk = args(i + 1).toInt; i += 1
         // Counter backend flags
         case "--backannotation" => isBackannotating = true
         case "--model" => model = args(i + 1) ; i += 1
@@ -250,6 +258,15 @@ object Driver {
   var isInlineMem = true
   var isGenHarness = false
   var isReportDims = false
+  // Number of threads the ModularCppBackend evaluates clock_lo with.
+  var threads = 1
+  // Testers talk to a C++ emulator over its binary peek/poke protocol.
+  var isBinaryTester = false
+  // Skip ModularCppBackend vertices whose inputs did not change.
+  var activityEval = false
+  // Estimated operations per clock_lo/clock_hi chunk of the C++ backend;
+  // every chunk is a function in its own .cpp file.
+  var opsPerChunk = 10000
   var includeArgs: List[String] = Nil
   var targetDir: String = null
   var isCompiling = false
@@ -30,7 +30,7 @@
 
 package Chisel
 
-import scala.collection.mutable.{ArrayBuffer, HashSet, Queue=>ScalaQueue, Stack}
+import scala.collection.mutable.{ArrayBuffer, HashMap, HashSet, Queue=>ScalaQueue, Stack}
 
 class CppVertex {
   val inputs = new ArrayBuffer[Node]
@@ -94,6 +94,102 @@ class ModularCppBackend extends CppBackend {
 
   var threshold = 500
 
+  override protected def needsThreads = Driver.threads > 1
+
+  /** Values clock_lo_<i> of vertex reads but does not compute itself:
+    registers, memories (through their write counter), module inputs and
+    temporaries of other vertices. Returns None if one of them does not
+    outlive clock_lo, in which case the vertex runs every cycle. Undriven
+    wires are don't-cares and are not watched. */
+  def watchedInputs(vertex: CppVertex): Option[ArrayBuffer[Node]] = {
+    val res = new ArrayBuffer[Node]
+    val seen = new HashSet[Node]
+    for (m <- vertex.sortedNodes; if m.name != "reset") {
+      val reads =
+        if (m.inputs.length == 0 && m.isInObject && m.isInstanceOf[Bits]) List(m)
+        else if (emitDefLo(m) == "") Nil
+        else m.inputs.filter(_ != null).map(storageOf)
+      for (s <- reads; if !seen.contains(s)) {
+        seen += s
+        s match {
+          case _ if s.isLit || s.name == "reset" =>
+          case _: ROMData | _: Clock =>
+          case _: Mem[_] => res += s
+          case _ if s == m || s.isInstanceOf[Delay] || s.CppVertex != vertex =>
+            if (s.isInObject || sharedTemps.contains(s)) res += s else return None
+          case _ =>
+        }
+      }
+    }
+    Some(res)
+  }
+
+  def watchedWords(s: Node): Seq[String] = s match {
+    case m: Mem[_] => List(emitRef(m) + ".writes")
+    case _ => (0 until words(s)).map(wordMangle(s, _))
+  }
+
+  /** Compares the watched inputs of vertex i against their values at its
+    last evaluation and returns early if none changed. */
+  def emitActivityCheck(i: Int, watched: Option[ArrayBuffer[Node]]): String = {
+    val stats = "__activity_" + i
+    watched match {
+      case Some(ws) =>
+        val res = new StringBuilder
+        res append "  val_t* __last = __activity_last_" + i + ";\n"
+        res append "  val_t __changed = __activity_stale;\n"
+        for ((word, k) <- ("reset.values[0]" +: ws.flatMap(watchedWords)).zipWithIndex)
+          res append "  __changed |= __last[" + k + "] ^ " + word + "; __last[" + k + "] = " + word + ";\n"
+        res append "  if (!__changed) { " + stats + ".skips++; return; }\n"
+        res append "  " + stats + ".evals++;\n"
+        res.toString
+      case None =>
+        "  " + stats + ".evals++;\n"
+    }
+  }
+
+  /** Groups vertex indices into topological levels: every vertex only
+    depends on vertices of earlier levels, so the vertices of one level can
+    be evaluated concurrently. Returns None if the vertex graph has a
+    cycle. */
+  def levelize(vertices: ArrayBuffer[CppVertex]): Option[ArrayBuffer[ArrayBuffer[Int]]] = {
+    val deps = new HashMap[CppVertex, HashSet[CppVertex]]
+    for (vertex <- vertices) {
+      val d = new HashSet[CppVertex]
+      d ++= vertex.inputVertices.filter(v => v != null && v != vertex)
+      deps(vertex) = d
+    }
+    val level = new HashMap[CppVertex, Int]
+    val visiting = new HashSet[CppVertex]
+    def levelOf(vertex: CppVertex): Option[Int] = {
+      if (level.contains(vertex)) {
+        Some(level(vertex))
+      } else if (visiting.contains(vertex)) {
+        None
+      } else {
+        visiting += vertex
+        var res: Option[Int] = Some(0)
+        for (d <- deps(vertex); if res != None) {
+          res = levelOf(d).map(l => math.max(res.get, l + 1))
+        }
+        visiting -= vertex
+        res.foreach(level(vertex) = _)
+        res
+      }
+    }
+    val levels = new ArrayBuffer[ArrayBuffer[Int]]
+    for ((vertex, i) <- vertices.zipWithIndex) {
+      levelOf(vertex) match {
+        case Some(l) =>
+          while (levels.length <= l) levels += new ArrayBuffer[Int]
+          levels(l) += i
+        case None =>
+          return None
+      }
+    }
+    Some(levels)
+  }
+
   def createVertices(module: Module): ArrayBuffer[CppVertex] = {
     val res = new ArrayBuffer[CppVertex]
     val roots = new ArrayBuffer[Node]
@@ -152,6 +248,13 @@ class ModularCppBackend extends CppBackend {
       renameNodes(c, vertex.sortedNodes)
     }
     println("HUY: finished sort")
+    findSharedTemps(vertices.map(_.sortedNodes))
+    val watched = vertices.map(v => if (Driver.activityEval) watchedInputs(v) else None)
+
+    val levels = if (Driver.threads > 1) levelize(vertices) else None
+    if (Driver.threads > 1 && levels == None) {
+      ChiselError.warning("vertex graph has a cycle, evaluating clock_lo on one thread")
+    }
 
     val out_h = createOutputFile(c.name + ".h")
     val out_c = createOutputFile(c.name + ".cpp")
@@ -161,7 +264,14 @@ class ModularCppBackend extends CppBackend {
     out_h.write("class " + c.name + "_t : public mod_t {\n");
     out_h.write(" public:\n");
     val vcd = new VcdBackend(c)
-    for (vertex <- vertices) {
+    for ((vertex, i) <- vertices.zipWithIndex) {
+      // keep the values written by different threads on separate cache lines
+      if (levels != None) out_h.write("  char __vertex_pad_" + i + "[64];\n")
+      if (Driver.activityEval) {
+        out_h.write("  activity_stats_t __activity_" + i + ";\n")
+        for (ws <- watched(i))
+          out_h.write("  val_t __activity_last_" + i + "[" + (1 + ws.map(watchedWords(_).length).sum) + "];\n")
+      }
       for (m <- vertex.sortedNodes) {
         if(m.name != "reset") {
           if (m.isInObject) {
@@ -170,6 +280,7 @@ class ModularCppBackend extends CppBackend {
           if (m.isInVCD) {
             out_h.write(vcd.emitDec(m));
           }
+          out_h.write(emitSharedTempDec(m))
         }
       }
     }
@@ -181,6 +292,19 @@ class ModularCppBackend extends CppBackend {
     }
     out_h.write("  void clock_lo ( dat_t<1> reset );\n")
     out_h.write("  void clock_hi ( dat_t<1> reset );\n")
+    if (levels != None) {
+      out_h.write("  dat_t<1> clock_lo_reset;\n")
+      out_h.write("  level_pool_t clock_lo_pool{" + Driver.threads + "};\n")
+      out_h.write("  static void clock_lo_vertex ( void* mod, int vertex );\n")
+    }
+    out_h.write("  mod_t* clone();\n");
+    out_h.write("  bool set_circuit_from(mod_t* src);\n");
+    out_h.write("  void visit_state ( state_visitor_t* v );\n");
+    if (Driver.activityEval) {
+      // set when the values saved for the activity checks cannot be trusted
+      out_h.write("  val_t __activity_stale;\n")
+      out_h.write("  void print_activity ( FILE* f );\n")
+    }
     out_h.write("  void print ( FILE* f );\n");
     out_h.write("  void dump ( FILE* f, int t );\n");
     out_h.write("  void dump_init ( FILE* f );\n");
@@ -197,21 +321,50 @@ class ModularCppBackend extends CppBackend {
         out_c.write(emitInit(m));
       }
     }
+    if (Driver.activityEval) {
+      out_c.write("  __activity_stale = 1;\n")
+      for (i <- 0 until vertices.length)
+        out_c.write("  __activity_" + i + ".evals = __activity_" + i + ".skips = 0;\n")
+    }
     out_c.write("}\n");
 
     for ((vertex, i) <- vertices.zipWithIndex) {
       out_c.write("void " + c.name + "_t::clock_lo_" + i + " ( dat_t<1> reset ) {\n")
+      if (Driver.activityEval) out_c.write(emitActivityCheck(i, watched(i)))
       for (m <- vertex.sortedNodes) {
         out_c.write(emitDefLo(m))
       }
       out_c.write("}\n")
     }
 
-    out_c.write("void " + c.name + "_t::clock_lo ( dat_t<1> reset ) {\n")
-    for ((vertex, i) <- vertices.zipWithIndex) {
-      out_c.write("  clock_lo_" + i + "( reset );\n")
+    levels match {
+      case Some(ls) =>
+        out_c.write("void " + c.name + "_t::clock_lo_vertex ( void* mod, int vertex ) {\n")
+        out_c.write("  " + c.name + "_t* m = static_cast<" + c.name + "_t*>(mod);\n")
+        out_c.write("  switch (vertex) {\n")
+        for (i <- 0 until vertices.length) {
+          out_c.write("    case " + i + ": m->clock_lo_" + i + "( m->clock_lo_reset ); break;\n")
+        }
+        out_c.write("  }\n")
+        out_c.write("}\n")
+        out_c.write("void " + c.name + "_t::clock_lo ( dat_t<1> reset ) {\n")
+        for ((l, i) <- ls.zipWithIndex) {
+          out_c.write("  static const int level_" + i + "[] = { " + l.mkString(", ") + " };\n")
+        }
+        out_c.write("  clock_lo_reset = reset;\n")
+        for ((l, i) <- ls.zipWithIndex) {
+          out_c.write("  clock_lo_pool.run(level_" + i + ", " + l.length + ", clock_lo_vertex, this);\n")
+        }
+        if (Driver.activityEval) out_c.write("  __activity_stale = 0;\n")
+        out_c.write("}\n")
+      case None =>
+        out_c.write("void " + c.name + "_t::clock_lo ( dat_t<1> reset ) {\n")
+        for ((vertex, i) <- vertices.zipWithIndex) {
+          out_c.write("  clock_lo_" + i + "( reset );\n")
+        }
+        if (Driver.activityEval) out_c.write("  __activity_stale = 0;\n")
+        out_c.write("}\n")
     }
-    out_c.write("}\n")
     out_c.write("void " + c.name + "_t::clock_hi ( dat_t<1> reset ) {\n")
     for (vertex <- vertices) {
       for (m <- vertex.sortedNodes) {
@@ -225,6 +378,35 @@ class ModularCppBackend extends CppBackend {
     }
     out_c.write("}\n")
 
+    out_c.write("mod_t* " + c.name + "_t::clone() {\n")
+    out_c.write("  return new " + c.name + "_t(*this);\n")
+    out_c.write("}\n")
+    out_c.write("bool " + c.name + "_t::set_circuit_from(mod_t* src) {\n")
+    out_c.write("  " + c.name + "_t* mod_typed = dynamic_cast<" + c.name + "_t*>(src);\n")
+    out_c.write("  assert(mod_typed);\n")
+    for (vertex <- vertices; m <- vertex.sortedNodes) {
+      if (m.name != "reset" && m.isInObject) {
+        out_c.write(emitCircuitAssign("mod_typed->", m))
+      }
+    }
+    if (Driver.activityEval) out_c.write("  __activity_stale = 1;\n")
+    out_c.write("  return true;\n")
+    out_c.write("}\n")
+    out_c.write("void " + c.name + "_t::visit_state ( state_visitor_t* v ) {\n")
+    for (vertex <- vertices; m <- vertex.sortedNodes) {
+      if (m.name != "reset" && m.isInObject) {
+        out_c.write(emitVisitState(m))
+      }
+    }
+    out_c.write("}\n")
+
+    if (Driver.activityEval) {
+      out_c.write("void " + c.name + "_t::print_activity ( FILE* f ) {\n")
+      out_c.write("  static const int nodes[] = { " + vertices.map(_.sortedNodes.length).mkString(", ") + " };\n")
+      out_c.write("  const activity_stats_t* stats[] = { " + (0 until vertices.length).map("&__activity_" + _).mkString(", ") + " };\n")
+      out_c.write("  print_activity_stats(f, stats, nodes, " + vertices.length + ");\n")
+      out_c.write("}\n")
+    }
     out_c.write("void " + c.name + "_t::print ( FILE* f ) {\n");
     for (cc <- Driver.components; p <- cc.printfs)
       out_c.write("#if __cplusplus >= 201103L\n"
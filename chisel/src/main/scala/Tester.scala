@@ -41,6 +41,10 @@ import Literal._
 
 case class Poke(val node: Node, val index: Int, val value: BigInt);
 
+// One api_record_t of the emulator's binary protocol (emulator_api.h)
+// with its payload words.
+case class ApiRecord(val op: Int, val handle: Int, val index: Long, val words: Array[Long])
+
 class Snapshot(val t: Int) {
   val pokes = new ArrayBuffer[Poke]()
 }
@@ -220,6 +224,7 @@ class ManualTester[+T <: Module]
     }
     
     waitForStreams()
+    if (inBinaryMode) leaveBinaryMode()
     
     // send command to emulator
     for (e <- str) testOut.write(e);
@@ -253,6 +258,116 @@ class ManualTester[+T <: Module]
     return sb.toString
   }
 
+  // Binary protocol, with --binaryTester and a C++ emulator. Names are
+  // resolved to handles once; pokes, steps and resets are queued without a
+  // reply and go out together with the next peek, so a cycle of pokes, a
+  // step and a peek costs one write and one read.
+  val API_OP_PEEK = 1
+  val API_OP_POKE = 2
+  val API_OP_MEM_PEEK = 3
+  val API_OP_MEM_POKE = 4
+  val API_OP_STEP = 5
+  val API_OP_RESET = 6
+  val API_OP_FLUSH = 7
+  val API_OP_QUIT = 8
+  val API_OP_ERROR = 0xff
+  val isBinary = Driver.isBinaryTester && Driver.backend.isInstanceOf[CppBackend]
+  var inBinaryMode = false
+  val binaryOut = new java.io.ByteArrayOutputStream()
+  // handle and payload words, per node
+  val wireHandles = new HashMap[Node, (Int, Int)]()
+  val memHandles = new HashMap[Node, (Int, Int)]()
+  val wordMask = (BigInt(1) << 64) - 1
+
+  def binaryRecord(op: Int, handle: Int, index: Long, words: Seq[Long] = Nil) = {
+    if (!inBinaryMode) {
+      emulatorCmd("binary_mode")
+      inBinaryMode = true
+    }
+    val buf = java.nio.ByteBuffer.allocate(24 + 8 * words.length).order(java.nio.ByteOrder.LITTLE_ENDIAN)
+    buf.putInt(op).putInt(handle).putLong(index).putInt(words.length).putInt(0)
+    for (w <- words) buf.putLong(w)
+    binaryOut.write(buf.array)
+  }
+
+  def readBinary(n: Int): java.nio.ByteBuffer = {
+    val bytes = new Array[Byte](n)
+    var got = 0
+    while (got < n) {
+      val r = testIn.read(bytes, got, n - got)
+      if (r < 0) throw new IOException("emulator closed its output")
+      got += r
+    }
+    java.nio.ByteBuffer.wrap(bytes).order(java.nio.ByteOrder.LITTLE_ENDIAN)
+  }
+
+  /**
+   * Sends the queued binary requests with a flush and returns the replies,
+   * without the flush's own. Step replies are added to delta here.
+   */
+  def binaryFlush(): ArrayBuffer[ApiRecord] = {
+    binaryRecord(API_OP_FLUSH, 0, 0)
+    binaryOut.writeTo(testOut)
+    binaryOut.reset()
+    testOut.flush()
+    val replies = new ArrayBuffer[ApiRecord]()
+    var done = false
+    while (!done) {
+      val rec = readBinary(24)
+      val op = rec.getInt(0)
+      val words = readBinary(8 * rec.getInt(16))
+      val reply = ApiRecord(op, rec.getInt(4), rec.getLong(8), Array.tabulate(rec.getInt(16))(i => words.getLong(8 * i)))
+      if (op == API_OP_FLUSH) {
+        done = true
+      } else {
+        if (op == API_OP_ERROR) {
+          System.err.print(s"FAILED: binary request for handle ${reply.handle} index ${reply.index} returned error")
+          ok = false
+        } else if (op == API_OP_STEP) {
+          delta += reply.index.toInt
+        }
+        replies += reply
+      }
+    }
+    replies
+  }
+
+  def leaveBinaryMode() = {
+    binaryFlush()
+    binaryRecord(API_OP_QUIT, 0, 0)
+    binaryOut.writeTo(testOut)
+    binaryOut.reset()
+    testOut.flush()
+    inBinaryMode = false
+  }
+
+  def binaryHandle(data: Node, isMem: Boolean): (Int, Int) = {
+    val handles = if (isMem) memHandles else wireHandles
+    handles.getOrElseUpdate(data, {
+      val kind = if (isMem) "mem" else "wire"
+      val handle = emulatorCmd(kind + "_handle " + dumpName(data))
+      val width = emulatorCmd(kind + "_width " + dumpName(data))
+      (handle.toInt, (width.toInt + 63) / 64)
+    })
+  }
+
+  def binaryPeek(data: Node, off: Int): BigInt = {
+    val (handle, _) = binaryHandle(data, off != -1)
+    binaryRecord(if (off != -1) API_OP_MEM_PEEK else API_OP_PEEK, handle, max(off, 0))
+    val reply = binaryFlush().last
+    if (reply.op == API_OP_ERROR) {
+      -1
+    } else {
+      reply.words.zipWithIndex.map { case (w, i) => (BigInt(w) & wordMask) << (64 * i) }.foldLeft(BigInt(0))(_ | _)
+    }
+  }
+
+  def binaryPoke(data: Node, x: BigInt, off: Int) = {
+    val (handle, n) = binaryHandle(data, off != -1)
+    val words = (0 until n).map(i => ((x >> (64 * i)) & wordMask).longValue)
+    binaryRecord(if (off != -1) API_OP_MEM_POKE else API_OP_POKE, handle, max(off, 0), words)
+  }
+
   def setClocks(clocks: HashMap[Clock, Int]) {
     var cmd = "set_clocks"
     for (clock <- Driver.clocks) {
@@ -283,8 +398,13 @@ class ManualTester[+T <: Module]
       } else {
         cmd = "wire_peek " + dumpName(data);
       }
-      val s = emulatorCmd(cmd)
-      val rv = toLitVal(s)
+      val (rv, s) = if (isBinary) {
+        val v = binaryPeek(data, off)
+        (v, "0x" + v.toString(16))
+      } else {
+        val s = emulatorCmd(cmd)
+        (toLitVal(s), s)
+      }
       if (isTrace) println("  PEEK " + dumpName(data) + " " + (if (off >= 0) (off + " ") else "") + "-> " + s)
       rv
     }
@@ -303,7 +423,7 @@ class ManualTester[+T <: Module]
   }
 
   def reset(n: Int = 1) = {
-    emulatorCmd("reset " + n)
+    if (isBinary) binaryRecord(API_OP_RESET, 0, n) else emulatorCmd("reset " + n)
     // TODO: check for errors in return
     if (isTrace) println("RESET " + n)
   }
@@ -324,7 +444,7 @@ class ManualTester[+T <: Module]
         cmd = "wire_poke " + dumpName(data);
       }
       cmd = cmd + " 0x" + x.toString(16);
-      val rtn = emulatorCmd(cmd)
+      val rtn = if (isBinary) { binaryPoke(data, x, off); "ok" } else emulatorCmd(cmd)
       if (rtn != "ok") {
         System.err.print(s"FAILED: poke(${dumpName(data)}) returned false")
         ok = false
@@ -371,8 +491,8 @@ class ManualTester[+T <: Module]
   def step(n: Int) = {
     if (isSnapshotting) snapshot()
     val target = t + n
-    val s = emulatorCmd("step " + n)
-    delta += s.toInt
+    // a binary step's reply is added to delta once it is flushed
+    if (isBinary) binaryRecord(API_OP_STEP, 0, n) else delta += emulatorCmd("step " + n).toInt
     if (isTrace) println("STEP " + n + " -> " + target)
     if (isSnapshotting) 
       checkForPokes(t+1, target)
@@ -1,3 +1,4 @@
+#include "emulator.h"
 #include "DelaySuite_ROMModule_1.h"
 
 void DelaySuite_ROMModule_1_t::init ( bool rand_init ) {
@@ -28,19 +29,14 @@ bool DelaySuite_ROMModule_1_t::set_circuit_from(mod_t* src) {
   clk_cnt = mod_typed->clk_cnt;
   return true;
 }
+void DelaySuite_ROMModule_1_t::visit_state ( state_visitor_t* v ) {
+}
 void DelaySuite_ROMModule_1_t::print ( FILE* f ) {
 }
 void DelaySuite_ROMModule_1_t::dump_init(FILE *f) {
 }
 void DelaySuite_ROMModule_1_t::dump(FILE *f, int t) {
 }
-void DelaySuite_ROMModule_1_t::clock_lo ( dat_t<1> reset ) {
-  val_t T1__w0;
-  { T1__w0 = T0.get(DelaySuite_ROMModule_1__io_addr.values[0], 0); }
-  { DelaySuite_ROMModule_1__io_out.values[0] = T1__w0; }
-}
-void DelaySuite_ROMModule_1_t::clock_hi ( dat_t<1> reset ) {
-}
 void DelaySuite_ROMModule_1_api_t::init_mapping_table() {
   dat_table.clear();
   mem_table.clear();
@@ -49,3 +45,10 @@ void DelaySuite_ROMModule_1_api_t::init_mapping_table() {
   dat_table["DelaySuite_ROMModule_1.io_addr"] = new dat_api<2>(&mod_typed->DelaySuite_ROMModule_1__io_addr, "DelaySuite_ROMModule_1.io_addr", "");
   dat_table["DelaySuite_ROMModule_1.io_out"] = new dat_api<4>(&mod_typed->DelaySuite_ROMModule_1__io_out, "DelaySuite_ROMModule_1.io_out", "");
 }
+void DelaySuite_ROMModule_1_t::clock_lo ( dat_t<1> reset ) {
+  val_t T1__w0;
+  { T1__w0 = T0.get(DelaySuite_ROMModule_1__io_addr.values[0], 0); }
+  { DelaySuite_ROMModule_1__io_out.values[0] = T1__w0; }
+}
+void DelaySuite_ROMModule_1_t::clock_hi ( dat_t<1> reset ) {
+}
@@ -28,6 +28,7 @@ class DelaySuite_SeqReadBundle_1_t : public mod_t {
   int clock ( dat_t<1> reset );
   mod_t* clone();
   bool set_circuit_from(mod_t* src);
+  void visit_state ( state_visitor_t* v );
   void print ( FILE* f );
   void dump ( FILE* f, int t );
   void dump_init ( FILE* f );
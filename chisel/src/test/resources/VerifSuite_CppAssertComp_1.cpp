@@ -1,3 +1,4 @@
+#include "emulator.h"
 #include "VerifSuite_CppAssertComp_1.h"
 
 void VerifSuite_CppAssertComp_1_t::init ( bool rand_init ) {
@@ -26,20 +27,14 @@ bool VerifSuite_CppAssertComp_1_t::set_circuit_from(mod_t* src) {
   clk_cnt = mod_typed->clk_cnt;
   return true;
 }
+void VerifSuite_CppAssertComp_1_t::visit_state ( state_visitor_t* v ) {
+}
 void VerifSuite_CppAssertComp_1_t::print ( FILE* f ) {
 }
 void VerifSuite_CppAssertComp_1_t::dump_init(FILE *f) {
 }
 void VerifSuite_CppAssertComp_1_t::dump(FILE *f, int t) {
 }
-void VerifSuite_CppAssertComp_1_t::clock_lo ( dat_t<1> reset ) {
-  val_t T1__w0;
-  { T1__w0 = VerifSuite_CppAssertComp_1__io_y.values[0] | VerifSuite_CppAssertComp_1__io_x.values[0] << 8; }
-  { VerifSuite_CppAssertComp_1__io_z.values[0] = T1__w0; }
-  ASSERT(reset.values[0], "failure");
-}
-void VerifSuite_CppAssertComp_1_t::clock_hi ( dat_t<1> reset ) {
-}
 void VerifSuite_CppAssertComp_1_api_t::init_mapping_table() {
   dat_table.clear();
   mem_table.clear();
@@ -49,3 +44,11 @@ void VerifSuite_CppAssertComp_1_api_t::init_mapping_table() {
   dat_table["VerifSuite_CppAssertComp_1.io_x"] = new dat_api<8>(&mod_typed->VerifSuite_CppAssertComp_1__io_x, "VerifSuite_CppAssertComp_1.io_x", "");
   dat_table["VerifSuite_CppAssertComp_1.io_z"] = new dat_api<16>(&mod_typed->VerifSuite_CppAssertComp_1__io_z, "VerifSuite_CppAssertComp_1.io_z", "");
 }
+void VerifSuite_CppAssertComp_1_t::clock_lo ( dat_t<1> reset ) {
+  val_t T1__w0;
+  { T1__w0 = VerifSuite_CppAssertComp_1__io_y.values[0] | VerifSuite_CppAssertComp_1__io_x.values[0] << 8; }
+  { VerifSuite_CppAssertComp_1__io_z.values[0] = T1__w0; }
+  ASSERT(reset.values[0], "failure");
+}
+void VerifSuite_CppAssertComp_1_t::clock_hi ( dat_t<1> reset ) {
+}
@@ -33,6 +33,7 @@ import scala.collection.mutable.ListBuffer
 import org.junit.Assert._
 import org.junit.Ignore
 import org.junit.Test
+import scala.sys.process._
 
 import Chisel._
 
@@ -237,4 +238,36 @@ class DelaySuite extends TestSuite {
     assertFile("DelaySuite_ROMModule_1.h")
     assertFile("DelaySuite_ROMModule_1.cpp")
   }
+
+  /** Registers and memories handed out by visit_state, rolled back
+    with snapshot_ring_t and replayed. */
+
+  @Test def testSnapshot() {
+    class SnapshotModule extends Module {
+      val io = new Bundle() {
+        val wen = Bool(INPUT)
+        val addr = UInt(INPUT, width = 4)
+        val in = UInt(INPUT, width = 8)
+        val out = UInt(OUTPUT, width = 8)
+      }
+      val mem = Mem(UInt(width = 8), 16)
+      when (io.wen) { mem(io.addr) := io.in }
+      val count = Reg(init = UInt(0, width = 8))
+      count := count + io.in
+      io.out := mem(io.addr) ^ count
+    }
+
+    chiselMain(Array[String]("--backend", "c",
+      "--targetDir", dir.getPath.toString()),
+      () => Module(new SnapshotModule()))
+    val harness = scala.io.Source.fromURL(getClass.getResource("SnapshotHarness.cpp"))
+    val out = new java.io.FileWriter(dir.getPath + "/SnapshotHarness.cpp")
+    out.write(harness.mkString)
+    out.close()
+    harness.close()
+    val exe = dir.getPath + "/SnapshotHarness"
+    assert(Seq("g++", "-I" + dir.getPath, "-o", exe, dir.getPath + "/SnapshotHarness.cpp",
+      dir.getPath + "/DelaySuite_SnapshotModule_1.cpp").! === 0)
+    assert(Seq(exe).! === 0)
+  }
 }
@@ -18,6 +18,31 @@ void handle_sigterm(int sig)
   htif->stop();
 }
 
+// Copies one top-level input port to (save) or from the rewind input log.
+template <int w>
+static size_t log_port(dat_t<w>& port, val_t* p, bool save)
+{
+  if (p)
+    memcpy(save ? (void*)p : (void*)port.values, save ? (void*)port.values : (void*)p, sizeof(port.values));
+  return port.n_words;
+}
+
+// Every input the harness drives into the tile; returns the number of words.
+static size_t log_inputs(Top_t& tile, val_t* p, bool save)
+{
+  size_t n = 0;
+  n += log_port(tile.Top__io_mem_req_cmd_ready, p ? p + n : NULL, save);
+  n += log_port(tile.Top__io_mem_req_data_ready, p ? p + n : NULL, save);
+  n += log_port(tile.Top__io_mem_resp_valid, p ? p + n : NULL, save);
+  n += log_port(tile.Top__io_mem_resp_bits_tag, p ? p + n : NULL, save);
+  n += log_port(tile.Top__io_mem_resp_bits_data, p ? p + n : NULL, save);
+  n += log_port(tile.Top__io_mem_backup_en, p ? p + n : NULL, save);
+  n += log_port(tile.Top__io_host_in_valid, p ? p + n : NULL, save);
+  n += log_port(tile.Top__io_host_in_bits, p ? p + n : NULL, save);
+  n += log_port(tile.Top__io_host_out_ready, p ? p + n : NULL, save);
+  return n;
+}
+
 int main(int argc, char** argv)
 {
   unsigned random_seed = (unsigned)time(NULL) ^ (unsigned)getpid();
@@ -29,8 +54,12 @@ int main(int argc, char** argv)
   FILE *vcdfile = NULL;
   disassembler disasm;
   bool dramsim2 = false;
+  int dramsim_requestor_bits = 0;
   bool log = false;
   bool in_test_segment = false;
+  bool activity_stats = false;
+  int rewind_interval = 0, rewind_depth = 0;
+  const char* rewind_vcd = "rewind.vcd";
 
   for (int i = 1; i < argc; i++)
   {
@@ -41,12 +70,20 @@ int main(int argc, char** argv)
       random_seed = atoi(argv[i]+2);
     else if (arg == "+dramsim")
       dramsim2 = true;
+    else if (arg.substr(0, 24) == "+dramsim-requestor-bits=")
+      dramsim_requestor_bits = atoi(argv[i]+24);
     else if (arg == "+verbose")
       log = true;
     else if (arg.substr(0, 12) == "+max-cycles=")
       max_cycles = atoll(argv[i]+12);
     else if (arg.substr(0, 9) == "+loadmem=")
       loadmem = argv[i]+9;
+    else if (arg.substr(0, 13) == "+rewind-ring=")
+      sscanf(argv[i]+13, "%d,%d", &rewind_interval, &rewind_depth);
+    else if (arg.substr(0, 12) == "+rewind-vcd=")
+      rewind_vcd = argv[i]+12;
+    else if (arg == "+activity-stats")
+      activity_stats = true;
   }
 
   const int disasm_len = 24;
@@ -71,7 +108,7 @@ int main(int argc, char** argv)
   Tracer_t tracer(&tile, stderr);
 
   // Instantiate and initialize main memory
-  mm_t* mm = dramsim2 ? (mm_t*)(new mm_dramsim2_t) : (mm_t*)(new mm_magic_t);
+  mm_t* mm = dramsim2 ? (mm_t*)(new mm_dramsim2_t(dramsim_requestor_bits)) : (mm_t*)(new mm_magic_t);
   mm->init(MEM_SIZE, tile.Top__io_mem_resp_bits_data.width()/8, LINE_SIZE);
   if (loadmem)
     load_mem(mm->get_data(), loadmem);
@@ -93,17 +130,45 @@ int main(int argc, char** argv)
     tile.clock_hi(LIT<1>(1));
   }
 
+  // Keep a snapshot every rewind_interval cycles and the inputs of every
+  // cycle since the oldest one, so a failure can be replayed from there.
+  snapshot_ring_t* rewind = NULL;
+  size_t rewind_words = log_inputs(tile, NULL, true);
+  uint64_t rewind_cycles = (uint64_t)rewind_interval * rewind_depth;
+  std::vector<val_t> rewind_log;
+  if (rewind_interval > 0 && rewind_depth > 0)
+  {
+    rewind = new snapshot_ring_t(&tile, rewind_depth);
+    rewind_log.resize(rewind_cycles * rewind_words);
+  }
+  bool assert_failed = false;
+
   tracer.start();
 
   while (!htif->done() && trace_count < max_cycles && !tile.Top_BoomTile_core_dpath__throw_idle_error.lo_word())
   {
+    if (rewind && trace_count % rewind_interval == 0)
+      rewind->take(trace_count);
+
     tile.Top__io_mem_req_cmd_ready = LIT<1>(mm->req_cmd_ready());
     tile.Top__io_mem_req_data_ready = LIT<1>(mm->req_data_ready());
     tile.Top__io_mem_resp_valid = LIT<1>(mm->resp_valid());
     tile.Top__io_mem_resp_bits_tag = LIT<64>(mm->resp_tag());
     memcpy(tile.Top__io_mem_resp_bits_data.values, mm->resp_data(), tile.Top__io_mem_resp_bits_data.width()/8);
 
-    tile.clock_lo(LIT<1>(0));
+    if (rewind)
+      log_inputs(tile, &rewind_log[(trace_count % rewind_cycles) * rewind_words], true);
+
+    try
+    {
+      tile.clock_lo(LIT<1>(0));
+    }
+    catch (std::runtime_error& e)
+    {
+      fprintf(stderr, "%s\n", e.what());
+      assert_failed = true;
+      break;
+    }
 
     mm->tick(
       tile.Top__io_mem_req_cmd_valid.lo_word(),
@@ -179,16 +244,70 @@ int main(int argc, char** argv)
     trace_count++;
   }
   
+  DRAMSim::MemoryStats dram_stats;
+  if (dramsim2)
+  {
+    dram_stats = static_cast<mm_dramsim2_t*>(mm)->stats();
+    tracer.set_dram_stats(&dram_stats);
+  }
   tracer.print();
+  if (dramsim2)
+  {
+    static_cast<mm_dramsim2_t*>(mm)->print_latency(stderr);
+    static_cast<mm_dramsim2_t*>(mm)->print_occupancy(stderr);
+  }
+
+  // Skip rates of the clock_lo partitions, for a model generated with
+  // --activityEval.
+  if (activity_stats)
+    tile.print_activity(stderr);
 
   if (vcd)
     fclose(vcdfile);
 
+  // On an assertion or idle error, roll back to the oldest snapshot and
+  // replay the logged inputs up to the failing cycle with VCD dumping on.
+  // The VCD is only populated by a model built with --vcd (emulator-debug).
+  uint64_t rewind_at;
+  if (rewind && (assert_failed || tile.Top_BoomTile_core_dpath__throw_idle_error.lo_word()) &&
+      rewind->restore(rewind->oldest(), &rewind_at))
+  {
+    FILE* rewind_file = fopen(rewind_vcd, "w");
+    assert(rewind_file);
+    fprintf(stderr, "rewinding to cycle %lld, replaying %lld cycles into %s\n",
+            (long long)rewind_at, (long long)(trace_count - rewind_at), rewind_vcd);
+    uint64_t rewind_end = assert_failed ? trace_count + 1 : trace_count;
+    for (uint64_t c = rewind_at; c < rewind_end; c++)
+    {
+      log_inputs(tile, &rewind_log[(c % rewind_cycles) * rewind_words], false);
+      try
+      {
+        tile.clock_lo(LIT<1>(0));
+      }
+      catch (std::runtime_error& e)
+      {
+        break;
+      }
+      if (c == rewind_at)
+        tile.dump_init(rewind_file);
+      else
+        tile.dump(rewind_file, c);
+      tile.clock_hi(LIT<1>(0));
+    }
+    fclose(rewind_file);
+  }
+  delete rewind;
+
   if (htif->exit_code())
   {
     fprintf(stderr, "*** FAILED *** (code = %d, seed %d) after %lld cycles\n", htif->exit_code(), random_seed, (long long)trace_count);
     ret = htif->exit_code();
   }
+  else if (assert_failed)
+  {
+    fprintf(stderr, "*** FAILED *** (assertion) after %lld cycles\n", (long long)trace_count);
+    ret = 5;
+  }
   else if (tile.Top_BoomTile_core_dpath__throw_idle_error.lo_word())
   {
     fprintf(stderr, "*** FAILED *** (pipeline idle error) after %lld cycles\n", (long long)trace_count);
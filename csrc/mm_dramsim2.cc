@@ -4,6 +4,7 @@
 #include <iostream>
 #include <fstream>
 #include <list>
+#include <algorithm>
 #include <queue>
 #include <cstring>
 #include <cstdlib>
@@ -13,31 +14,43 @@
 
 using namespace DRAMSim;
 
-void mm_dramsim2_t::read_complete(unsigned id, uint64_t address, uint64_t clock_cycle)
+void mm_dramsim2_t::read_complete(const TransactionCompletion& c)
 {
-  assert(req.count(address));
-  auto tag = req[address];
-  req.erase(address);
+  auto it = req.find(c.address);
+  assert(it != req.end());
+  auto tag = it->second;
+  req.erase(it);
 
-  for (int i = 0; i < line_size/word_size; i++)
-  {
-    auto base = data + address + i*word_size;
-    auto dat = std::vector<char>(base, base + word_size);
-    resp.push(std::make_pair(tag, dat));
-  }
+  auto base = data + c.address;
+  resp.push(std::make_pair(tag, std::vector<char>(base, base + line_size)));
 
 #ifdef DEBUG_DRAMSIM2
-  fprintf(stderr, "[Callback] read complete: id=%d , addr=0x%lx , cycle=%lu\n", id, address, clock_cycle);
+  fprintf(stderr, "[Completion] read complete: id=%d , addr=0x%lx , cycle=%lu\n", c.id, c.address, c.cycle);
 #endif
 }
 
-void mm_dramsim2_t::write_complete(unsigned id, uint64_t address, uint64_t clock_cycle)
+void mm_dramsim2_t::write_complete(const TransactionCompletion& c)
 {
 #ifdef DEBUG_DRAMSIM2
-  fprintf(stderr, "[Callback] write complete: id=%d , addr=0x%lx , cycle=%lu\n", id, address, clock_cycle);
+  fprintf(stderr, "[Completion] write complete: id=%d , addr=0x%lx , cycle=%lu\n", c.id, c.address, c.cycle);
 #endif
 }
 
+void mm_dramsim2_t::print_latency(FILE* f)
+{
+  DRAMSim::LatencyStats s = read_latency();
+  fprintf(f, "dramsim2 read latency: %llu reads, mean %.1f, p50 %llu, p90 %llu, p99 %llu, max %llu cycles\n",
+          (unsigned long long)s.count, s.mean, (unsigned long long)s.p50, (unsigned long long)s.p90,
+          (unsigned long long)s.p99, (unsigned long long)s.max);
+}
+
+void mm_dramsim2_t::print_occupancy(FILE* f)
+{
+  for (size_t c = 0; c < occupancy_sum.size(); c++)
+    fprintf(f, "dramsim2 channel %zu queue: mean %.1f, max %u transactions, %llu cycles full for a pending request\n",
+            c, cycle ? (double)occupancy_sum[c] / cycle : 0.0, occupancy_max[c], (unsigned long long)full_cycles[c]);
+}
+
 void power_callback(double a, double b, double c, double d)
 {
     //fprintf(stderr, "power callback: %0.3f, %0.3f, %0.3f, %0.3f\n",a,b,c,d);
@@ -53,9 +66,15 @@ void mm_dramsim2_t::init(size_t sz, int wsz, int lsz)
   assert(size % (1024*1024) == 0);
   mem = getMemorySystemInstance("DDR3_micron_64M_8B_x4_sg15.ini", "system.ini", "dramsim2_ini", "results", size/(1024*1024));
 
-  TransactionCompleteCB *read_cb = new Callback<mm_dramsim2_t, void, unsigned, uint64_t, uint64_t>(this, &mm_dramsim2_t::read_complete);
-  TransactionCompleteCB *write_cb = new Callback<mm_dramsim2_t, void, unsigned, uint64_t, uint64_t>(this, &mm_dramsim2_t::write_complete);
-  mem->RegisterCallbacks(read_cb, write_cb, power_callback);
+  mem->RegisterCallbacks(NULL, NULL, power_callback);
+  // a channel finishes at most a read and a write per cycle, but with
+  // PARALLEL_BATCH_CYCLES a whole batch of them comes out of one update()
+  completions.resize(4096);
+  mem->RegisterCompletionBuffer(&completions[0], completions.size());
+
+  occupancy_sum.resize(mem->getNumChannels());
+  occupancy_max.resize(mem->getNumChannels());
+  full_cycles.resize(mem->getNumChannels());
 
 #ifdef DEBUG_DRAMSIM2
   fprintf(stderr,"Dramsim2 init successful\n");
@@ -78,9 +97,18 @@ void mm_dramsim2_t::tick
   bool resp_fire = resp_valid() && resp_rdy;
   assert(!(req_cmd_fire && req_data_fire));
 
-  if (resp_fire)
+  if (resp_fire && ++resp_word == line_size/word_size)
+  {
     resp.pop();
+    resp_word = 0;
+  }
 
+  for (size_t c = 0; c < occupancy_sum.size(); c++)
+  {
+    unsigned occupancy = mem->getQueueOccupancy(c);
+    occupancy_sum[c] += occupancy;
+    occupancy_max[c] = std::max(occupancy_max[c], occupancy);
+  }
   if (req_cmd_fire)
   {
     // since the I$ can speculatively ask for address that are out of bounds
@@ -90,6 +118,7 @@ void mm_dramsim2_t::tick
     {
       store_inflight = 1;
       store_addr = byte_addr;
+      store_requestor = req_cmd_tag & requestor_mask;
 #ifdef DEBUG_DRAMSIM2
       fprintf(stderr, "Starting store transaction (addr=%lx ; tag=%ld ; cyc=%ld)\n", store_addr, req_cmd_tag, cycle);
 #endif
@@ -99,7 +128,10 @@ void mm_dramsim2_t::tick
       assert(!req.count(byte_addr));
       req[byte_addr] = req_cmd_tag;
 
-      mem->addTransaction(false, byte_addr);
+      held_val = true;
+      held_store = false;
+      held_addr = byte_addr;
+      held_requestor = req_cmd_tag & requestor_mask;
 #ifdef DEBUG_DRAMSIM2
       fprintf(stderr, "Adding load transaction (addr=%lx; cyc=%ld)\n", byte_addr, cycle);
 #endif
@@ -114,13 +146,38 @@ void mm_dramsim2_t::tick
     if (store_count == 0)
     { // last chunch of cache line arrived.
       store_inflight = 0;
-      mem->addTransaction(true, store_addr);
+      held_val = true;
+      held_store = true;
+      held_addr = store_addr;
+      held_requestor = store_requestor;
 #ifdef DEBUG_DRAMSIM2
       fprintf(stderr, "Adding store transaction (addr=%lx; cyc=%ld)\n", store_addr, cycle);
 #endif
     }
   }
 
+  if (held_val)
+  {
+    // addTransaction(bool, ...) would take it even with the channel full,
+    // letting the channel's queue grow past its depth
+    if (mem->willAcceptTransaction(held_store, held_addr, held_requestor))
+    {
+      bool added = mem->addTransaction(held_store, held_addr, held_requestor);
+      assert(added);
+      held_val = false;
+    }
+    else
+      full_cycles[mem->getChannel(held_addr)]++;
+  }
+
   mem->update();
+  size_t n = mem->takeCompletions();
+  for (size_t i = 0; i < n; i++)
+  {
+    if (completions[i].isWrite)
+      write_complete(completions[i]);
+    else
+      read_complete(completions[i]);
+  }
   cycle++;
 }
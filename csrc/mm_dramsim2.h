@@ -3,22 +3,30 @@
 
 #include "mm.h"
 #include <DRAMSim.h>
-#include <map>
+#include <unordered_map>
 #include <queue>
 #include <stdint.h>
+#include <stdio.h>
 
 class mm_dramsim2_t : public mm_t
 {
  public:
-  mm_dramsim2_t() : store_inflight(false), store_count(0) {}
+  // requestor_bits low bits of a request's tag name its requestor (the
+  // memory arbiter appends the client index there), for DRAMSim2's per
+  // requestor queue limits, priorities and statistics
+  mm_dramsim2_t(int requestor_bits = 0)
+    : cycle(0), requestor_mask((1ULL << requestor_bits) - 1), store_inflight(false), store_count(0), held_val(false), resp_word(0) {}
 
   virtual void init(size_t sz, int word_size, int line_size);
 
-  virtual bool req_cmd_ready() { return mem->willAcceptTransaction() && !store_inflight; }
-  virtual bool req_data_ready() { return mem->willAcceptTransaction() && store_inflight; }
+  // readiness is given before clock_lo computes this cycle's request, so it
+  // can't depend on the address; a request whose channel is full is held
+  // here instead, and the port stays busy until the channel takes it
+  virtual bool req_cmd_ready() { return !store_inflight && !held_val; }
+  virtual bool req_data_ready() { return store_inflight && !held_val; }
   virtual bool resp_valid() { return !resp.empty(); }
   virtual uint64_t resp_tag() { return resp_valid() ? resp.front().first : 0; }
-  virtual void* resp_data() { return resp_valid() ? &resp.front().second[0] : &dummy_data[0]; }
+  virtual void* resp_data() { return resp_valid() ? &resp.front().second[resp_word*word_size] : &dummy_data[0]; }
 
   virtual void tick
   (
@@ -31,21 +39,48 @@ class mm_dramsim2_t : public mm_t
     bool resp_rdy
   );
 
+  // read latency percentiles, in DRAM clock cycles
+  DRAMSim::LatencyStats read_latency(bool epoch_only = false) { return mem->getReadLatencyStats(epoch_only); }
+  // row buffer hits, queue depth, bank parallelism, bus utilization and
+  // per requestor reads, writes and latency
+  DRAMSim::MemoryStats stats() { return mem->getStats(); }
+  void print_latency(FILE* f);
+  // mean and peak transactions queued in each channel, and the cycles a
+  // request was held back because its channel was full
+  void print_occupancy(FILE* f);
 
  protected:
   DRAMSim::MultiChannelMemorySystem *mem;
   uint64_t cycle;
+  uint64_t requestor_mask;
 
   bool store_inflight;
   int store_count;
   uint64_t store_addr;
+  unsigned store_requestor;
   std::vector<char> dummy_data;
 
-  std::map<uint64_t,uint64_t> req;
+  // the request waiting for room in its channel
+  bool held_val;
+  bool held_store;
+  uint64_t held_addr;
+  unsigned held_requestor;
+
+  // per channel, sampled every cycle
+  std::vector<uint64_t> occupancy_sum;
+  std::vector<unsigned> occupancy_max;
+  std::vector<uint64_t> full_cycles;
+
+  std::unordered_map<uint64_t,uint64_t> req;
+  // whole lines, sent out a word at a time starting with word resp_word
   std::queue<std::pair<uint64_t, std::vector<char>>> resp;
+  int resp_word;
+
+  // filled by mem->update(), drained every tick
+  std::vector<DRAMSim::TransactionCompletion> completions;
 
-  void read_complete(unsigned id, uint64_t address, uint64_t clock_cycle);
-  void write_complete(unsigned id, uint64_t address, uint64_t clock_cycle);
+  void read_complete(const DRAMSim::TransactionCompletion& c);
+  void write_complete(const DRAMSim::TransactionCompletion& c);
 };
 
 #endif
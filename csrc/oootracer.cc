@@ -9,6 +9,7 @@ Tracer_t::Tracer_t(Top_t *_tile, FILE* log)
    tile = _tile;
    logfile  = log;
    paused   = 1;
+   dram_stats = NULL;
 }
 
 // Initializes and turns the tracer on. 
@@ -254,6 +255,27 @@ void Tracer_t::print()
    fprintf(logfile, "#        - DC Misses        : %lu (%2.3g %%)\n", trace_data.dc_miss, 100.0 * ((double) trace_data.dc_miss) / (trace_data.load_count + trace_data.store_count));
    uint64_t primary_misses = trace_data.dc_miss - trace_data.dc_secondary_miss;
 
+   // DRAMSim2 counts from the start of the run, not from start()
+   if (dram_stats)
+   {
+      const DRAMSim::RowBufferCounts& rb = dram_stats->rowBuffer;
+      uint64_t row_accesses = rb.hits + rb.misses + rb.conflicts;
+      fprintf(logfile, "#        - DRAM Row Hits    : %lu (%2.3g %%), %lu misses, %lu conflicts\n", rb.hits,
+                                          100.0 * ((double) rb.hits) / row_accesses, rb.misses, rb.conflicts);
+      fprintf(logfile, "#        - DRAM Queue Depth : %2.3g\n", dram_stats->averageQueueDepth);
+      fprintf(logfile, "#        - DRAM Bank Par.   : %2.3g\n", dram_stats->bankParallelism);
+      fprintf(logfile, "#        - DRAM Bus Util.   : %2.3g %%\n", 100.0 * dram_stats->busUtilization);
+      if (dram_stats->requestors.size() > 1)
+      {
+         for (size_t i = 0; i < dram_stats->requestors.size(); i++)
+         {
+            const DRAMSim::RequestorStats& r = dram_stats->requestors[i];
+            fprintf(logfile, "#        - DRAM Requestor %zu : %lu reads, %lu writes, %2.3g GB/s, read lat. mean %2.3g p99 %lu\n",
+                                          i, r.reads, r.writes, r.bandwidth, r.readLatency.mean, r.readLatency.p99);
+         }
+      }
+   }
+
    /* XXX Step 4. PRINT YOUR COUNTERS HERE */
    fprintf(logfile, "#         - Two Issue Slots Requested        :   %d\n", trace_data.two_issue_slots_counter);
    
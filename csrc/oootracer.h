@@ -10,6 +10,7 @@
 #include <stdio.h>
 #include "emulator.h" 
 #include "Top.h" 
+#include <MemoryStats.h>
        
 class Tracer_t {
 
@@ -20,6 +21,8 @@ class Tracer_t {
       void monitor_issue_window(Top_t *tile);
       void stop();
       void print();
+      // DRAMSim2 statistics to print with the cache misses (+dramsim runs)
+      void set_dram_stats(const DRAMSim::MemoryStats* stats) { dram_stats = stats; }
 
    private:
       Top_t*     tile;      // Device under test
@@ -59,5 +62,6 @@ class Tracer_t {
 
 
       FILE*      logfile;
+      const DRAMSim::MemoryStats* dram_stats;
 };
 
@@ -27,286 +27,225 @@
 *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *********************************************************************************/
+#include <sstream>
 #include "SystemConfiguration.h"
 #include "AddressMapping.h"
 
+using namespace std;
+
 namespace DRAMSim
 {
 
-void addressMapping(uint64_t physicalAddress, unsigned &newTransactionChan, unsigned &newTransactionRank, unsigned &newTransactionBank, unsigned &newTransactionRow, unsigned &newTransactionColumn)
+void addressMapping(const Config &config, uint64_t physicalAddress, unsigned &newTransactionChan, unsigned &newTransactionRank, unsigned &newTransactionBank, unsigned &newTransactionRow, unsigned &newTransactionColumn)
 {
-	uint64_t tempA, tempB;
-	unsigned transactionSize = (JEDEC_DATA_BUS_BITS/8)*BL; 
-	uint64_t transactionMask =  transactionSize - 1; //ex: (64 bit bus width) x (8 Burst Length) - 1 = 64 bytes - 1 = 63 = 0x3f mask
-	unsigned channelBitWidth = dramsim_log2(NUM_CHANS);
-	unsigned	rankBitWidth = dramsim_log2(NUM_RANKS);
-	unsigned	bankBitWidth = dramsim_log2(NUM_BANKS);
-	unsigned	rowBitWidth = dramsim_log2(NUM_ROWS);
-	unsigned	colBitWidth = dramsim_log2(NUM_COLS);
-	// this forces the alignment to the width of a single burst (64 bits = 8 bytes = 3 address bits for DDR parts)
-	unsigned	byteOffsetWidth = dramsim_log2((JEDEC_DATA_BUS_BITS/8));
+	uint64_t transactionMask = config.transactionSize - 1; //ex: (64 bit bus width) x (8 Burst Length) - 1 = 64 bytes - 1 = 63 = 0x3f mask
 	// Since we're assuming that a request is for BL*BUS_WIDTH, the bottom bits
 	// of this address *should* be all zeros if it's not, issue a warning
 
 	if ((physicalAddress & transactionMask) != 0)
 	{
-		DEBUG("WARNING: address 0x"<<std::hex<<physicalAddress<<std::dec<<" is not aligned to the request size of "<<transactionSize); 
+		DEBUG("WARNING: address 0x"<<std::hex<<physicalAddress<<std::dec<<" is not aligned to the request size of "<<config.transactionSize); 
 	}
 
-	// each burst will contain JEDEC_DATA_BUS_BITS/8 bytes of data, so the bottom bits (3 bits for a single channel DDR system) are
-	// 	thrown away before mapping the other bits
-	physicalAddress >>= byteOffsetWidth;
-
-	// The next thing we have to consider is that when a request is made for a
-	// we've taken into account the granulaity of a single burst by shifting 
-	// off the bottom 3 bits, but a transaction has to take into account the
-	// burst length (i.e. the requests will be aligned to cache line sizes which
-	// should be equal to transactionSize above). 
-	//
-	// Since the column address increments internally on bursts, the bottom n 
-	// bits of the column (colLow) have to be zero in order to account for the 
-	// total size of the transaction. These n bits should be shifted off the 
-	// address and also subtracted from the total column width. 
-	//
-	// I am having a hard time explaining the reasoning here, but it comes down
-	// this: for a 64 byte transaction, the bottom 6 bits of the address must be 
-	// zero. These zero bits must be made up of the byte offset (3 bits) and also
-	// from the bottom bits of the column 
-	// 
-	// For example: cowLowBits = log2(64bytes) - 3 bits = 3 bits 
-	unsigned colLowBitWidth = dramsim_log2(transactionSize) - byteOffsetWidth;
-
-	physicalAddress >>= colLowBitWidth;
-	unsigned colHighBitWidth = colBitWidth - colLowBitWidth; 
-	if (DEBUG_ADDR_MAP)
+	if (config.DEBUG_ADDR_MAP)
 	{
-		DEBUG("Bit widths: ch:"<<channelBitWidth<<" r:"<<rankBitWidth<<" b:"<<bankBitWidth
-				<<" row:"<<rowBitWidth<<" colLow:"<<colLowBitWidth
-				<< " colHigh:"<<colHighBitWidth<<" off:"<<byteOffsetWidth 
-				<< " Total:"<< (channelBitWidth + rankBitWidth + bankBitWidth + rowBitWidth + colLowBitWidth + colHighBitWidth + byteOffsetWidth));
+		DEBUG("Bit widths: ch:"<<config.channelBitWidth<<" r:"<<config.rankBitWidth<<" b:"<<config.bankBitWidth
+				<<" row:"<<config.rowBitWidth<<" colLow:"<<config.colLowBitWidth
+				<< " colHigh:"<<config.colHighBitWidth<<" off:"<<config.byteOffsetWidth 
+				<< " Total:"<< (config.channelBitWidth + config.rankBitWidth + config.bankBitWidth + config.rowBitWidth + config.colLowBitWidth + config.colHighBitWidth + config.byteOffsetWidth));
 	}
 
-	//perform various address mapping schemes
-	if (addressMappingScheme == Scheme1)
+	// the scheme was compiled into mask and shift steps by compileAddressMapping()
+	uint64_t fields[NUM_ADDRESS_FIELDS] = {0, 0, 0, 0, 0};
+	const vector<AddressMapExtract> &extracts = config.addressMapExtracts;
+	for (size_t i=0; i<extracts.size(); i++)
 	{
-		//chan:rank:row:col:bank
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> bankBitWidth;
-		tempB = physicalAddress << bankBitWidth;
-		newTransactionBank = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> colHighBitWidth;
-		tempB = physicalAddress << colHighBitWidth;
-		newTransactionColumn = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> rowBitWidth;
-		tempB = physicalAddress << rowBitWidth;
-		newTransactionRow = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> rankBitWidth;
-		tempB = physicalAddress << rankBitWidth;
-		newTransactionRank = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> channelBitWidth;
-		tempB = physicalAddress << channelBitWidth;
-		newTransactionChan = tempA ^ tempB;
-
+		fields[extracts[i].field] |= ((physicalAddress >> extracts[i].shift) & extracts[i].mask) << extracts[i].fieldShift;
 	}
-	else if (addressMappingScheme == Scheme2)
+	const vector<AddressMapHash> &hashes = config.addressMapHashes;
+	for (size_t i=0; i<hashes.size(); i++)
 	{
-		//chan:row:col:bank:rank
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> rankBitWidth;
-		tempB = physicalAddress << rankBitWidth;
-		newTransactionRank = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> bankBitWidth;
-		tempB = physicalAddress << bankBitWidth;
-		newTransactionBank = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> colHighBitWidth;
-		tempB = physicalAddress << colHighBitWidth;
-		newTransactionColumn = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> rowBitWidth;
-		tempB = physicalAddress << rowBitWidth;
-		newTransactionRow = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> channelBitWidth;
-		tempB = physicalAddress << channelBitWidth;
-		newTransactionChan = tempA ^ tempB;
-
+		fields[hashes[i].field] ^= (uint64_t)__builtin_parityll(physicalAddress & hashes[i].mask) << hashes[i].fieldBit;
 	}
-	else if (addressMappingScheme == Scheme3)
-	{
-		//chan:rank:bank:col:row
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> rowBitWidth;
-		tempB = physicalAddress << rowBitWidth;
-		newTransactionRow = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> colHighBitWidth;
-		tempB = physicalAddress << colHighBitWidth;
-		newTransactionColumn = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> bankBitWidth;
-		tempB = physicalAddress << bankBitWidth;
-		newTransactionBank = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> rankBitWidth;
-		tempB = physicalAddress << rankBitWidth;
-		newTransactionRank = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> channelBitWidth;
-		tempB = physicalAddress << channelBitWidth;
-		newTransactionChan = tempA ^ tempB;
+	newTransactionChan = fields[ChannelField];
+	newTransactionRank = fields[RankField];
+	newTransactionBank = fields[BankField];
+	newTransactionRow = fields[RowField];
+	newTransactionColumn = fields[ColumnField];
 
-	}
-	else if (addressMappingScheme == Scheme4)
+	if (config.DEBUG_ADDR_MAP)
 	{
-		//chan:rank:bank:row:col
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> colHighBitWidth;
-		tempB = physicalAddress << colHighBitWidth;
-		newTransactionColumn = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> rowBitWidth;
-		tempB = physicalAddress << rowBitWidth;
-		newTransactionRow = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> bankBitWidth;
-		tempB = physicalAddress << bankBitWidth;
-		newTransactionBank = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> rankBitWidth;
-		tempB = physicalAddress << rankBitWidth;
-		newTransactionRank = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> channelBitWidth;
-		tempB = physicalAddress << channelBitWidth;
-		newTransactionChan = tempA ^ tempB;
-
+		DEBUG("Mapped Ch="<<newTransactionChan<<" Rank="<<newTransactionRank
+				<<" Bank="<<newTransactionBank<<" Row="<<newTransactionRow
+				<<" Col="<<newTransactionColumn<<"\n"); 
 	}
-	else if (addressMappingScheme == Scheme5)
-	{
-		//chan:row:col:rank:bank
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> bankBitWidth;
-		tempB = physicalAddress << bankBitWidth;
-		newTransactionBank = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> rankBitWidth;
-		tempB = physicalAddress << rankBitWidth;
-		newTransactionRank = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> colHighBitWidth;
-		tempB = physicalAddress << colHighBitWidth;
-		newTransactionColumn = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> rowBitWidth;
-		tempB = physicalAddress << rowBitWidth;
-		newTransactionRow = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> channelBitWidth;
-		tempB = physicalAddress << channelBitWidth;
-		newTransactionChan = tempA ^ tempB;
 
+}
 
-	}
-	else if (addressMappingScheme == Scheme6)
+//the address bits of a custom field, e.g. "6-8,13"
+static vector<unsigned> parseBitList(const string &key, const string &list)
+{
+	vector<unsigned> bits;
+	istringstream in(list);
+	string item;
+	while (getline(in, item, ','))
 	{
-		//chan:row:bank:rank:col
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> colHighBitWidth;
-		tempB = physicalAddress << colHighBitWidth;
-		newTransactionColumn = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> rankBitWidth;
-		tempB = physicalAddress << rankBitWidth;
-		newTransactionRank = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> bankBitWidth;
-		tempB = physicalAddress << bankBitWidth;
-		newTransactionBank = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> rowBitWidth;
-		tempB = physicalAddress << rowBitWidth;
-		newTransactionRow = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> channelBitWidth;
-		tempB = physicalAddress << channelBitWidth;
-		newTransactionChan = tempA ^ tempB;
-
-
+		unsigned first, last;
+		char dash;
+		istringstream range(item);
+		if (!(range >> first))
+		{
+			ERROR("== Error - bad bit list '"<<list<<"' for "<<key);
+			exit(-1);
+		}
+		last = first;
+		if (range >> dash && (dash != '-' || !(range >> last) || last < first))
+		{
+			ERROR("== Error - bad bit range '"<<item<<"' for "<<key);
+			exit(-1);
+		}
+		for (unsigned bit=first; bit<=last; bit++)
+		{
+			bits.push_back(bit);
+		}
 	}
-	// clone of scheme 5, but channel moved to lower bits
-	else if (addressMappingScheme == Scheme7)
-	{
-		//row:col:rank:bank:chan
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> channelBitWidth;
-		tempB = physicalAddress << channelBitWidth;
-		newTransactionChan = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> bankBitWidth;
-		tempB = physicalAddress << bankBitWidth;
-		newTransactionBank = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> rankBitWidth;
-		tempB = physicalAddress << rankBitWidth;
-		newTransactionRank = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> colHighBitWidth;
-		tempB = physicalAddress << colHighBitWidth;
-		newTransactionColumn = tempA ^ tempB;
-
-		tempA = physicalAddress;
-		physicalAddress = physicalAddress >> rowBitWidth;
-		tempB = physicalAddress << rowBitWidth;
-		newTransactionRow = tempA ^ tempB;
+	return bits;
+}
 
+//the XOR masks of a custom field, one per field bit, e.g. "0x3000,0x6000"
+static vector<uint64_t> parseMaskList(const string &key, const string &list)
+{
+	vector<uint64_t> masks;
+	istringstream in(list);
+	string item;
+	while (getline(in, item, ','))
+	{
+		istringstream mask(item);
+		uint64_t value;
+		if (!(mask >> std::hex >> value))
+		{
+			ERROR("== Error - bad mask '"<<item<<"' for "<<key);
+			exit(-1);
+		}
+		masks.push_back(value);
 	}
+	return masks;
+}
 
-	else
+//takes bits[0] up as the bits of field from its lowest bit, merging runs of
+//consecutive address bits into a single extract
+static void addExtracts(Config &config, AddressField field, const vector<unsigned> &bits)
+{
+	for (size_t i=0; i<bits.size(); )
 	{
-		ERROR("== Error - Unknown Address Mapping Scheme");
-		exit(-1);
+		size_t run = 1;
+		while (i+run < bits.size() && bits[i+run] == bits[i]+run)
+		{
+			run++;
+		}
+		AddressMapExtract extract;
+		extract.mask = (run == 64) ? ~0ULL : (1ULL << run) - 1;
+		extract.shift = bits[i];
+		extract.fieldShift = i;
+		extract.field = field;
+		config.addressMapExtracts.push_back(extract);
+		i += run;
 	}
-	if (DEBUG_ADDR_MAP)
+}
+
+void compileAddressMapping(Config &config)
+{
+	// each burst will contain JEDEC_DATA_BUS_BITS/8 bytes of data, so the bottom bits (3 bits for a single channel DDR system) are
+	// 	thrown away before mapping the other bits
+	//
+	// Since the column address increments internally on bursts, the bottom n 
+	// bits of the column (colLow) have to be zero in order to account for the 
+	// total size of the transaction. These n bits are skipped as well and
+	// are not part of the column field.
+	//
+	// For example: for a 64 byte transaction, cowLowBits = log2(64bytes) - 3 bits = 3 bits 
+	unsigned firstBit = config.byteOffsetWidth + config.colLowBitWidth;
+	unsigned widths[NUM_ADDRESS_FIELDS];
+	widths[ChannelField] = config.channelBitWidth;
+	widths[RankField] = config.rankBitWidth;
+	widths[BankField] = config.bankBitWidth;
+	widths[RowField] = config.rowBitWidth;
+	widths[ColumnField] = config.colHighBitWidth;
+
+	config.addressMapExtracts.clear();
+	config.addressMapHashes.clear();
+
+	if (config.addressMappingScheme != CustomScheme)
 	{
-		DEBUG("Mapped Ch="<<newTransactionChan<<" Rank="<<newTransactionRank
-				<<" Bank="<<newTransactionBank<<" Row="<<newTransactionRow
-				<<" Col="<<newTransactionColumn<<"\n"); 
+		// the fields of each scheme from the lowest address bits up
+		static const AddressField order[CustomScheme][NUM_ADDRESS_FIELDS] =
+		{
+			{BankField, ColumnField, RowField, RankField, ChannelField}, //chan:rank:row:col:bank
+			{RankField, BankField, ColumnField, RowField, ChannelField}, //chan:row:col:bank:rank
+			{RowField, ColumnField, BankField, RankField, ChannelField}, //chan:rank:bank:col:row
+			{ColumnField, RowField, BankField, RankField, ChannelField}, //chan:rank:bank:row:col
+			{BankField, RankField, ColumnField, RowField, ChannelField}, //chan:row:col:rank:bank
+			{ColumnField, RankField, BankField, RowField, ChannelField}, //chan:row:bank:rank:col
+			{ChannelField, BankField, RankField, ColumnField, RowField}  //row:col:rank:bank:chan
+		};
+		unsigned shift = firstBit;
+		for (size_t i=0; i<NUM_ADDRESS_FIELDS; i++)
+		{
+			AddressField field = order[config.addressMappingScheme][i];
+			vector<unsigned> bits;
+			for (unsigned j=0; j<widths[field]; j++)
+			{
+				bits.push_back(shift++);
+			}
+			addExtracts(config, field, bits);
+		}
+		return;
 	}
 
+	const char *names[NUM_ADDRESS_FIELDS] = {"ADDR_MAP_CHANNEL", "ADDR_MAP_RANK", "ADDR_MAP_BANK", "ADDR_MAP_ROW", "ADDR_MAP_COL"};
+	const string *bitLists[NUM_ADDRESS_FIELDS] = {&config.ADDR_MAP_CHANNEL_BITS, &config.ADDR_MAP_RANK_BITS, &config.ADDR_MAP_BANK_BITS, &config.ADDR_MAP_ROW_BITS, &config.ADDR_MAP_COL_BITS};
+	const string *maskLists[NUM_ADDRESS_FIELDS] = {&config.ADDR_MAP_CHANNEL_XOR, &config.ADDR_MAP_RANK_XOR, &config.ADDR_MAP_BANK_XOR, &config.ADDR_MAP_ROW_XOR, &config.ADDR_MAP_COL_XOR};
+	uint64_t used = 0;
+	for (size_t i=0; i<NUM_ADDRESS_FIELDS; i++)
+	{
+		AddressField field = (AddressField)i;
+		string bitsKey = string(names[i]) + "_BITS";
+		string xorKey = string(names[i]) + "_XOR";
+		vector<unsigned> bits = parseBitList(bitsKey, *bitLists[i]);
+		if (bits.size() != widths[field])
+		{
+			ERROR("== Error - "<<bitsKey<<" has "<<bits.size()<<" bits, the field needs "<<widths[field]);
+			exit(-1);
+		}
+		for (size_t j=0; j<bits.size(); j++)
+		{
+			if (bits[j] < firstBit || bits[j] > 63 || (used & (1ULL << bits[j])))
+			{
+				ERROR("== Error - "<<bitsKey<<": address bit "<<bits[j]<<" is below bit "<<firstBit<<", above 63 or used twice");
+				exit(-1);
+			}
+			used |= 1ULL << bits[j];
+		}
+		addExtracts(config, field, bits);
+
+		vector<uint64_t> masks = parseMaskList(xorKey, *maskLists[i]);
+		if (masks.size() > widths[field])
+		{
+			ERROR("== Error - "<<xorKey<<" has more masks than the field's "<<widths[field]<<" bits");
+			exit(-1);
+		}
+		for (size_t j=0; j<masks.size(); j++)
+		{
+			if (masks[j] == 0)
+			{
+				continue;
+			}
+			AddressMapHash hash;
+			hash.mask = masks[j];
+			hash.fieldBit = j;
+			hash.field = field;
+			config.addressMapHashes.push_back(hash);
+		}
+	}
 }
 };
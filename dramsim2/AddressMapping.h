@@ -29,9 +29,13 @@
 *********************************************************************************/
 #ifndef ADDRESS_MAPPING_H
 #define ADDRESS_MAPPING_H
+#include "SystemConfiguration.h"
 namespace DRAMSim
 {
-	void addressMapping(uint64_t physicalAddress, unsigned &channel, unsigned &rank, unsigned &bank, unsigned &row, unsigned &col);
+	void addressMapping(const Config &config, uint64_t physicalAddress, unsigned &channel, unsigned &rank, unsigned &bank, unsigned &row, unsigned &col);
+	// builds config.addressMapExtracts/addressMapHashes for addressMapping(); call
+	// again whenever the address widths or mapping keys change
+	void compileAddressMapping(Config &config);
 }
 
 #endif
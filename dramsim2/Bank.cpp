@@ -42,64 +42,59 @@
 
 #include "Bank.h"
 #include "BusPacket.h"
+#include <cstring>
 
 using namespace std;
 using namespace DRAMSim;
 
-Bank::Bank():
-		rowEntries(NUM_COLS)
-{}
+Bank::Bank(const Config &config):
+		config(config)
+{
+	if (config.transactionSize > PAGE_SIZE)
+	{
+		ERROR("== Error - a transaction of "<<config.transactionSize<<" bytes doesn't fit in a "<<PAGE_SIZE<<" byte storage page");
+		exit(-1);
+	}
+}
 
 /* The bank class is just a glorified sparse storage data structure
  * that keeps track of written data in case the simulator wants a
  * function DRAM model
  *
- * A vector of size NUM_COLS keeps a linked list of rows and their
- * associated values.
+ * The bank is laid out row by row, one transaction per column, and
+ * split into PAGE_SIZE byte pages that are kept in a hash map and only
+ * allocated when something is first written to them.
  *
- * write() adds an entry to the proper linked list or replaces the
- * 	value in a row that was already written
+ * write() copies the data of a transaction into its page
  *
- * read() searches for a node with the right row value, if not found
- * 	returns the tracer value 0xDEADBEEF
- * 
- *	TODO: if anyone wants to actually store data, this should be changed to an STL unordered_map 
+ * read() points the packet at the data in the page, or at a shared
+ * 	page of zeros if nothing was ever written there. The data is only
+ * 	valid until the next write to the same place and must not be
+ * 	written through.
  */
 
+static const unsigned char zeroPage[Bank::PAGE_SIZE] = {0};
 
-
-Bank::DataStruct *Bank::searchForRow(unsigned row, DataStruct *head)
+//where the transaction of a packet starts within the bank
+uint64_t Bank::byteOffset(const BusPacket *busPacket) const
 {
-	while (head != NULL)
-	{
-		if (head->row == row)
-		{
-			//found it
-			return head;
-		}
-		//keep looking
-		head = head->next;
-	}
-	//if we get here, didn't find it
-	return NULL;
+	uint64_t transactionIndex = ((uint64_t)busPacket->row << config.colHighBitWidth) | busPacket->column;
+	return transactionIndex * config.transactionSize;
 }
 
 void Bank::read(BusPacket *busPacket)
 {
-	DataStruct *rowHeadNode = rowEntries[busPacket->column];
-	DataStruct *foundNode = NULL;
+	uint64_t offset = byteOffset(busPacket);
+	unordered_map<uint64_t, vector<unsigned char> >::iterator page = pages.find(offset / PAGE_SIZE);
 
-	if ((foundNode = Bank::searchForRow(busPacket->row, rowHeadNode)) == NULL)
+	if (page == pages.end())
 	{
-		// the row hasn't been written before, so it isn't in the list
-		//if(SHOW_SIM_OUTPUT) DEBUG("== Warning - Read from previously unwritten row " << busPacket->row);
-		void *garbage = calloc(BL * (JEDEC_DATA_BUS_BITS/8),1);
-		((long *)garbage)[0] = 0xdeadbeef; // tracer value
-		busPacket->data = garbage;
+		// nothing has been written to this page, so it reads as zeros
+		busPacket->data = (void *)zeroPage;
 	}
 	else // found it
 	{
-		busPacket->data = foundNode->data;
+		busPacket->data = &page->second[offset % PAGE_SIZE];
 	}
 
 	//the return packet should be a data packet, not a read packet
@@ -112,38 +107,31 @@ void Bank::write(const BusPacket *busPacket)
 	//TODO: move all the error checking to BusPacket so once we have a bus packet,
 	//			we know the fields are all legal
 
-	if (busPacket->column >= NUM_COLS)
+	if (busPacket->column >= config.NUM_COLS)
 	{
 		ERROR("== Error - Bus Packet column "<< busPacket->column <<" out of bounds");
 		exit(-1);
 	}
 
-	// head of the list we need to search
-	DataStruct *rowHeadNode = rowEntries[busPacket->column];
-	DataStruct *foundNode = NULL;
+	// a write without data (e.g. from the library interface) has nothing to store
+	if (busPacket->data == NULL)
+	{
+		return;
+	}
 
-	if ((foundNode = Bank::searchForRow(busPacket->row, rowHeadNode)) == NULL)
+	uint64_t offset = byteOffset(busPacket);
+	vector<unsigned char> &page = pages[offset / PAGE_SIZE];
+	if (page.empty())
 	{
-		//not found
-		DataStruct *newRowNode = (DataStruct *)malloc(sizeof(DataStruct));
-
-		//insert at the head for speed
-		//TODO: Optimize this data structure for speedier lookups?
-		newRowNode->row = busPacket->row;
-		newRowNode->data = busPacket->data;
-		newRowNode->next = rowHeadNode;
-		rowEntries[busPacket->column] = newRowNode;
+		page.resize(PAGE_SIZE, 0);
 	}
-	else
+	memcpy(&page[offset % PAGE_SIZE], busPacket->data, config.transactionSize);
+
+	if (config.DEBUG_BANKS)
 	{
-		// found it, just plaster in the new data
-		foundNode->data = busPacket->data;
-		if (DEBUG_BANKS)
-		{
-			PRINTN(" -- Bank "<<busPacket->bank<<" writing to physical address 0x" << hex << busPacket->physicalAddress<<dec<<":");
-			BusPacket::printData(busPacket->data);
-			PRINT("");
-		}
+		PRINTN(" -- Bank "<<busPacket->bank<<" writing to physical address 0x" << hex << busPacket->physicalAddress<<dec<<":");
+		BusPacket::printData(busPacket->data);
+		PRINT("");
 	}
 }
 
@@ -47,22 +47,22 @@
 #include "SimulatorObject.h"
 #include "BankState.h"
 #include "BusPacket.h"
+#include <unordered_map>
 
 namespace DRAMSim
 {
 class Bank
 {
-	typedef struct _DataStruct
-	{
-		unsigned row;
-		void *data;
-		struct _DataStruct *next;
-	} DataStruct;
-
 public:
+	//bytes of data kept together, allocated when first written
+	static const size_t PAGE_SIZE = 4096;
+
 	//functions
-	Bank();
+	Bank(const Config &config);
+	//points busPacket->data at the stored bytes, which stay the bank's
 	void read(BusPacket *busPacket);
+	//copies transactionSize bytes from busPacket->data; the bank doesn't
+	//take the buffer, the rank frees it afterwards
 	void write(const BusPacket *busPacket);
 
 	//fields
@@ -70,9 +70,11 @@ public:
 
 private:
 	// private member
-	std::vector<DataStruct *> rowEntries;
+	const Config &config;
+	//pages of written data, by (row, column) byte offset / PAGE_SIZE
+	std::unordered_map<uint64_t, std::vector<unsigned char> > pages;
 
-	static DataStruct *searchForRow(unsigned row, DataStruct *head);
+	uint64_t byteOffset(const BusPacket *busPacket) const;
 };
 }
 
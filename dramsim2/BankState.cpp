@@ -55,7 +55,7 @@ BankState::BankState():
 		nextPrecharge(0),
 		nextPowerUp(0),
 		lastCommand(READ),
-		stateChangeCountdown(0)
+		stateChangeCycle(0)
 {}
 
 void BankState::print()
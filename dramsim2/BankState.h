@@ -70,7 +70,7 @@ public:
 	uint64_t nextPowerUp;
 
 	BusPacketType lastCommand;
-	unsigned stateChangeCountdown;
+	uint64_t stateChangeCycle; //when lastCommand's implicit state change is due, 0 if none
 
 	//Functions
 	BankState();
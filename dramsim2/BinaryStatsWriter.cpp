@@ -0,0 +1,137 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+
+
+
+
+
+//BinaryStatsWriter.cpp
+//
+//Class file for the columnar binary epoch statistics writer
+//
+
+#include <iostream>
+#include <stdlib.h>
+#include "BinaryStatsWriter.h"
+#include "PrintMacros.h"
+
+using namespace DRAMSim;
+using namespace std;
+
+const char BinaryStatsWriter::MAGIC[8] = {'D','R','A','M','V','I','S','B'};
+
+BinaryStatsWriter::BinaryStatsWriter() : out(NULL), headerWritten(false)
+{
+}
+
+BinaryStatsWriter::~BinaryStatsWriter()
+{
+	close();
+}
+
+unsigned BinaryStatsWriter::addColumn(const string &name)
+{
+	if (headerWritten)
+	{
+		ERROR("Cannot add the column '"<<name<<"' once rows have been written");
+		exit(-1);
+	}
+	names.push_back(name);
+	row.push_back(0.0);
+	return names.size()-1;
+}
+
+bool BinaryStatsWriter::open(const string &path)
+{
+	close();
+	out = fopen(path.c_str(), "wb");
+	return out != NULL;
+}
+
+void BinaryStatsWriter::writeHeader()
+{
+	string nameBlock;
+	for (size_t i=0; i<names.size(); i++)
+	{
+		nameBlock += names[i];
+		nameBlock += '\0';
+	}
+	// keeps the rows 8 byte aligned for readers that map the file
+	while ((sizeof(MAGIC) + 3*sizeof(uint32_t) + nameBlock.size()) % sizeof(double) != 0)
+	{
+		nameBlock += '\0';
+	}
+	uint32_t fields[3] = {VERSION, (uint32_t)names.size(), (uint32_t)nameBlock.size()};
+	fwrite(MAGIC, sizeof(MAGIC), 1, out);
+	fwrite(fields, sizeof(fields), 1, out);
+	fwrite(nameBlock.data(), 1, nameBlock.size(), out);
+	headerWritten = true;
+}
+
+// writes out the values set since the last row; unset columns repeat
+void BinaryStatsWriter::writeRow()
+{
+	if (out == NULL)
+	{
+		return;
+	}
+	if (!headerWritten)
+	{
+		writeHeader();
+	}
+	if (row.size() > 0 && fwrite(&row[0], sizeof(double), row.size(), out) != row.size())
+	{
+		ERROR("Cannot write the epoch statistics");
+		exit(-1);
+	}
+}
+
+void BinaryStatsWriter::flush()
+{
+	if (out != NULL)
+	{
+		fflush(out);
+	}
+}
+
+void BinaryStatsWriter::close()
+{
+	if (out != NULL)
+	{
+		if (!headerWritten)
+		{
+			writeHeader();
+		}
+		fclose(out);
+		out = NULL;
+	}
+}
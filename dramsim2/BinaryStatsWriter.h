@@ -0,0 +1,96 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+
+
+
+
+
+#ifndef BINARYSTATSWRITER_H
+#define BINARYSTATSWRITER_H
+
+//BinaryStatsWriter.h
+//
+//Header file for the columnar binary epoch statistics writer
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace DRAMSim
+{
+// Writes the epoch statistics as fixed width rows of doubles, the binary
+// counterpart of the CSVWriter output (VIS_FILE_FORMAT=binary). The columns
+// are named once, before the first row, so an epoch only stores its values
+// and writes them out in one go. visb2csv.py converts the file to CSV or
+// loads it into numpy/pandas.
+//
+// File layout (native byte order):
+//   char     magic[8]       "DRAMVISB"
+//   uint32_t version        1
+//   uint32_t numColumns
+//   uint32_t namesLength    bytes of column names, each NUL terminated,
+//                           then NULs until the header (the 20 bytes
+//                           above plus the names) is a multiple of 8
+//   char     names[namesLength]
+//   double   rows[][numColumns]
+class BinaryStatsWriter
+{
+public:
+	BinaryStatsWriter();
+	~BinaryStatsWriter();
+
+	// only until the first row is written; returns the column's index
+	unsigned addColumn(const std::string &name);
+	unsigned numColumns() { return names.size(); }
+	bool open(const std::string &path);
+	bool isOpen() { return out != NULL; }
+	void set(unsigned column, double value) { row[column] = value; }
+	void writeRow();
+	void flush();
+	void close();
+
+	static const char MAGIC[8];
+	static const uint32_t VERSION = 1;
+
+private:
+	void writeHeader();
+
+	FILE *out;
+	bool headerWritten;
+	std::vector<std::string> names;
+	std::vector<double> row;
+};
+}
+
+#endif
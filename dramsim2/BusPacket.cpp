@@ -54,48 +54,96 @@ BusPacket::BusPacket(BusPacketType packtype, uint64_t physicalAddr, unsigned col
 	bank = b;
 	column = col;
 	row = rw;
+	prev = NULL;
+	next = NULL;
+	rowHitPrev = NULL;
+	rowHitNext = NULL;
+	inRowHitQueue = false;
+	sequence = 0;
 }
 
-BusPacket::BusPacket() {}
-void BusPacket::print(uint64_t currentClockCycle, bool dataStart)
+BusPacket::BusPacket() : prev(NULL), next(NULL), rowHitPrev(NULL), rowHitNext(NULL), inRowHitQueue(false), sequence(0) {}
+
+//number of packets carved out of each slab
+#define PACKETS_PER_SLAB 256
+
+BusPacketPool::BusPacketPool() : freeList(NULL) {}
+
+BusPacketPool::~BusPacketPool()
+{
+	for (size_t i=0; i<slabs.size(); i++)
+	{
+		delete [] slabs[i];
+	}
+}
+
+//adds a slab of packets to the free list
+void BusPacketPool::grow()
+{
+	BusPacket *slab = new BusPacket[PACKETS_PER_SLAB];
+	slabs.push_back(slab);
+	for (size_t i=0; i<PACKETS_PER_SLAB; i++)
+	{
+		slab[i].next = freeList;
+		freeList = &slab[i];
+	}
+}
+
+BusPacket *BusPacketPool::allocate(BusPacketType packtype, uint64_t physicalAddr, unsigned col, unsigned rw, unsigned r, unsigned b, void *dat)
+{
+	if (freeList == NULL)
+	{
+		grow();
+	}
+	BusPacket *packet = freeList;
+	freeList = packet->next;
+	*packet = BusPacket(packtype, physicalAddr, col, rw, r, b, dat);
+	return packet;
+}
+
+void BusPacketPool::release(BusPacket *packet)
+{
+	packet->prev = NULL;
+	packet->next = freeList;
+	freeList = packet;
+}
+void BusPacket::print(ostream &out, uint64_t currentClockCycle, bool dataStart)
 {
 	if (this == NULL)
 	{
 		return;
 	}
 
-	if (VERIFICATION_OUTPUT)
+	// only called when VERIFICATION_OUTPUT is set
+	switch (busPacketType)
 	{
-		switch (busPacketType)
-		{
-		case READ:
-			cmd_verify_out << currentClockCycle << ": read ("<<rank<<","<<bank<<","<<column<<",0);"<<endl;
-			break;
-		case READ_P:
-			cmd_verify_out << currentClockCycle << ": read ("<<rank<<","<<bank<<","<<column<<",1);"<<endl;
-			break;
-		case WRITE:
-			cmd_verify_out << currentClockCycle << ": write ("<<rank<<","<<bank<<","<<column<<",0 , 0, 'h0);"<<endl;
-			break;
-		case WRITE_P:
-			cmd_verify_out << currentClockCycle << ": write ("<<rank<<","<<bank<<","<<column<<",1, 0, 'h0);"<<endl;
-			break;
-		case ACTIVATE:
-			cmd_verify_out << currentClockCycle <<": activate (" << rank << "," << bank << "," << row <<");"<<endl;
-			break;
-		case PRECHARGE:
-			cmd_verify_out << currentClockCycle <<": precharge (" << rank << "," << bank << "," << row <<");"<<endl;
-			break;
-		case REFRESH:
-			cmd_verify_out << currentClockCycle <<": refresh (" << rank << ");"<<endl;
-			break;
-		case DATA:
-			//TODO: data verification?
-			break;
-		default:
-			ERROR("Trying to print unknown kind of bus packet");
-			exit(-1);
-		}
+	case READ:
+		out << currentClockCycle << ": read ("<<rank<<","<<bank<<","<<column<<",0);"<<endl;
+		break;
+	case READ_P:
+		out << currentClockCycle << ": read ("<<rank<<","<<bank<<","<<column<<",1);"<<endl;
+		break;
+	case WRITE:
+		out << currentClockCycle << ": write ("<<rank<<","<<bank<<","<<column<<",0 , 0, 'h0);"<<endl;
+		break;
+	case WRITE_P:
+		out << currentClockCycle << ": write ("<<rank<<","<<bank<<","<<column<<",1, 0, 'h0);"<<endl;
+		break;
+	case ACTIVATE:
+		out << currentClockCycle <<": activate (" << rank << "," << bank << "," << row <<");"<<endl;
+		break;
+	case PRECHARGE:
+		out << currentClockCycle <<": precharge (" << rank << "," << bank << "," << row <<");"<<endl;
+		break;
+	case REFRESH:
+		out << currentClockCycle <<": refresh (" << rank << ");"<<endl;
+		break;
+	case DATA:
+		//TODO: data verification?
+		break;
+	default:
+		ERROR("Trying to print unknown kind of bus packet");
+		exit(-1);
 	}
 }
 void BusPacket::print()
@@ -63,15 +63,102 @@ public:
 	uint64_t physicalAddress;
 	void *data;
 
+	//links of the BusPacketQueue this packet is in
+	BusPacket *prev;
+	BusPacket *next;
+
+	//links of the RowHitQueue this packet is in (see CommandQueue)
+	BusPacket *rowHitPrev;
+	BusPacket *rowHitNext;
+	bool inRowHitQueue;
+
+	//order in which the command queue received the packet
+	uint64_t sequence;
+
 	//Functions
 	BusPacket(BusPacketType packtype, uint64_t physicalAddr, unsigned col, unsigned rw, unsigned r, unsigned b, void *dat);
 	BusPacket();
 
 	void print();
-	void print(uint64_t currentClockCycle, bool dataStart);
+	void print(std::ostream &out, uint64_t currentClockCycle, bool dataStart);
 	static void printData(const void *data);
 
 };
+
+//FIFO of bus packets linked through a pair of the packets' own link fields,
+//so a packet can be removed from anywhere in the queue in constant time and
+//queueing never allocates. A packet can only be in one queue per pair of
+//links at a time.
+template <BusPacket *BusPacket::*Prev, BusPacket *BusPacket::*Next>
+class BusPacketList
+{
+public:
+	BusPacketList() : head(NULL), tail(NULL), count(0) {}
+
+	BusPacket *front() const { return head; }
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+
+	void push_back(BusPacket *packet)
+	{
+		packet->*Prev = tail;
+		packet->*Next = NULL;
+		if (tail) tail->*Next = packet; else head = packet;
+		tail = packet;
+		count++;
+	}
+
+	//puts packet in front of position, which is in the list
+	void insert(BusPacket *position, BusPacket *packet)
+	{
+		packet->*Prev = position->*Prev;
+		packet->*Next = position;
+		if (position->*Prev) position->*Prev->*Next = packet; else head = packet;
+		position->*Prev = packet;
+		count++;
+	}
+
+	void erase(BusPacket *packet)
+	{
+		if (packet->*Prev) packet->*Prev->*Next = packet->*Next; else head = packet->*Next;
+		if (packet->*Next) packet->*Next->*Prev = packet->*Prev; else tail = packet->*Prev;
+		packet->*Prev = packet->*Next = NULL;
+		count--;
+	}
+
+private:
+	BusPacket *head;
+	BusPacket *tail;
+	size_t count;
+};
+
+typedef BusPacketList<&BusPacket::prev, &BusPacket::next> BusPacketQueue;
+typedef BusPacketList<&BusPacket::rowHitPrev, &BusPacket::rowHitNext> RowHitQueue;
+
+//Free-list allocator for the bus packets of one memory system. Packets are
+//carved out of slabs that are only given back when the pool is destroyed;
+//released packets are chained through their next field and handed out again
+//first, so once the slabs cover the packets in flight no more heap
+//allocation happens per command.
+class BusPacketPool
+{
+public:
+	BusPacketPool();
+	~BusPacketPool();
+
+	BusPacket *allocate(BusPacketType packtype, uint64_t physicalAddr, unsigned col, unsigned rw, unsigned r, unsigned b, void *dat);
+	void release(BusPacket *packet);
+	size_t numSlabs() const { return slabs.size(); }
+
+private:
+	//not copyable, the slabs are owned by exactly one pool
+	BusPacketPool(const BusPacketPool &);
+	BusPacketPool &operator=(const BusPacketPool &);
+	void grow();
+
+	std::vector<BusPacket *> slabs;
+	BusPacket *freeList;
+};
 }
 
 #endif
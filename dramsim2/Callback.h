@@ -79,6 +79,16 @@ private:
 };
 
 typedef CallbackBase <void, unsigned, uint64_t, uint64_t> TransactionCompleteCB;
+
+// a finished transaction, as put in the caller's array by the pull
+// alternative to the callbacks (MultiChannelMemorySystem::RegisterCompletionBuffer)
+struct TransactionCompletion
+{
+	unsigned id; // the channel, as passed to the callbacks
+	bool isWrite;
+	uint64_t address;
+	uint64_t cycle;
+};
 } // namespace DRAMSim
 
 #endif
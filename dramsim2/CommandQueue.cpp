@@ -45,14 +45,27 @@
 
 using namespace DRAMSim;
 
-CommandQueue::CommandQueue(vector< vector<BankState> > &states) :
+static bool isReadAccess(BusPacket *packet)
+{
+	return packet && (packet->busPacketType == READ || packet->busPacketType == READ_P);
+}
+
+CommandQueue::CommandQueue(vector< vector<BankState> > &states, BusPacketPool &pool, const Config &config) :
 		bankStates(states),
+		config(config),
+		busPacketPool(pool),
 		nextBank(0),
 		nextRank(0),
 		nextBankPRE(0),
 		nextRankPRE(0),
 		refreshRank(0),
 		refreshWaiting(false),
+		refreshBanksBegin(0),
+		refreshBanksEnd(0),
+		refreshOverdue(false),
+		numBusyBanks(0),
+		numQueuedAccesses(0),
+		nextSequence(0),
 		sendAct(true)
 {
 	//set here to avoid compile errors
@@ -60,13 +73,13 @@ CommandQueue::CommandQueue(vector< vector<BankState> > &states) :
 
 	//use numBankQueus below to create queue structure
 	size_t numBankQueues;
-	if (queuingStructure==PerRank)
+	if (config.queuingStructure==PerRank)
 	{
 		numBankQueues = 1;
 	}
-	else if (queuingStructure==PerRankPerBank)
+	else if (config.queuingStructure==PerRankPerBank)
 	{
-		numBankQueues = NUM_BANKS;
+		numBankQueues = config.NUM_BANKS;
 	}
 	else
 	{
@@ -75,53 +88,55 @@ CommandQueue::CommandQueue(vector< vector<BankState> > &states) :
 	}
 
 	//vector of counters used to ensure rows don't stay open too long
-	rowAccessCounters = vector< vector<unsigned> >(NUM_RANKS, vector<unsigned>(NUM_BANKS,0));
+	rowAccessCounters = vector< vector<unsigned> >(config.NUM_RANKS, vector<unsigned>(config.NUM_BANKS,0));
+
+	//row hit index, see indexOpenRow()
+	indexedRows = vector< vector<unsigned> >(config.NUM_RANKS, vector<unsigned>(config.NUM_BANKS,0));
+	rowHits = vector< vector<RowHitQueue> >(config.NUM_RANKS, vector<RowHitQueue>(config.NUM_BANKS));
+	queuedColumnAccesses = vector< vector<unsigned> >(config.NUM_RANKS, vector<unsigned>(config.NUM_BANKS,0));
+	queuedReads = vector< vector<unsigned> >(config.NUM_RANKS, vector<unsigned>(config.NUM_BANKS,0));
+
+	RowBufferCounts noCounts = {0, 0, 0};
+	rowBufferCounts = vector< vector<RowBufferCounts> >(config.NUM_RANKS, vector<RowBufferCounts>(config.NUM_BANKS, noCounts));
+	prechargeSequences = vector< vector<uint64_t> >(config.NUM_RANKS, vector<uint64_t>(config.NUM_BANKS,0));
+	prechargedRows = vector< vector<unsigned> >(config.NUM_RANKS, vector<unsigned>(config.NUM_BANKS,-1));
+	pendingRowAccess = vector< vector<RowAccess> >(config.NUM_RANKS, vector<RowAccess>(config.NUM_BANKS, RowHit));
+
+	//the adaptive row buffer policy starts each bank at the cost of closing a
+	//	row too early (an activate and a precharge), unless a timeout is given
+	lastRowAccess = vector< vector<uint64_t> >(config.NUM_RANKS, vector<uint64_t>(config.NUM_BANKS,0));
+	unsigned timeout = config.ROW_IDLE_TIMEOUT > 0 ? config.ROW_IDLE_TIMEOUT : config.tRCD + config.tRP;
+	rowIdleTimeout = vector< vector<unsigned> >(config.NUM_RANKS, vector<unsigned>(config.NUM_BANKS,timeout));
+	timedOutRows = vector< vector<unsigned> >(config.NUM_RANKS, vector<unsigned>(config.NUM_BANKS,-1));
 
 	//create queue based on the structure we want
-	BusPacket1D actualQueue;
-	BusPacket2D perBankQueue = BusPacket2D();
-	queues = BusPacket3D();
-	for (size_t rank=0; rank<NUM_RANKS; rank++)
-	{
-		//this loop will run only once for per-rank and NUM_BANKS times for per-rank-per-bank
-		for (size_t bank=0; bank<numBankQueues; bank++)
-		{
-			actualQueue	= BusPacket1D();
-			perBankQueue.push_back(actualQueue);
-		}
-		queues.push_back(perBankQueue);
-	}
+	//	one queue per rank for per-rank and NUM_BANKS for per-rank-per-bank
+	queues = BusPacketQueue2D(config.NUM_RANKS, BusPacketQueue1D(numBankQueues));
 
 
 	//FOUR-bank activation window
 	//	this will count the number of activations within a given window
-	//	(decrementing counter)
 	//
-	//countdown vector will have decrementing counters starting at tFAW
-	//  when the 0th element reaches 0, remove it
-	tFAWCountdown.reserve(NUM_RANKS);
-	for (size_t i=0;i<NUM_RANKS;i++)
-	{
-		//init the empty vectors here so we don't seg fault later
-		tFAWCountdown.push_back(vector<unsigned>());
-	}
+	//each rank keeps a ring of the cycles at which its last activations
+	//	expire; since at most four can be in the window, the ring never grows
+	ActivateWindow emptyWindow;
+	emptyWindow.head = 0;
+	emptyWindow.count = 0;
+	tFAWWindows = vector<ActivateWindow>(config.NUM_RANKS, emptyWindow);
 }
 CommandQueue::~CommandQueue()
 {
 	//ERROR("COMMAND QUEUE destructor");
-	size_t bankMax = NUM_RANKS;
-	if (queuingStructure == PerRank) {
-		bankMax = 1; 
-	}
-	for (size_t r=0; r< NUM_RANKS; r++)
+	for (size_t r=0; r< queues.size(); r++)
 	{
-		for (size_t b=0; b<bankMax; b++) 
+		for (size_t b=0; b<queues[r].size(); b++) 
 		{
-			for (size_t i=0; i<queues[r][b].size(); i++)
+			while (!queues[r][b].empty())
 			{
-				delete(queues[r][b][i]);
+				BusPacket *packet = queues[r][b].front();
+				removePacket(queues[r][b], packet);
+				busPacketPool.release(packet);
 			}
-			queues[r][b].clear();
 		}
 	}
 }
@@ -130,20 +145,41 @@ void CommandQueue::enqueue(BusPacket *newBusPacket)
 {
 	unsigned rank = newBusPacket->rank;
 	unsigned bank = newBusPacket->bank;
-	if (queuingStructure==PerRank)
+
+	newBusPacket->sequence = nextSequence++;
+	if (newBusPacket->busPacketType != ACTIVATE)
+	{
+		tuneRowIdleTimeout(newBusPacket);
+		if (queuedColumnAccesses[rank][bank]++ == 0)
+		{
+			numBusyBanks++;
+		}
+		numQueuedAccesses++;
+		if (isReadAccess(newBusPacket))
+		{
+			queuedReads[rank][bank]++;
+		}
+		if (newBusPacket->row == indexedRows[rank][bank])
+		{
+			rowHits[rank][bank].push_back(newBusPacket);
+			newBusPacket->inRowHitQueue = true;
+		}
+	}
+
+	if (config.queuingStructure==PerRank)
 	{
 		queues[rank][0].push_back(newBusPacket);
-		if (queues[rank][0].size()>CMD_QUEUE_DEPTH)
+		if (queues[rank][0].size()>config.CMD_QUEUE_DEPTH)
 		{
 			ERROR("== Error - Enqueued more than allowed in command queue");
 			ERROR("						Need to call .hasRoomFor(int numberToEnqueue, unsigned rank, unsigned bank) first");
 			exit(0);
 		}
 	}
-	else if (queuingStructure==PerRankPerBank)
+	else if (config.queuingStructure==PerRankPerBank)
 	{
 		queues[rank][bank].push_back(newBusPacket);
-		if (queues[rank][bank].size()>CMD_QUEUE_DEPTH)
+		if (queues[rank][bank].size()>config.CMD_QUEUE_DEPTH)
 		{
 			ERROR("== Error - Enqueued more than allowed in command queue");
 			ERROR("						Need to call .hasRoomFor(int numberToEnqueue, unsigned rank, unsigned bank) first");
@@ -165,19 +201,16 @@ bool CommandQueue::pop(BusPacket **busPacket)
 	//	figures out the sliding window requirement for tFAW
 	//
 	//deal with tFAW book-keeping
-	//	each rank has it's own counter since the restriction is on a device level
-	for (size_t i=0;i<NUM_RANKS;i++)
+	//	each rank has it's own window since the restriction is on a device level
+	for (size_t i=0;i<config.NUM_RANKS;i++)
 	{
-		//decrement all the counters we have going
-		for (size_t j=0;j<tFAWCountdown[i].size();j++)
-		{
-			tFAWCountdown[i][j]--;
-		}
-
-		//the head will always be the smallest counter, so check if it has reached 0
-		if (tFAWCountdown[i].size()>0 && tFAWCountdown[i][0]==0)
+		//the head will always expire first, and at most one activation is
+		//	added per cycle, so at most one expires per cycle
+		ActivateWindow &window = tFAWWindows[i];
+		if (window.count>0 && window.expiry[window.head]<=currentClockCycle)
 		{
-			tFAWCountdown[i].erase(tFAWCountdown[i].begin());
+			window.head = (window.head + 1) % 4;
+			window.count--;
 		}
 	}
 
@@ -185,9 +218,9 @@ bool CommandQueue::pop(BusPacket **busPacket)
 	//Dequeue the correct item based on the structure and whether
 	//	or not we are using open or closed page
 	//
-	if (queuingStructure==PerRank)
+	if (config.queuingStructure==PerRank)
 	{
-		if (rowBufferPolicy==ClosePage)
+		if (config.rowBufferPolicy==ClosePage)
 		{
 			bool sendingREF = false;
 			//if the memory controller set the flags signaling that we need to issue a refresh
@@ -195,24 +228,37 @@ bool CommandQueue::pop(BusPacket **busPacket)
 			{
 				bool foundActiveOrTooEarly = false;
 				//look for an open bank
-				for (size_t i=0;i<NUM_BANKS;i++)
+				for (size_t i=refreshBanksBegin;i<refreshBanksEnd;i++)
 				{
 					//checks to make sure that all banks are idle
 					if (bankStates[refreshRank][i].currentBankState == RowActive)
 					{
 						foundActiveOrTooEarly = true;
+						//an overdue refresh doesn't wait for the access the row was opened
+						//	for (once that went, the row closes by itself)
+						if (refreshOverdue)
+						{
+							if (bankStates[refreshRank][i].lastCommand == ACTIVATE &&
+							        currentClockCycle >= bankStates[refreshRank][i].nextPrecharge)
+							{
+								*busPacket = prechargeRow(refreshRank, i);
+								sendingREF = true;
+							}
+							break;
+						}
 						//if a bank is open, make sure there are no commands pending that go to the
 						//  open row
-						for (size_t j=0;j<queues[refreshRank][0].size();j++)
+						BusPacketQueue &refreshQueue = queues[refreshRank][0];
+						for (BusPacket *packet = refreshQueue.front(); packet; packet = packet->next)
 						{
-							if (queues[refreshRank][0][j]->row == bankStates[refreshRank][i].openRowAddress &&
-							        queues[refreshRank][0][j]->bank == i)
+							if (packet->row == bankStates[refreshRank][i].openRowAddress &&
+							        packet->bank == i)
 							{
-								if (queues[refreshRank][0][j]->busPacketType != ACTIVATE &&
-								        isIssuable(queues[refreshRank][0][j]))
+								if (packet->busPacketType != ACTIVATE &&
+								        isIssuable(packet))
 								{
-									*busPacket = queues[refreshRank][0][j];
-									queues[refreshRank][0].erase(queues[refreshRank][0].begin()+j);
+									*busPacket = packet;
+									removePacket(refreshQueue, packet);
 									sendingREF = true;
 								}
 								break;
@@ -236,7 +282,7 @@ bool CommandQueue::pop(BusPacket **busPacket)
 				//	reset flags and rank pointer
 				if (!foundActiveOrTooEarly && bankStates[refreshRank][0].currentBankState != PowerDown)
 				{
-					*busPacket = new BusPacket(REFRESH, 0, 0, 0, refreshRank, 0, 0);
+					*busPacket = busPacketPool.allocate(REFRESH, 0, 0, 0, refreshRank, refreshBanksBegin, 0);
 					refreshRank = -1;
 					refreshWaiting = false;
 					sendingREF = true;
@@ -244,30 +290,34 @@ bool CommandQueue::pop(BusPacket **busPacket)
 			}
 
 			//if we're not sending a refresh
-			if (!sendingREF)
+			if (!sendingREF && firstReadyScheduling())
+			{
+				if (!popFirstReady(busPacket)) return false;
+			}
+			else if (!sendingREF)
 			{
 				bool foundIssuable = false;
 				unsigned startingRank = nextRank;
 				do
 				{
 					//make sure there is something in this queue first
-					//	also make sure a rank isn't waiting for a refresh
-					//	if a rank is waiting for a refesh, don't issue anything to it until the
-					//		refresh logic above has sent one out (ie, letting banks close)
-					if (!queues[nextRank][0].empty() && !((nextRank == refreshRank) && refreshWaiting))
+					//	if a rank is waiting for a refesh, don't issue anything to the banks it
+					//		is for until the refresh logic above has sent one out (ie, letting banks close)
+					if (!queues[nextRank][0].empty())
 					{
 						//search from beginning to find first issuable bus packet
-						for (size_t i=0;i<queues[nextRank][0].size();i++)
+						BusPacketQueue &queue = queues[nextRank][0];
+						for (BusPacket *packet = queue.front(); packet; packet = packet->next)
 						{
-							if (isIssuable(queues[nextRank][0][i]))
+							if (!refreshBlocks(packet->rank, packet->bank) && isIssuable(packet))
 							{
 								//check to make sure we aren't removing a read/write that is paired with an activate
-								if (i>0 && queues[nextRank][0][i-1]->busPacketType==ACTIVATE &&
-								        queues[nextRank][0][i-1]->physicalAddress == queues[nextRank][0][i]->physicalAddress)
+								if (packet->prev && packet->prev->busPacketType==ACTIVATE &&
+								        packet->prev->physicalAddress == packet->physicalAddress)
 									continue;
 
-								*busPacket = queues[nextRank][0][i];
-								queues[nextRank][0].erase(queues[nextRank][0].begin()+i);
+								*busPacket = packet;
+								removePacket(queue, packet);
 								foundIssuable = true;
 								break;
 							}
@@ -280,7 +330,7 @@ bool CommandQueue::pop(BusPacket **busPacket)
 
 					//rank round robin
 					nextRank++;
-					if (nextRank == NUM_RANKS)
+					if (nextRank == config.NUM_RANKS)
 					{
 						nextRank = 0;
 					}
@@ -292,14 +342,14 @@ bool CommandQueue::pop(BusPacket **busPacket)
 			}
 		}
 		//if we are open page, we will want to search the queues for shit going to same row
-		else if (rowBufferPolicy==OpenPage)
+		else if (config.rowBufferPolicy==OpenPage || config.rowBufferPolicy==AdaptivePage)
 		{
 			bool sendingREForPRE = false;
 			if (refreshWaiting)
 			{
 				bool sendREF = true;
 				//make sure we meet all the requirements to send a REF
-				for (size_t b=0;b<NUM_BANKS;b++)
+				for (size_t b=refreshBanksBegin;b<refreshBanksEnd;b++)
 				{
 					//if a bank is active we can't send a REF yet
 					if (bankStates[refreshRank][b].currentBankState == RowActive)
@@ -307,11 +357,10 @@ bool CommandQueue::pop(BusPacket **busPacket)
 						sendREF = false;
 						bool closeRow = true;
 						//search for commands going to an open row
-						vector <BusPacket *> &refreshQueue = queues[refreshRank][0];
+						BusPacketQueue &refreshQueue = queues[refreshRank][0];
 
-						for (size_t j=0;j<refreshQueue.size();j++)
+						for (BusPacket *packet = refreshQueue.front(); packet && !refreshOverdue; packet = packet->next)
 						{
-							BusPacket *packet = refreshQueue[j];
 							//if a command in the queue is going to the same row . . .
 							if (bankStates[refreshRank][b].openRowAddress == packet->row &&
 							        b == packet->bank)
@@ -325,7 +374,7 @@ bool CommandQueue::pop(BusPacket **busPacket)
 									{
 										//send it out
 										*busPacket = packet;
-										refreshQueue.erase(refreshQueue.begin()+j);
+										removePacket(refreshQueue, packet);
 										sendingREForPRE = true;
 									}
 									break;
@@ -340,8 +389,7 @@ bool CommandQueue::pop(BusPacket **busPacket)
 						//if the bank is open and we are allowed to close it, then send a PRE
 						if (closeRow && currentClockCycle >= bankStates[refreshRank][b].nextPrecharge)
 						{
-							rowAccessCounters[refreshRank][b]=0;
-							*busPacket = new BusPacket(PRECHARGE, 0, 0, 0, refreshRank, b, 0);
+							*busPacket = prechargeRow(refreshRank, b);
 							sendingREForPRE = true;
 						}
 						break;
@@ -360,34 +408,39 @@ bool CommandQueue::pop(BusPacket **busPacket)
 				//	reset flags and rank pointer
 				if (sendREF && bankStates[refreshRank][0].currentBankState != PowerDown)
 				{
-					*busPacket = new BusPacket(REFRESH, 0, 0, 0, refreshRank, 0, 0);
+					*busPacket = busPacketPool.allocate(REFRESH, 0, 0, 0, refreshRank, refreshBanksBegin, 0);
 					refreshRank = -1;
 					refreshWaiting = false;
 					sendingREForPRE = true;
 				}
 			}
 
-			if (!sendingREForPRE)
+			if (!sendingREForPRE && firstReadyScheduling())
+			{
+				if (!popFirstReady(busPacket)) return false;
+			}
+			else if (!sendingREForPRE)
 			{
 				unsigned startingRank = nextRank;
 				bool foundIssuable = false;
 				do
 				{
 					//make sure there is something there first
-					if (!queues[nextRank][0].empty() && !((nextRank == refreshRank) && refreshWaiting))
+					if (!queues[nextRank][0].empty())
 					{
 						//search from the beginning to find first issuable bus packet
-						for (size_t i=0;i<queues[nextRank][0].size();i++)
+						BusPacketQueue &queue = queues[nextRank][0];
+						for (BusPacket *packet = queue.front(); packet; packet = packet->next)
 						{
-							if (isIssuable(queues[nextRank][0][i]))
+							if (!refreshBlocks(packet->rank, packet->bank) && isIssuable(packet))
 							{
 								//check for dependencies
 								bool dependencyFound = false;
-								for (size_t j=0;j<i;j++)
+								for (BusPacket *earlier = queue.front(); earlier != packet; earlier = earlier->next)
 								{
-									if (queues[nextRank][0][j]->busPacketType != ACTIVATE &&
-									        queues[nextRank][0][j]->bank == queues[nextRank][0][i]->bank &&
-									        queues[nextRank][0][j]->row == queues[nextRank][0][i]->row)
+									if (earlier->busPacketType != ACTIVATE &&
+									        earlier->bank == packet->bank &&
+									        earlier->row == packet->row)
 									{
 										dependencyFound = true;
 										break;
@@ -395,25 +448,22 @@ bool CommandQueue::pop(BusPacket **busPacket)
 								}
 								if (dependencyFound) continue;
 
-								*busPacket = queues[nextRank][0][i];
+								*busPacket = packet;
 
 								//if the bus packet before is an activate, that is the act that was
 								//	paired with the column access we are removing, so we have to remove
-								//	that activate as well (check i>0 because if i==0 then theres nothing before it)
+								//	that activate as well (if packet is the head there is nothing before it)
 
-								if (i>0 && queues[nextRank][0][i-1]->busPacketType == ACTIVATE)
+								BusPacket *act = packet->prev;
+								if (act && act->busPacketType == ACTIVATE)
 								{
 									rowAccessCounters[(*busPacket)->rank][(*busPacket)->bank]++;
-									// i is being returned, but i-1 is being thrown away, so must delete it here 
-									delete(queues[nextRank][0][i-1]);
-									//erase is exclusive on the upper end, so really this will erase (i-1) and i
-									queues[nextRank][0].erase(queues[nextRank][0].begin()+i-1,queues[nextRank][0].begin()+i+1);
-								}
-								else
-								{
-									//or just remove the one bus packet
-									queues[nextRank][0].erase(queues[nextRank][0].begin()+i);
+									// packet is being returned, but the activate is being thrown away, so must release it here 
+									removePacket(queue, act);
+									busPacketPool.release(act);
 								}
+								//remove the bus packet itself
+								removePacket(queue, packet);
 
 								foundIssuable = true;
 								break;
@@ -426,7 +476,7 @@ bool CommandQueue::pop(BusPacket **busPacket)
 
 					//rank round robin
 					nextRank++;
-					if (nextRank == NUM_RANKS)
+					if (nextRank == config.NUM_RANKS)
 					{
 						nextRank = 0;
 					}
@@ -447,11 +497,11 @@ bool CommandQueue::pop(BusPacket **busPacket)
 						//check if bank is open
 						if (bankStates[nextRankPRE][nextBankPRE].currentBankState == RowActive)
 						{
-							for (size_t i=0;i<queues[nextRankPRE][0].size();i++)
+							for (BusPacket *packet = queues[nextRankPRE][0].front(); packet; packet = packet->next)
 							{
 								//if there is something going to that bank and row, then we don't want to send a PRE
-								if (queues[nextRankPRE][0][i]->bank == nextBankPRE &&
-								        queues[nextRankPRE][0][i]->row == bankStates[nextRankPRE][nextBankPRE].openRowAddress)
+								if (packet->bank == nextBankPRE &&
+								        packet->row == bankStates[nextRankPRE][nextBankPRE].openRowAddress)
 								{
 									found = true;
 									break;
@@ -459,13 +509,14 @@ bool CommandQueue::pop(BusPacket **busPacket)
 							}
 
 							//if nothing found going to that bank and row or too many accesses have happend, close it
-							if (!found || rowAccessCounters[nextRankPRE][nextBankPRE]==TOTAL_ROW_ACCESSES)
+							if ((!found && closeIdleRow(nextRankPRE, nextBankPRE)) ||
+							        rowAccessCounters[nextRankPRE][nextBankPRE]==config.TOTAL_ROW_ACCESSES)
 							{
 								if (currentClockCycle >= bankStates[nextRankPRE][nextBankPRE].nextPrecharge)
 								{
 									sendingPRE = true;
 									rowAccessCounters[nextRankPRE][nextBankPRE]=0;
-									*busPacket = new BusPacket(PRECHARGE, 0, 0, 0, nextRankPRE, nextBankPRE, 0);
+									*busPacket = busPacketPool.allocate(PRECHARGE, 0, 0, 0, nextRankPRE, nextBankPRE, 0);
 									break;
 								}
 							}
@@ -480,33 +531,46 @@ bool CommandQueue::pop(BusPacket **busPacket)
 			}
 		}
 	}
-	else if (queuingStructure==PerRankPerBank)
+	else if (config.queuingStructure==PerRankPerBank)
 	{
-		if (rowBufferPolicy==ClosePage)
+		if (config.rowBufferPolicy==ClosePage)
 		{
 			bool sendingREF = false;
 			if (refreshWaiting)
 			{
 				bool foundActiveOrTooEarly = false;
 				//look for open banks
-				for (size_t i=0;i<NUM_BANKS;i++)
+				for (size_t i=refreshBanksBegin;i<refreshBanksEnd;i++)
 				{
 					//checks to make sure that all banks are idle
 					if (bankStates[refreshRank][i].currentBankState == RowActive)
 					{
 						foundActiveOrTooEarly = true;
+						//an overdue refresh doesn't wait for the access the row was opened
+						//	for (once that went, the row closes by itself)
+						if (refreshOverdue)
+						{
+							if (bankStates[refreshRank][i].lastCommand == ACTIVATE &&
+							        currentClockCycle >= bankStates[refreshRank][i].nextPrecharge)
+							{
+								*busPacket = prechargeRow(refreshRank, i);
+								sendingREF = true;
+							}
+							break;
+						}
 
 						//if the bank is open, make sure there is nothing else
 						// going there before we close it
-						for (size_t j=0;j<queues[refreshRank][i].size();j++)
+						BusPacketQueue &refreshQueue = queues[refreshRank][i];
+						for (BusPacket *packet = refreshQueue.front(); packet; packet = packet->next)
 						{
-							if (queues[refreshRank][i][j]->row == bankStates[refreshRank][i].openRowAddress)
+							if (packet->row == bankStates[refreshRank][i].openRowAddress)
 							{
-								if (queues[refreshRank][i][j]->busPacketType != ACTIVATE &&
-								        isIssuable(queues[refreshRank][i][j]))
+								if (packet->busPacketType != ACTIVATE &&
+								        isIssuable(packet))
 								{
-									*busPacket = queues[refreshRank][i][j];
-									queues[refreshRank][i].erase(queues[refreshRank][i].begin() + j);
+									*busPacket = packet;
+									removePacket(refreshQueue, packet);
 									sendingREF = true;
 								}
 								break;
@@ -530,7 +594,7 @@ bool CommandQueue::pop(BusPacket **busPacket)
 				//	reset flags and pointers
 				if (!foundActiveOrTooEarly && bankStates[refreshRank][0].currentBankState != PowerDown)
 				{
-					*busPacket = new BusPacket(REFRESH, 0, 0, 0, refreshRank, 0, 0);
+					*busPacket = busPacketPool.allocate(REFRESH, 0, 0, 0, refreshRank, refreshBanksBegin, 0);
 					refreshRank = -1;
 					refreshWaiting = false;
 					sendingREF = true;
@@ -538,7 +602,11 @@ bool CommandQueue::pop(BusPacket **busPacket)
 			}
 
 			//if we're not sending a REF, proceed as normal
-			if (!sendingREF)
+			if (!sendingREF && firstReadyScheduling())
+			{
+				if (!popFirstReady(busPacket)) return false;
+			}
+			else if (!sendingREF)
 			{
 				unsigned startingRank = nextRank;
 				unsigned startingBank = nextBank;
@@ -546,14 +614,14 @@ bool CommandQueue::pop(BusPacket **busPacket)
 				do
 				{
 					//check if something is there first
-					if (!queues[nextRank][nextBank].empty() && !((nextRank == refreshRank) && refreshWaiting))
+					if (!queues[nextRank][nextBank].empty() && !refreshBlocks(nextRank, nextBank))
 					{
-						if (isIssuable(queues[nextRank][nextBank][0]))
+						if (isIssuable(queues[nextRank][nextBank].front()))
 						{
 							//no need to search because if the front can't be sent,
 							// then no chance something behind it can go instead
-							*busPacket = queues[nextRank][nextBank][0];
-							queues[nextRank][nextBank].erase(queues[nextRank][nextBank].begin());
+							*busPacket = queues[nextRank][nextBank].front();
+							removePacket(queues[nextRank][nextBank], *busPacket);
 							foundIssuable = true;
 							break;
 						}
@@ -567,14 +635,14 @@ bool CommandQueue::pop(BusPacket **busPacket)
 			}
 		}
 
-		else if (rowBufferPolicy==OpenPage)
+		else if (config.rowBufferPolicy==OpenPage || config.rowBufferPolicy==AdaptivePage)
 		{
 			bool sendingREForPRE = false;
 			if (refreshWaiting)
 			{
 				bool sendREF = true;
 				//make sure all banks idle and timing met
-				for (size_t i=0;i<NUM_BANKS;i++)
+				for (size_t i=refreshBanksBegin;i<refreshBanksEnd;i++)
 				{
 					//if a bank is active we can't send a REF yet
 					if (bankStates[refreshRank][i].currentBankState == RowActive)
@@ -582,17 +650,18 @@ bool CommandQueue::pop(BusPacket **busPacket)
 						sendREF = false;
 						bool closeRow = true;
 						//search for commands going to open bank
-						for (size_t j=0;j<queues[refreshRank][i].size();j++)
+						BusPacketQueue &refreshQueue = queues[refreshRank][i];
+						for (BusPacket *packet = refreshQueue.front(); packet && !refreshOverdue; packet = packet->next)
 						{
-							if (bankStates[refreshRank][i].openRowAddress == queues[refreshRank][i][j]->row)
+							if (bankStates[refreshRank][i].openRowAddress == packet->row)
 							{
-								if (queues[refreshRank][i][j]->busPacketType != ACTIVATE)
+								if (packet->busPacketType != ACTIVATE)
 								{
 									closeRow = false;
-									if (isIssuable(queues[refreshRank][i][j]))
+									if (isIssuable(packet))
 									{
-										*busPacket = queues[refreshRank][i][j];
-										queues[refreshRank][i].erase(queues[refreshRank][i].begin()+j);
+										*busPacket = packet;
+										removePacket(refreshQueue, packet);
 										sendingREForPRE=true;
 									}
 									break;
@@ -608,9 +677,7 @@ bool CommandQueue::pop(BusPacket **busPacket)
 						//if the bank is open and we are allowed to close it, then send a PRE
 						if (closeRow && currentClockCycle >= bankStates[refreshRank][i].nextPrecharge)
 						{
-							rowAccessCounters[refreshRank][i]=0;
-
-							*busPacket = new BusPacket(PRECHARGE, 0, 0, 0, refreshRank, i, 0);
+							*busPacket = prechargeRow(refreshRank, i);
 							sendingREForPRE = true;
 						}
 						break;
@@ -629,14 +696,18 @@ bool CommandQueue::pop(BusPacket **busPacket)
 				//	reset flags and rank pointer
 				if (sendREF && bankStates[refreshRank][0].currentBankState != PowerDown)
 				{
-					*busPacket = new BusPacket(REFRESH, 0, 0, 0, refreshRank, 0, 0);
+					*busPacket = busPacketPool.allocate(REFRESH, 0, 0, 0, refreshRank, refreshBanksBegin, 0);
 					refreshRank = -1;
 					refreshWaiting = false;
 					sendingREForPRE = true;
 				}
 			}
 
-			if (!sendingREForPRE)
+			if (!sendingREForPRE && firstReadyScheduling())
+			{
+				if (!popFirstReady(busPacket)) return false;
+			}
+			else if (!sendingREForPRE)
 			{
 				unsigned startingRank = nextRank;
 				unsigned startingBank = nextBank;
@@ -644,19 +715,20 @@ bool CommandQueue::pop(BusPacket **busPacket)
 				do
 				{
 					//check to see if something is there first
-					if (!queues[nextRank][nextBank].empty() && !((nextRank == refreshRank) && refreshWaiting))
+					if (!queues[nextRank][nextBank].empty() && !refreshBlocks(nextRank, nextBank))
 					{
 						//search from the beginning to find first issuable
-						for (size_t i=0;i<queues[nextRank][nextBank].size();i++)
+						BusPacketQueue &queue = queues[nextRank][nextBank];
+						for (BusPacket *packet = queue.front(); packet; packet = packet->next)
 						{
-							if (isIssuable(queues[nextRank][nextBank][i]))
+							if (isIssuable(packet))
 							{
 								//check for dependencies
 								bool dependencyFound = false;
-								for (size_t j=0;j<i;j++)
+								for (BusPacket *earlier = queue.front(); earlier != packet; earlier = earlier->next)
 								{
-									if (queues[nextRank][nextBank][j]->busPacketType != ACTIVATE &&
-									        queues[nextRank][nextBank][i]->row == queues[nextRank][nextBank][j]->row)
+									if (earlier->busPacketType != ACTIVATE &&
+									        packet->row == earlier->row)
 									{
 										dependencyFound = true;
 										break;
@@ -664,26 +736,21 @@ bool CommandQueue::pop(BusPacket **busPacket)
 								}
 								if (dependencyFound) continue;
 
-								*busPacket = queues[nextRank][nextBank][i];
+								*busPacket = packet;
 
 								//if the bus packet before is an activate, that is the act that was
 								//	paired with the column access we are removing, so we have to remove
-								//	that activate as well (check i>0 because if i==0 then theres nothing before it)
-								if (i>0 && queues[nextRank][nextBank][i-1]->busPacketType == ACTIVATE)
+								//	that activate as well (if packet is the head there is nothing before it)
+								BusPacket *act = packet->prev;
+								if (act && act->busPacketType == ACTIVATE)
 								{
 									rowAccessCounters[nextRank][nextBank]++;
-									// (i-1) is thrown away here so get rid of it
-									delete (queues[nextRank][nextBank][i-1]);
-
-									//erase both i-1 and i
-									queues[nextRank][nextBank].erase(queues[nextRank][nextBank].begin()+i-1,
-									                                 queues[nextRank][nextBank].begin()+i+1);
-								}
-								else
-								{
-									//or just erase the one
-									queues[nextRank][nextBank].erase(queues[nextRank][nextBank].begin()+i);
+									// the activate is thrown away here so get rid of it
+									removePacket(queue, act);
+									busPacketPool.release(act);
 								}
+								//remove the bus packet itself
+								removePacket(queue, packet);
 
 								foundIssuable = true;
 								break;
@@ -711,10 +778,10 @@ bool CommandQueue::pop(BusPacket **busPacket)
 						//check to see if bank is open
 						if (bankStates[nextRankPRE][nextBankPRE].currentBankState == RowActive)
 						{
-							for (size_t i=0;i<queues[nextRankPRE][nextBankPRE].size();i++)
+							for (BusPacket *packet = queues[nextRankPRE][nextBankPRE].front(); packet; packet = packet->next)
 							{
 								//if something is going to the open row, we shouldn't close it
-								if (queues[nextRankPRE][nextBankPRE][i]->row == bankStates[nextRankPRE][nextBankPRE].openRowAddress)
+								if (packet->row == bankStates[nextRankPRE][nextBankPRE].openRowAddress)
 								{
 									found = true;
 									break;
@@ -722,14 +789,15 @@ bool CommandQueue::pop(BusPacket **busPacket)
 							}
 
 							//if nothing was found going to the open row, send a PRE
-							if (!found || rowAccessCounters[nextRankPRE][nextBankPRE]==TOTAL_ROW_ACCESSES)
+							if ((!found && closeIdleRow(nextRankPRE, nextBankPRE)) ||
+							        rowAccessCounters[nextRankPRE][nextBankPRE]==config.TOTAL_ROW_ACCESSES)
 							{
 								if (currentClockCycle >= bankStates[nextRankPRE][nextBankPRE].nextPrecharge)
 								{
 									rowAccessCounters[nextRankPRE][nextBankPRE] = 0;
 
 									sendingPRE = true;
-									*busPacket = new BusPacket(PRECHARGE, 0, 0, 0, nextRankPRE, nextBankPRE, 0);
+									*busPacket = busPacketPool.allocate(PRECHARGE, 0, 0, 0, nextRankPRE, nextBankPRE, 0);
 									break;
 								}
 							}
@@ -755,7 +823,7 @@ bool CommandQueue::pop(BusPacket **busPacket)
 	//  posted-cas is enabled when AL>0
 	//  when sendAct is true, when don't want to increment our indexes
 	//  so we send the column access that is paid with this act
-	if (AL>0 && sendAct)
+	if (config.AL>0 && sendAct)
 	{
 		sendAct = false;
 	}
@@ -763,63 +831,396 @@ bool CommandQueue::pop(BusPacket **busPacket)
 	{
 		sendAct = true;
 		//Using rank-then-bank round-robin policy, determine which queue we will pull from next
-		if (schedulingPolicy == RankThenBankRoundRobin)
+		if (config.schedulingPolicy == RankThenBankRoundRobin)
 		{
 			nextRank++;
-			if (nextRank == NUM_RANKS)
+			if (nextRank == config.NUM_RANKS)
 			{
 				nextRank = 0;
 				nextBank++;
-				if (nextBank == NUM_BANKS)
+				if (nextBank == config.NUM_BANKS)
 				{
 					nextBank = 0;
 				}
 			}
 		}
 		//bank-then-rank round robin
-		else if (schedulingPolicy == BankThenRankRoundRobin)
+		else if (config.schedulingPolicy == BankThenRankRoundRobin)
 		{
 			nextBank++;
-			if (nextBank == NUM_BANKS)
+			if (nextBank == config.NUM_BANKS)
 			{
 				nextBank = 0;
 				nextRank++;
-				if (nextRank == NUM_RANKS)
+				if (nextRank == config.NUM_RANKS)
 				{
 					nextRank = 0;
 				}
 			}
 		}
-		else
+		//first-ready policies pick by age, not by position
+		else if (!firstReadyScheduling())
 		{
 			ERROR("== Error - Unknown scheduling policy");
 			exit(0);
 		}
 	}
 
-	//if its an activate, add a tfaw counter
+	//if its an activate, open a tfaw window
 	if ((*busPacket)->busPacketType==ACTIVATE)
 	{
-		tFAWCountdown[(*busPacket)->rank].push_back(tFAW);
+		ActivateWindow &window = tFAWWindows[(*busPacket)->rank];
+		if (window.count == 4)
+		{
+			ERROR("== Error - More than four activations in a tFAW window");
+			exit(0);
+		}
+		window.expiry[(window.head + window.count) % 4] = currentClockCycle + config.tFAW;
+		window.count++;
+
+		indexOpenRow((*busPacket)->rank, (*busPacket)->bank, (*busPacket)->row);
+	}
+
+	countRowAccess(*busPacket);
+
+	//keep track of how long rows sit idle for the adaptive row buffer policy
+	if (config.rowBufferPolicy == AdaptivePage)
+	{
+		unsigned rank = (*busPacket)->rank;
+		unsigned bank = (*busPacket)->bank;
+		if ((*busPacket)->busPacketType == PRECHARGE)
+		{
+			//nothing queued for the bank means the row timed out (rather than
+			//	making way for another row or a refresh)
+			timedOutRows[rank][bank] = -1;
+			if (queuedColumnAccesses[rank][bank] == 0 && !refreshBlocks(rank, bank))
+			{
+				timedOutRows[rank][bank] = bankStates[rank][bank].openRowAddress;
+			}
+		}
+		else if ((*busPacket)->busPacketType != REFRESH)
+		{
+			lastRowAccess[rank][bank] = currentClockCycle;
+		}
 	}
 
 	return true;
 }
 
+//removes a packet from the queue it is in and from the row hit index
+void CommandQueue::removePacket(BusPacketQueue &queue, BusPacket *packet)
+{
+	queue.erase(packet);
+	if (packet->busPacketType != ACTIVATE)
+	{
+		if (--queuedColumnAccesses[packet->rank][packet->bank] == 0)
+		{
+			numBusyBanks--;
+		}
+		numQueuedAccesses--;
+		if (isReadAccess(packet))
+		{
+			queuedReads[packet->rank][packet->bank]--;
+		}
+		if (packet->inRowHitQueue)
+		{
+			rowHits[packet->rank][packet->bank].erase(packet);
+			packet->inRowHitQueue = false;
+		}
+	}
+}
+
+//the queue that holds the commands for a rank and bank
+BusPacketQueue &CommandQueue::queueFor(unsigned rank, unsigned bank)
+{
+	return config.queuingStructure == PerRank ? queues[rank][0] : queues[rank][bank];
+}
+
+//called when an ACTIVATE to row is issued: rebuilds the list of queued
+//column accesses to that row of the bank, oldest first. enqueue() appends
+//to it from then on, so while the bank has that row open the front of the
+//list is the oldest row hit. The list is only trusted while the bank state
+//says the row is open.
+void CommandQueue::indexOpenRow(unsigned rank, unsigned bank, unsigned row)
+{
+	RowHitQueue &hits = rowHits[rank][bank];
+	while (!hits.empty())
+	{
+		BusPacket *packet = hits.front();
+		hits.erase(packet);
+		packet->inRowHitQueue = false;
+	}
+
+	indexedRows[rank][bank] = row;
+	for (BusPacket *packet = queueFor(rank, bank).front(); packet; packet = packet->next)
+	{
+		if (packet->busPacketType != ACTIVATE && packet->bank == bank && packet->row == row)
+		{
+			hits.push_back(packet);
+			packet->inRowHitQueue = true;
+		}
+	}
+}
+
+//whether an open row with nothing queued for it may be closed. the adaptive
+//policy keeps it open until it has been idle for the bank's timeout, unless
+//another row of the bank is waiting
+bool CommandQueue::closeIdleRow(unsigned rank, unsigned bank)
+{
+	if (config.rowBufferPolicy != AdaptivePage || queuedColumnAccesses[rank][bank] > 0)
+	{
+		return true;
+	}
+	return currentClockCycle >= lastRowAccess[rank][bank] + rowIdleTimeout[rank][bank];
+}
+
+//counts a column access as a row hit, miss or conflict when it issues: it
+//is a hit if it needed no ACTIVATE, a conflict if another row of the bank
+//was precharged after its ACTIVATE was queued, and a miss otherwise. the
+//outcome is decided when the ACTIVATE issues and counted with the next
+//column access to the bank
+void CommandQueue::countRowAccess(BusPacket *packet)
+{
+	unsigned rank = packet->rank;
+	unsigned bank = packet->bank;
+	RowAccess &pending = pendingRowAccess[rank][bank];
+
+	switch (packet->busPacketType)
+	{
+	case PRECHARGE:
+		prechargeSequences[rank][bank] = nextSequence;
+		prechargedRows[rank][bank] = bankStates[rank][bank].openRowAddress;
+		break;
+	case ACTIVATE:
+		if (packet->sequence < prechargeSequences[rank][bank] && prechargedRows[rank][bank] != packet->row)
+		{
+			pending = RowConflict;
+		}
+		else
+		{
+			pending = RowMiss;
+		}
+		break;
+	case READ:
+	case READ_P:
+	case WRITE:
+	case WRITE_P:
+		if (pending == RowConflict)
+		{
+			rowBufferCounts[rank][bank].conflicts++;
+		}
+		else if (pending == RowMiss)
+		{
+			rowBufferCounts[rank][bank].misses++;
+		}
+		else
+		{
+			rowBufferCounts[rank][bank].hits++;
+		}
+		pending = RowHit;
+		break;
+	default:
+		break;
+	}
+}
+
+//without a ROW_IDLE_TIMEOUT, the adaptive policy tunes each bank's timeout
+//as accesses are queued: a miss to the row the timeout just closed doubles
+//it, and a conflict with a row kept open only by the timeout halves it
+void CommandQueue::tuneRowIdleTimeout(BusPacket *packet)
+{
+	unsigned rank = packet->rank;
+	unsigned bank = packet->bank;
+	BankState &state = bankStates[rank][bank];
+	unsigned step = config.tRCD + config.tRP;
+
+	if (config.rowBufferPolicy != AdaptivePage || config.ROW_IDLE_TIMEOUT > 0)
+	{
+		return;
+	}
+	if (state.currentBankState == RowActive && state.openRowAddress != packet->row)
+	{
+		if (queuedColumnAccesses[rank][bank] == 0)
+		{
+			rowIdleTimeout[rank][bank] /= 2;
+		}
+	}
+	else if (state.currentBankState != RowActive && timedOutRows[rank][bank] == packet->row)
+	{
+		rowIdleTimeout[rank][bank] = min(32*step, max(2*rowIdleTimeout[rank][bank], step));
+		timedOutRows[rank][bank] = -1;
+	}
+}
+
+//whether another column access may go to the open row of a bank. with
+//fr_fcfs_cap, TOTAL_ROW_ACCESSES only limits the row hits while an access
+//to a different row of the bank is waiting; otherwise it is a hard limit
+bool CommandQueue::rowAccessAllowed(unsigned rank, unsigned bank)
+{
+	if (config.schedulingPolicy == FrFcfsCap &&
+	        queuedColumnAccesses[rank][bank] == rowHits[rank][bank].size())
+	{
+		return true;
+	}
+	return rowAccessCounters[rank][bank] < config.TOTAL_ROW_ACCESSES;
+}
+
+//whether a is picked before b: reads before writes, then oldest first. an
+//activate counts as the column access queued right behind it
+bool CommandQueue::schedulesBefore(BusPacket *a, BusPacket *b)
+{
+	bool aIsRead = isReadAccess(a->busPacketType == ACTIVATE ? a->next : a);
+	bool bIsRead = isReadAccess(b->busPacketType == ACTIVATE ? b->next : b);
+	if (aIsRead != bIsRead) return aIsRead;
+	return a->sequence < b->sequence;
+}
+
+bool CommandQueue::firstReadyScheduling()
+{
+	return config.schedulingPolicy == FrFcfs || config.schedulingPolicy == FrFcfsCap;
+}
+
+//the row hit of a bank first-ready scheduling picks: the oldest issuable
+//read, otherwise the oldest issuable write. the row hit list is oldest
+//first, so a hit that can't go yet doesn't hide the ones behind it
+BusPacket *CommandQueue::firstReadyHit(unsigned rank, unsigned bank)
+{
+	BusPacket *write = NULL;
+	for (BusPacket *hit = rowHits[rank][bank].front(); hit; hit = hit->rowHitNext)
+	{
+		bool isRead = isReadAccess(hit);
+		if (write != NULL && !isRead) continue;
+		//with close page a column access still has to wait for its own activate
+		if (config.rowBufferPolicy == ClosePage && hit->prev &&
+		        hit->prev->busPacketType == ACTIVATE &&
+		        hit->prev->physicalAddress == hit->physicalAddress) continue;
+		if (!isIssuable(hit) || passesSameAddress(hit)) continue;
+		if (isRead) return hit;
+		write = hit;
+	}
+	return write;
+}
+
+//whether issuing a row hit would take it past an older one to the same
+//address; only reads may pass each other
+bool CommandQueue::passesSameAddress(BusPacket *hit)
+{
+	for (BusPacket *older = hit->rowHitPrev; older; older = older->rowHitPrev)
+	{
+		if (older->physicalAddress == hit->physicalAddress &&
+		        !(isReadAccess(older) && isReadAccess(hit)))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//first-ready first-come-first-served: issues the oldest issuable row hit of
+//any bank (reads before writes), otherwise the oldest issuable ACTIVATE,
+//otherwise (open page) a PRECHARGE to a row nothing can use anymore
+bool CommandQueue::popFirstReady(BusPacket **busPacket)
+{
+	BusPacket *oldest = NULL;
+
+	for (size_t r=0;r<config.NUM_RANKS;r++)
+	{
+		for (size_t b=0;b<config.NUM_BANKS;b++)
+		{
+			//don't issue anything to a bank waiting for a refresh
+			if (refreshBlocks(r, b)) continue;
+			BusPacket *hit = firstReadyHit(r, b);
+			if (hit != NULL && (oldest == NULL || schedulesBefore(hit, oldest)))
+			{
+				oldest = hit;
+			}
+		}
+	}
+
+	if (oldest != NULL)
+	{
+		BusPacketQueue &queue = queueFor(oldest->rank, oldest->bank);
+		//a row hit doesn't need the activate it was paired with
+		BusPacket *act = oldest->prev;
+		if (config.rowBufferPolicy != ClosePage && act && act->busPacketType == ACTIVATE)
+		{
+			rowAccessCounters[oldest->rank][oldest->bank]++;
+			removePacket(queue, act);
+			busPacketPool.release(act);
+		}
+		removePacket(queue, oldest);
+		*busPacket = oldest;
+		return true;
+	}
+
+	//no row hits; look for the oldest activate that can go. any activate
+	//queued behind an unissuable one to the same bank can't go either, so
+	//the first issuable activate of each queue is the oldest of that queue
+	for (size_t r=0;r<config.NUM_RANKS;r++)
+	{
+		for (size_t q=0;q<queues[r].size();q++)
+		{
+			for (BusPacket *packet = queues[r][q].front(); packet; packet = packet->next)
+			{
+				if (packet->busPacketType == ACTIVATE && !refreshBlocks(r, packet->bank) && isIssuable(packet))
+				{
+					if (oldest == NULL || schedulesBefore(packet, oldest))
+					{
+						oldest = packet;
+					}
+					break;
+				}
+			}
+		}
+	}
+
+	if (oldest != NULL)
+	{
+		removePacket(queueFor(oldest->rank, oldest->bank), oldest);
+		*busPacket = oldest;
+		return true;
+	}
+
+	//auto-precharge closes the rows with close page
+	if (config.rowBufferPolicy == ClosePage) return false;
+
+	//close an open row that has no more row hits waiting, or whose row hits
+	//have to give way to the other rows of the bank
+	unsigned startingRank = nextRankPRE;
+	unsigned startingBank = nextBankPRE;
+	do
+	{
+		if (bankStates[nextRankPRE][nextBankPRE].currentBankState == RowActive &&
+		        ((rowHits[nextRankPRE][nextBankPRE].empty() && closeIdleRow(nextRankPRE, nextBankPRE)) ||
+		         !rowAccessAllowed(nextRankPRE, nextBankPRE)) &&
+		        currentClockCycle >= bankStates[nextRankPRE][nextBankPRE].nextPrecharge)
+		{
+			*busPacket = prechargeRow(nextRankPRE, nextBankPRE);
+			return true;
+		}
+		nextRankAndBank(nextRankPRE, nextBankPRE);
+	}
+	while (!(startingRank == nextRankPRE && startingBank == nextBankPRE));
+
+	return false;
+}
+
 //check if a rank/bank queue has room for a certain number of bus packets
+//(the ACTIVATEs prechargeRow() puts back can briefly take a queue
+//past CMD_QUEUE_DEPTH)
 bool CommandQueue::hasRoomFor(unsigned numberToEnqueue, unsigned rank, unsigned bank)
 {
-	if (queuingStructure == PerRank)
+	if (config.queuingStructure == PerRank)
 	{
-		if (CMD_QUEUE_DEPTH - queues[rank][0].size() >= numberToEnqueue)
+		if (queues[rank][0].size() + numberToEnqueue <= config.CMD_QUEUE_DEPTH)
 		{
 			return true;
 		}
 		else return false;
 	}
-	else if (queuingStructure == PerRankPerBank)
+	else if (config.queuingStructure == PerRankPerBank)
 	{
-		if (CMD_QUEUE_DEPTH - queues[rank][bank].size() >= numberToEnqueue)
+		if (queues[rank][bank].size() + numberToEnqueue <= config.CMD_QUEUE_DEPTH)
 		{
 			return true;
 		}
@@ -832,34 +1233,36 @@ bool CommandQueue::hasRoomFor(unsigned numberToEnqueue, unsigned rank, unsigned
 //prints the contents of the command queue
 void CommandQueue::print()
 {
-	if (queuingStructure==PerRank)
+	if (config.queuingStructure==PerRank)
 	{
 		PRINT(endl << "== Printing Per Rank Queue" );
-		for (size_t i=0;i<NUM_RANKS;i++)
+		for (size_t i=0;i<config.NUM_RANKS;i++)
 		{
 			PRINT(" = Rank " << i << "  size : " << queues[i][0].size() );
-			for (size_t j=0;j<queues[i][0].size();j++)
+			size_t j=0;
+			for (BusPacket *packet = queues[i][0].front(); packet; packet = packet->next)
 			{
-				PRINTN("    "<< j << "]");
-				queues[i][0][j]->print();
+				PRINTN("    "<< j++ << "]");
+				packet->print();
 			}
 		}
 	}
-	else if (queuingStructure==PerRankPerBank)
+	else if (config.queuingStructure==PerRankPerBank)
 	{
 		PRINT("\n== Printing Per Rank, Per Bank Queue" );
 
-		for (size_t i=0;i<NUM_RANKS;i++)
+		for (size_t i=0;i<config.NUM_RANKS;i++)
 		{
 			PRINT(" = Rank " << i );
-			for (size_t j=0;j<NUM_BANKS;j++)
+			for (size_t j=0;j<config.NUM_BANKS;j++)
 			{
 				PRINT("    Bank "<< j << "   size : " << queues[i][j].size() );
 
-				for (size_t k=0;k<queues[i][j].size();k++)
+				size_t k=0;
+				for (BusPacket *packet = queues[i][j].front(); packet; packet = packet->next)
 				{
-					PRINTN("       " << k << "]");
-					queues[i][j][k]->print();
+					PRINTN("       " << k++ << "]");
+					packet->print();
 				}
 			}
 		}
@@ -878,7 +1281,7 @@ bool CommandQueue::isIssuable(BusPacket *busPacket)
 		if ((bankStates[busPacket->rank][busPacket->bank].currentBankState == Idle ||
 		        bankStates[busPacket->rank][busPacket->bank].currentBankState == Refreshing) &&
 		        currentClockCycle >= bankStates[busPacket->rank][busPacket->bank].nextActivate &&
-		        tFAWCountdown[busPacket->rank].size() < 4)
+		        tFAWWindows[busPacket->rank].count < 4)
 		{
 			return true;
 		}
@@ -892,7 +1295,7 @@ bool CommandQueue::isIssuable(BusPacket *busPacket)
 		if (bankStates[busPacket->rank][busPacket->bank].currentBankState == RowActive &&
 		        currentClockCycle >= bankStates[busPacket->rank][busPacket->bank].nextWrite &&
 		        busPacket->row == bankStates[busPacket->rank][busPacket->bank].openRowAddress &&
-		        rowAccessCounters[busPacket->rank][busPacket->bank] < TOTAL_ROW_ACCESSES)
+		        rowAccessAllowed(busPacket->rank, busPacket->bank))
 		{
 			return true;
 		}
@@ -906,7 +1309,7 @@ bool CommandQueue::isIssuable(BusPacket *busPacket)
 		if (bankStates[busPacket->rank][busPacket->bank].currentBankState == RowActive &&
 		        currentClockCycle >= bankStates[busPacket->rank][busPacket->bank].nextRead &&
 		        busPacket->row == bankStates[busPacket->rank][busPacket->bank].openRowAddress &&
-		        rowAccessCounters[busPacket->rank][busPacket->bank] < TOTAL_ROW_ACCESSES)
+		        rowAccessAllowed(busPacket->rank, busPacket->bank))
 		{
 			return true;
 		}
@@ -937,13 +1340,13 @@ bool CommandQueue::isIssuable(BusPacket *busPacket)
 //figures out if a rank's queue is empty
 bool CommandQueue::isEmpty(unsigned rank)
 {
-	if (queuingStructure == PerRank)
+	if (config.queuingStructure == PerRank)
 	{
 		return queues[rank][0].empty();
 	}
-	else if (queuingStructure == PerRankPerBank)
+	else if (config.queuingStructure == PerRankPerBank)
 	{
-		for (size_t i=0;i<NUM_BANKS;i++)
+		for (size_t i=0;i<config.NUM_BANKS;i++)
 		{
 			if (!queues[rank][i].empty()) return false;
 		}
@@ -956,37 +1359,98 @@ bool CommandQueue::isEmpty(unsigned rank)
 	}
 }
 
-//tells the command queue that a particular rank is in need of a refresh
-void CommandQueue::needRefresh(unsigned rank)
+//tells the command queue that a particular rank (or with per bank refresh,
+//a bank of it) is in need of a refresh
+void CommandQueue::needRefresh(unsigned rank, unsigned bank)
 {
 	refreshWaiting = true;
+	refreshOverdue = false;
 	refreshRank = rank;
+	if (config.refreshPolicy == PerBankRefresh)
+	{
+		refreshBanksBegin = bank;
+		refreshBanksEnd = bank+1;
+	}
+	else
+	{
+		refreshBanksBegin = 0;
+		refreshBanksEnd = config.NUM_BANKS;
+	}
+}
+
+//the waiting refresh has to go out as soon as possible: its banks are
+//precharged without letting the accesses queued for their open rows go first
+void CommandQueue::hurryRefresh()
+{
+	refreshOverdue = true;
+}
+
+//whether a refresh is waiting to go out
+bool CommandQueue::refreshPending()
+{
+	return refreshWaiting;
+}
+
+//whether any reads to a bank are queued
+bool CommandQueue::readsQueued(unsigned rank, unsigned bank)
+{
+	return queuedReads[rank][bank] > 0;
+}
+
+//whether a refresh waiting to go out keeps commands away from a bank
+bool CommandQueue::refreshBlocks(unsigned rank, unsigned bank)
+{
+	return refreshWaiting && rank == refreshRank &&
+	       bank >= refreshBanksBegin && bank < refreshBanksEnd;
+}
+
+//closes the open row of a bank before all its accesses are done (for a
+//refresh, or to let other rows have a turn). column accesses to the row
+//whose ACTIVATE already went out get a new one, so they reopen the row later
+BusPacket *CommandQueue::prechargeRow(unsigned rank, unsigned bank)
+{
+	unsigned row = bankStates[rank][bank].openRowAddress;
+	BusPacketQueue &queue = queueFor(rank, bank);
+	for (BusPacket *packet = queue.front(); packet; packet = packet->next)
+	{
+		if (packet->busPacketType == ACTIVATE || packet->bank != bank || packet->row != row)
+			continue;
+		BusPacket *act = packet->prev;
+		if (act && act->busPacketType == ACTIVATE && act->physicalAddress == packet->physicalAddress)
+			continue;
+		act = busPacketPool.allocate(ACTIVATE, packet->physicalAddress, packet->column, row, rank, bank, 0);
+		act->sequence = packet->sequence;
+		queue.insert(packet, act);
+	}
+	rowAccessCounters[rank][bank]=0;
+	return busPacketPool.allocate(PRECHARGE, 0, 0, 0, rank, bank, 0);
 }
 
 void CommandQueue::nextRankAndBank(unsigned &rank, unsigned &bank)
 {
-	if (schedulingPolicy == RankThenBankRoundRobin)
+	//first-ready policies only use this to rotate the search for a row to close
+	if (config.schedulingPolicy == RankThenBankRoundRobin || firstReadyScheduling())
 	{
 		rank++;
-		if (rank == NUM_RANKS)
+		if (rank == config.NUM_RANKS)
 		{
 			rank = 0;
 			bank++;
-			if (bank == NUM_BANKS)
+			if (bank == config.NUM_BANKS)
 			{
 				bank = 0;
 			}
 		}
 	}
 	//bank-then-rank round robin
-	else if (schedulingPolicy == BankThenRankRoundRobin)
+	else if (config.schedulingPolicy == BankThenRankRoundRobin)
 	{
 		bank++;
-		if (bank == NUM_BANKS)
+		if (bank == config.NUM_BANKS)
 		{
 			bank = 0;
 			rank++;
-			if (rank == NUM_RANKS)
+			if (rank == config.NUM_RANKS)
 			{
 				rank = 0;
 			}
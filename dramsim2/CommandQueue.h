@@ -46,6 +46,7 @@
 #include "Transaction.h"
 #include "SystemConfiguration.h"
 #include "SimulatorObject.h"
+#include "MemoryStats.h"
 
 using namespace std;
 
@@ -55,13 +56,11 @@ class CommandQueue : public SimulatorObject
 {
 public:
 	//typedefs
-	typedef vector<BusPacket *> BusPacket1D;
-	typedef vector<BusPacket1D> BusPacket2D;
-	typedef vector<BusPacket2D> BusPacket3D;
+	typedef vector<BusPacketQueue> BusPacketQueue1D;
+	typedef vector<BusPacketQueue1D> BusPacketQueue2D;
 
 	//functions
-	CommandQueue(vector< vector<BankState> > &states);
-	CommandQueue();
+	CommandQueue(vector< vector<BankState> > &states, BusPacketPool &pool, const Config &config);
 	virtual ~CommandQueue(); 
 
 	void enqueue(BusPacket *newBusPacket);
@@ -69,16 +68,42 @@ public:
 	bool hasRoomFor(unsigned numberToEnqueue, unsigned rank, unsigned bank);
 	bool isIssuable(BusPacket *busPacket);
 	bool isEmpty(unsigned rank);
-	void needRefresh(unsigned rank);
+	void needRefresh(unsigned rank, unsigned bank);
+	void hurryRefresh();
+	bool refreshPending();
+	bool readsQueued(unsigned rank, unsigned bank);
+	//banks with column accesses queued
+	unsigned busyBanks() { return numBusyBanks; }
+	//column accesses queued, over all banks
+	unsigned queuedAccesses() { return numQueuedAccesses; }
 	void print();
 	void update(); //SimulatorObject requirement
 
 	//fields
 	
-	BusPacket3D queues; // 3D array of BusPacket pointers
+	BusPacketQueue2D queues; // 2D array of BusPacket queues
 	vector< vector<BankState> > &bankStates;
+
+	//per bank, how the issued column accesses found the row buffer
+	vector< vector<RowBufferCounts> > rowBufferCounts;
 private:
+	const Config &config;
+	BusPacketPool &busPacketPool;
 	void nextRankAndBank(unsigned &rank, unsigned &bank);
+	void removePacket(BusPacketQueue &queue, BusPacket *packet);
+	BusPacketQueue &queueFor(unsigned rank, unsigned bank);
+	void indexOpenRow(unsigned rank, unsigned bank, unsigned row);
+	bool rowAccessAllowed(unsigned rank, unsigned bank);
+	bool closeIdleRow(unsigned rank, unsigned bank);
+	void countRowAccess(BusPacket *packet);
+	void tuneRowIdleTimeout(BusPacket *packet);
+	bool refreshBlocks(unsigned rank, unsigned bank);
+	BusPacket *prechargeRow(unsigned rank, unsigned bank);
+	bool firstReadyScheduling();
+	bool schedulesBefore(BusPacket *a, BusPacket *b);
+	bool popFirstReady(BusPacket **busPacket);
+	BusPacket *firstReadyHit(unsigned rank, unsigned bank);
+	bool passesSameAddress(BusPacket *hit);
 	//fields
 	unsigned nextBank;
 	unsigned nextRank;
@@ -88,10 +113,52 @@ private:
 
 	unsigned refreshRank;
 	bool refreshWaiting;
-
-	vector< vector<unsigned> > tFAWCountdown;
+	//the banks of refreshRank the waiting refresh is for
+	unsigned refreshBanksBegin;
+	unsigned refreshBanksEnd;
+	//the waiting refresh can't be put off, so it doesn't wait for row hits
+	bool refreshOverdue;
+
+	//cycles at which the last (up to four) ACTIVATEs to a rank leave the
+	//tFAW window, oldest first
+	struct ActivateWindow
+	{
+		uint64_t expiry[4];
+		unsigned head;
+		unsigned count;
+	};
+	vector<ActivateWindow> tFAWWindows;
 	vector< vector<unsigned> > rowAccessCounters;
 
+	//per bank: the row of the last ACTIVATE, the queued column accesses to
+	//it (oldest first) and the number of queued column accesses in total
+	vector< vector<unsigned> > indexedRows;
+	vector< vector<RowHitQueue> > rowHits;
+	vector< vector<unsigned> > queuedColumnAccesses;
+	vector< vector<unsigned> > queuedReads;
+	unsigned numBusyBanks;
+	unsigned numQueuedAccesses;
+
+	//adaptive row buffer policy, per bank: when the open row was last used,
+	//how long it may then stay idle and the row the timeout last closed
+	vector< vector<uint64_t> > lastRowAccess;
+	vector< vector<unsigned> > rowIdleTimeout;
+	vector< vector<unsigned> > timedOutRows;
+	uint64_t nextSequence;
+
+	//per bank, for countRowAccess(): nextSequence and the open row when the
+	//bank was last precharged, and what the last ACTIVATE makes of the next
+	//column access to issue (RowHit once that access has been counted)
+	enum RowAccess
+	{
+		RowHit,
+		RowMiss,
+		RowConflict
+	};
+	vector< vector<uint64_t> > prechargeSequences;
+	vector< vector<unsigned> > prechargedRows;
+	vector< vector<RowAccess> > pendingRowAccess;
+
 	bool sendAct;
 };
 }
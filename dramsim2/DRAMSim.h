@@ -36,6 +36,8 @@
  * provide all necessary functionality to talk to an external simulator
  */
 #include "Callback.h"
+#include "LatencyHistogram.h"
+#include "MemoryStats.h"
 #include <string>
 using std::string;
 
@@ -44,16 +46,36 @@ namespace DRAMSim
 
 	class MultiChannelMemorySystem {
 		public: 
+			// never turns a transaction away: one whose channel is full waits
+			// in a buffer past the queue and true is still returned, in serial
+			// and PARALLEL_BATCH_CYCLES mode alike; ask willAcceptTransaction()
+			// first for backpressure
 			bool addTransaction(bool isWrite, uint64_t addr);
 			void update();
 			void printStats();
+			LatencyStats getReadLatencyStats(bool epochOnly = false);
+			MemoryStats getStats();
+			unsigned getNumChannels();
+			unsigned getChannel(uint64_t addr);
+			unsigned getQueueOccupancy(unsigned channel);
 			bool willAcceptTransaction(); 
 			bool willAcceptTransaction(uint64_t addr); 
+			// tagged with a requestor for the per requestor queue limits,
+			// priorities and statistics; the ones above use requestor 0
+			bool addTransaction(bool isWrite, uint64_t addr, unsigned requestor);
+			bool willAcceptTransaction(uint64_t addr, unsigned requestor);
+			// only asks for room in the queue a read (or write) goes to; the
+			// ones above ask for room for either
+			bool willAcceptTransaction(bool isWrite, uint64_t addr, unsigned requestor);
 
 			void RegisterCallbacks( 
 				TransactionCompleteCB *readDone,
 				TransactionCompleteCB *writeDone,
 				void (*reportPower)(double bgpower, double burstpower, double refreshpower, double actprepower));
+			// instead of the callbacks, update() appends finished transactions
+			// to buffer; takeCompletions() returns their number and empties it
+			void RegisterCompletionBuffer(TransactionCompletion *buffer, size_t capacity);
+			size_t takeCompletions();
 	};
 	MultiChannelMemorySystem *getMemorySystemInstance(const string &dev, const string &sys, const string &pwd, const string &trc, unsigned megsOfMemory);
 }
@@ -39,170 +39,116 @@
 
 using namespace std;
 
-// these are the values that are extern'd in SystemConfig.h so that they
-// have global scope even though they are set by IniReader
-
-uint64_t TOTAL_STORAGE;
-unsigned NUM_BANKS;
-unsigned NUM_CHANS;
-unsigned NUM_ROWS;
-unsigned NUM_COLS;
-unsigned DEVICE_WIDTH;
-
-unsigned REFRESH_PERIOD;
-float tCK;
-float Vdd;
-unsigned CL;
-unsigned AL;
-unsigned BL;
-unsigned tRAS;
-unsigned tRCD;
-unsigned tRRD;
-unsigned tRC;
-unsigned tRP;
-unsigned tCCD;
-unsigned tRTP;
-unsigned tWTR;
-unsigned tWR;
-unsigned tRTRS;
-unsigned tRFC;
-unsigned tFAW;
-unsigned tCKE;
-unsigned tXP;
-unsigned tCMD;
-
-unsigned IDD0;
-unsigned IDD1;
-unsigned IDD2P;
-unsigned IDD2Q;
-unsigned IDD2N;
-unsigned IDD3Pf;
-unsigned IDD3Ps;
-unsigned IDD3N;
-unsigned IDD4W;
-unsigned IDD4R;
-unsigned IDD5;
-unsigned IDD6;
-unsigned IDD6L;
-unsigned IDD7;
-
-
-//in bytes
-unsigned JEDEC_DATA_BUS_BITS;
-
-//Memory Controller related parameters
-unsigned TRANS_QUEUE_DEPTH;
-unsigned CMD_QUEUE_DEPTH;
-
-//cycles within an epoch
-unsigned EPOCH_LENGTH;
-
-//row accesses allowed before closing (open page)
-unsigned TOTAL_ROW_ACCESSES;
-
-// strings and their associated enums
-string ROW_BUFFER_POLICY;
-string SCHEDULING_POLICY;
-string ADDRESS_MAPPING_SCHEME;
-string QUEUING_STRUCTURE;
-
-bool DEBUG_TRANS_Q;
-bool DEBUG_CMD_Q;
-bool DEBUG_ADDR_MAP;
-bool DEBUG_BANKSTATE;
-bool DEBUG_BUS;
-bool DEBUG_BANKS;
-bool DEBUG_POWER;
-bool USE_LOW_POWER;
-bool VIS_FILE_OUTPUT;
-
-bool VERIFICATION_OUTPUT;
-
 bool DEBUG_INI_READER=false;
 
 namespace DRAMSim
 {
-RowBufferPolicy rowBufferPolicy;
-SchedulingPolicy schedulingPolicy;
-AddressMappingScheme addressMappingScheme;
-QueuingStructure queuingStructure;
-
-
-//Map the string names to the variables they set
-static ConfigMap configMap[] =
+//Map the string names to the variables they set in config
+vector<ConfigMap> IniReader::GetConfigMap(Config &config)
 {
-	//DEFINE_UINT_PARAM -- see IniReader.h
-	DEFINE_UINT_PARAM(NUM_BANKS,DEV_PARAM),
-	DEFINE_UINT_PARAM(NUM_ROWS,DEV_PARAM),
-	DEFINE_UINT_PARAM(NUM_COLS,DEV_PARAM),
-	DEFINE_UINT_PARAM(DEVICE_WIDTH,DEV_PARAM),
-	DEFINE_UINT_PARAM(REFRESH_PERIOD,DEV_PARAM),
-	DEFINE_FLOAT_PARAM(tCK,DEV_PARAM),
-	DEFINE_UINT_PARAM(CL,DEV_PARAM),
-	DEFINE_UINT_PARAM(AL,DEV_PARAM),
-	DEFINE_UINT_PARAM(BL,DEV_PARAM),
-	DEFINE_UINT_PARAM(tRAS,DEV_PARAM),
-	DEFINE_UINT_PARAM(tRCD,DEV_PARAM),
-	DEFINE_UINT_PARAM(tRRD,DEV_PARAM),
-	DEFINE_UINT_PARAM(tRC,DEV_PARAM),
-	DEFINE_UINT_PARAM(tRP,DEV_PARAM),
-	DEFINE_UINT_PARAM(tCCD,DEV_PARAM),
-	DEFINE_UINT_PARAM(tRTP,DEV_PARAM),
-	DEFINE_UINT_PARAM(tWTR,DEV_PARAM),
-	DEFINE_UINT_PARAM(tWR,DEV_PARAM),
-	DEFINE_UINT_PARAM(tRTRS,DEV_PARAM),
-	DEFINE_UINT_PARAM(tRFC,DEV_PARAM),
-	DEFINE_UINT_PARAM(tFAW,DEV_PARAM),
-	DEFINE_UINT_PARAM(tCKE,DEV_PARAM),
-	DEFINE_UINT_PARAM(tXP,DEV_PARAM),
-	DEFINE_UINT_PARAM(tCMD,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD0,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD1,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD2P,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD2Q,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD2N,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD3Pf,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD3Ps,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD3N,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD4W,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD4R,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD5,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD6,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD6L,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD7,DEV_PARAM),
-	DEFINE_FLOAT_PARAM(Vdd,DEV_PARAM),
-
-	DEFINE_UINT_PARAM(NUM_CHANS,SYS_PARAM),
-	DEFINE_UINT_PARAM(JEDEC_DATA_BUS_BITS,SYS_PARAM),
-
-	//Memory Controller related parameters
-	DEFINE_UINT_PARAM(TRANS_QUEUE_DEPTH,SYS_PARAM),
-	DEFINE_UINT_PARAM(CMD_QUEUE_DEPTH,SYS_PARAM),
-
-	DEFINE_UINT_PARAM(EPOCH_LENGTH,SYS_PARAM),
-	//Power
-	DEFINE_BOOL_PARAM(USE_LOW_POWER,SYS_PARAM),
-
-	DEFINE_UINT_PARAM(TOTAL_ROW_ACCESSES,SYS_PARAM),
-	DEFINE_STRING_PARAM(ROW_BUFFER_POLICY,SYS_PARAM),
-	DEFINE_STRING_PARAM(SCHEDULING_POLICY,SYS_PARAM),
-	DEFINE_STRING_PARAM(ADDRESS_MAPPING_SCHEME,SYS_PARAM),
-	DEFINE_STRING_PARAM(QUEUING_STRUCTURE,SYS_PARAM),
-	// debug flags
-	DEFINE_BOOL_PARAM(DEBUG_TRANS_Q,SYS_PARAM),
-	DEFINE_BOOL_PARAM(DEBUG_CMD_Q,SYS_PARAM),
-	DEFINE_BOOL_PARAM(DEBUG_ADDR_MAP,SYS_PARAM),
-	DEFINE_BOOL_PARAM(DEBUG_BANKSTATE,SYS_PARAM),
-	DEFINE_BOOL_PARAM(DEBUG_BUS,SYS_PARAM),
-	DEFINE_BOOL_PARAM(DEBUG_BANKS,SYS_PARAM),
-	DEFINE_BOOL_PARAM(DEBUG_POWER,SYS_PARAM),
-	DEFINE_BOOL_PARAM(VIS_FILE_OUTPUT,SYS_PARAM),
-	DEFINE_BOOL_PARAM(VERIFICATION_OUTPUT,SYS_PARAM),
-	{"", NULL, UINT, SYS_PARAM, false} // tracer value to signify end of list; if you delete it, epic fail will result
-};
-
-void IniReader::WriteParams(std::ofstream &visDataOut, paramType type)
+	ConfigMap configMap[] =
+	{
+		//DEFINE_UINT_PARAM -- see IniReader.h
+		DEFINE_UINT_PARAM(NUM_BANKS,DEV_PARAM),
+		DEFINE_UINT_PARAM(NUM_ROWS,DEV_PARAM),
+		DEFINE_UINT_PARAM(NUM_COLS,DEV_PARAM),
+		DEFINE_UINT_PARAM(DEVICE_WIDTH,DEV_PARAM),
+		DEFINE_UINT_PARAM(REFRESH_PERIOD,DEV_PARAM),
+		DEFINE_FLOAT_PARAM(tCK,DEV_PARAM),
+		DEFINE_UINT_PARAM(CL,DEV_PARAM),
+		DEFINE_UINT_PARAM(AL,DEV_PARAM),
+		DEFINE_UINT_PARAM(BL,DEV_PARAM),
+		DEFINE_UINT_PARAM(tRAS,DEV_PARAM),
+		DEFINE_UINT_PARAM(tRCD,DEV_PARAM),
+		DEFINE_UINT_PARAM(tRRD,DEV_PARAM),
+		DEFINE_UINT_PARAM(tRC,DEV_PARAM),
+		DEFINE_UINT_PARAM(tRP,DEV_PARAM),
+		DEFINE_UINT_PARAM(tCCD,DEV_PARAM),
+		DEFINE_UINT_PARAM(tRTP,DEV_PARAM),
+		DEFINE_UINT_PARAM(tWTR,DEV_PARAM),
+		DEFINE_UINT_PARAM(tWR,DEV_PARAM),
+		DEFINE_UINT_PARAM(tRTRS,DEV_PARAM),
+		DEFINE_UINT_PARAM(tRFC,DEV_PARAM),
+		DEFINE_OPTIONAL_UINT_PARAM(tRFCpb,DEV_PARAM,0),
+		DEFINE_UINT_PARAM(tFAW,DEV_PARAM),
+		DEFINE_UINT_PARAM(tCKE,DEV_PARAM),
+		DEFINE_UINT_PARAM(tXP,DEV_PARAM),
+		DEFINE_UINT_PARAM(tCMD,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD0,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD1,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD2P,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD2Q,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD2N,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD3Pf,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD3Ps,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD3N,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD4W,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD4R,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD5,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD6,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD6L,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD7,DEV_PARAM),
+		DEFINE_FLOAT_PARAM(Vdd,DEV_PARAM),
+
+		DEFINE_UINT_PARAM(NUM_CHANS,SYS_PARAM),
+		DEFINE_UINT_PARAM(JEDEC_DATA_BUS_BITS,SYS_PARAM),
+
+		//Memory Controller related parameters
+		DEFINE_UINT_PARAM(TRANS_QUEUE_DEPTH,SYS_PARAM),
+		DEFINE_UINT_PARAM(CMD_QUEUE_DEPTH,SYS_PARAM),
+
+		DEFINE_UINT_PARAM(EPOCH_LENGTH,SYS_PARAM),
+		//Power
+		DEFINE_BOOL_PARAM(USE_LOW_POWER,SYS_PARAM),
+
+		DEFINE_UINT_PARAM(TOTAL_ROW_ACCESSES,SYS_PARAM),
+		DEFINE_OPTIONAL_UINT_PARAM(ROW_IDLE_TIMEOUT,SYS_PARAM,0),
+		DEFINE_OPTIONAL_UINT_PARAM(WRITE_QUEUE_DEPTH,SYS_PARAM,0),
+		DEFINE_OPTIONAL_UINT_PARAM(WRITE_HIGH_WATERMARK,SYS_PARAM,0),
+		DEFINE_OPTIONAL_UINT_PARAM(WRITE_LOW_WATERMARK,SYS_PARAM,0),
+		DEFINE_OPTIONAL_UINT_PARAM(PARALLEL_BATCH_CYCLES,SYS_PARAM,0),
+		DEFINE_OPTIONAL_UINT_PARAM(REFRESH_POSTPONE,SYS_PARAM,0),
+		DEFINE_STRING_PARAM(ROW_BUFFER_POLICY,SYS_PARAM),
+		DEFINE_STRING_PARAM(SCHEDULING_POLICY,SYS_PARAM),
+		DEFINE_STRING_PARAM(ADDRESS_MAPPING_SCHEME,SYS_PARAM),
+		DEFINE_STRING_PARAM(QUEUING_STRUCTURE,SYS_PARAM),
+		DEFINE_OPTIONAL_STRING_PARAM(REFRESH_POLICY,SYS_PARAM),
+		DEFINE_OPTIONAL_STRING_PARAM(ADDR_MAP_CHANNEL_BITS,SYS_PARAM),
+		DEFINE_OPTIONAL_STRING_PARAM(ADDR_MAP_RANK_BITS,SYS_PARAM),
+		DEFINE_OPTIONAL_STRING_PARAM(ADDR_MAP_BANK_BITS,SYS_PARAM),
+		DEFINE_OPTIONAL_STRING_PARAM(ADDR_MAP_ROW_BITS,SYS_PARAM),
+		DEFINE_OPTIONAL_STRING_PARAM(ADDR_MAP_COL_BITS,SYS_PARAM),
+		DEFINE_OPTIONAL_STRING_PARAM(ADDR_MAP_CHANNEL_XOR,SYS_PARAM),
+		DEFINE_OPTIONAL_STRING_PARAM(ADDR_MAP_RANK_XOR,SYS_PARAM),
+		DEFINE_OPTIONAL_STRING_PARAM(ADDR_MAP_BANK_XOR,SYS_PARAM),
+		DEFINE_OPTIONAL_STRING_PARAM(ADDR_MAP_ROW_XOR,SYS_PARAM),
+		DEFINE_OPTIONAL_STRING_PARAM(ADDR_MAP_COL_XOR,SYS_PARAM),
+		DEFINE_OPTIONAL_STRING_PARAM(REQUESTOR_QUEUE_LIMITS,SYS_PARAM),
+		DEFINE_OPTIONAL_STRING_PARAM(REQUESTOR_PRIORITIES,SYS_PARAM),
+		// debug flags
+		DEFINE_BOOL_PARAM(DEBUG_TRANS_Q,SYS_PARAM),
+		DEFINE_BOOL_PARAM(DEBUG_CMD_Q,SYS_PARAM),
+		DEFINE_BOOL_PARAM(DEBUG_ADDR_MAP,SYS_PARAM),
+		DEFINE_BOOL_PARAM(DEBUG_BANKSTATE,SYS_PARAM),
+		DEFINE_BOOL_PARAM(DEBUG_BUS,SYS_PARAM),
+		DEFINE_BOOL_PARAM(DEBUG_BANKS,SYS_PARAM),
+		DEFINE_BOOL_PARAM(DEBUG_POWER,SYS_PARAM),
+		DEFINE_BOOL_PARAM(VIS_FILE_OUTPUT,SYS_PARAM),
+		DEFINE_OPTIONAL_STRING_PARAM(VIS_FILE_FORMAT,SYS_PARAM),
+		DEFINE_BOOL_PARAM(VERIFICATION_OUTPUT,SYS_PARAM),
+		{"", NULL, UINT, SYS_PARAM, false} // tracer value to signify end of list; if you delete it, epic fail will result
+	};
+	vector<ConfigMap> params(configMap, configMap+sizeof(configMap)/sizeof(configMap[0]));
+	for (size_t i=0; params[i].variablePtr != NULL; i++)
+	{
+		params[i].wasSet = config.keysSet.count(params[i].iniKey) > 0;
+	}
+	return params;
+}
+
+void IniReader::WriteParams(Config &config, std::ofstream &visDataOut, paramType type)
 {
+	vector<ConfigMap> configMap = GetConfigMap(config);
 	for (size_t i=0; configMap[i].variablePtr != NULL; i++)
 	{
 		if (configMap[i].parameterType == type)
@@ -239,23 +185,24 @@ void IniReader::WriteParams(std::ofstream &visDataOut, paramType type)
 	}
 	if (type == SYS_PARAM)
 	{
-		visDataOut<<"NUM_RANKS="<<NUM_RANKS <<"\n";
+		visDataOut<<"NUM_RANKS="<<config.NUM_RANKS <<"\n";
 	}
 }
-void IniReader::WriteValuesOut(std::ofstream &visDataOut)
+void IniReader::WriteValuesOut(Config &config, std::ofstream &visDataOut)
 {
 	visDataOut<<"!!SYSTEM_INI"<<endl;
 
-	WriteParams(visDataOut, SYS_PARAM); 
+	WriteParams(config, visDataOut, SYS_PARAM); 
 	visDataOut<<"!!DEVICE_INI"<<endl;
 
-	WriteParams(visDataOut, DEV_PARAM); 
+	WriteParams(config, visDataOut, DEV_PARAM); 
 	visDataOut<<"!!EPOCH_DATA"<<endl;
 
 }
 
-void IniReader::SetKey(string key, string valueString, bool isSystemParam, size_t lineNumber)
+void IniReader::SetKey(Config &config, string key, string valueString, bool isSystemParam, size_t lineNumber)
 {
+	vector<ConfigMap> configMap = GetConfigMap(config);
 	size_t i;
 	unsigned intValue;
 	uint64_t int64Value;
@@ -335,7 +282,7 @@ void IniReader::SetKey(string key, string valueString, bool isSystemParam, size_
 			}
 			// use the pointer stored in the config map to set the value of the variable
 			// to make sure all parameters are in the ini file
-			configMap[i].wasSet = true;
+			config.keysSet.insert(configMap[i].iniKey);
 			break;
 		}
 	}
@@ -346,7 +293,7 @@ void IniReader::SetKey(string key, string valueString, bool isSystemParam, size_
 	}
 }
 
-void IniReader::ReadIniFile(string filename, bool isSystemFile)
+void IniReader::ReadIniFile(Config &config, string filename, bool isSystemFile)
 {
 	ifstream iniFile;
 	string line;
@@ -408,7 +355,7 @@ void IniReader::ReadIniFile(string filename, bool isSystemFile)
 			// all characters after the equals are the value
 			valueString = line.substr(equalsIndex+1,strlen-equalsIndex);
 
-			IniReader::SetKey(key, valueString, lineNumber, isSystemFile);
+			IniReader::SetKey(config, key, valueString, lineNumber, isSystemFile);
 			// got to the end of the config map without finding the key
 		}
 	}
@@ -419,7 +366,7 @@ void IniReader::ReadIniFile(string filename, bool isSystemFile)
 	}
 }
 
-void IniReader::OverrideKeys(vector<string> keys, vector<string>values)
+void IniReader::OverrideKeys(Config &config, vector<string> keys, vector<string>values)
 {
 	if (keys.size() != values.size())
 	{
@@ -428,16 +375,25 @@ void IniReader::OverrideKeys(vector<string> keys, vector<string>values)
 	}
 	for (size_t i=0; i<keys.size(); i++)
 	{
-		IniReader::SetKey(keys[i], values[i]);
+		IniReader::SetKey(config, keys[i], values[i]);
 	}
 }
 
-bool IniReader::CheckIfAllSet()
+bool IniReader::CheckIfAllSet(Config &config)
 {
+	vector<ConfigMap> configMap = GetConfigMap(config);
 	// check to make sure all parameters that we exepected were set
 	for (size_t i=0; configMap[i].variablePtr != NULL; i++)
 	{
-		if (!configMap[i].wasSet)
+		if (!configMap[i].wasSet && configMap[i].isOptional)
+		{
+			//optional keys are newer than most ini files, so don't warn
+			if (configMap[i].variableType == UINT)
+			{
+				*((unsigned *)configMap[i].variablePtr) = configMap[i].defaultValue;
+			}
+		}
+		else if (!configMap[i].wasSet)
 		{
 			DEBUG("WARNING: KEY "<<configMap[i].iniKey<<" NOT FOUND IN INI FILE.");
 			switch (configMap[i].variableType)
@@ -460,103 +416,140 @@ bool IniReader::CheckIfAllSet()
 	}
 	return true;
 }
-void IniReader::InitEnumsFromStrings()
+//one number per requestor, e.g. "0,0,8"
+static vector<unsigned> parseRequestorList(const string &key, const string &list)
 {
-	if (ADDRESS_MAPPING_SCHEME == "scheme1")
+	vector<unsigned> values;
+	istringstream in(list);
+	string item;
+	while (getline(in, item, ','))
 	{
-		addressMappingScheme = Scheme1;
+		istringstream number(item);
+		unsigned value;
+		char extra;
+		if (!(number >> value) || number >> extra)
+		{
+			ERROR("== Error - bad entry '"<<item<<"' in "<<key<<"='"<<list<<"'");
+			exit(-1);
+		}
+		values.push_back(value);
+	}
+	return values;
+}
+
+void IniReader::InitEnumsFromStrings(Config &config)
+{
+	if (config.ADDRESS_MAPPING_SCHEME == "scheme1")
+	{
+		config.addressMappingScheme = Scheme1;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("ADDR SCHEME: 1");
 		}
 	}
-	else if (ADDRESS_MAPPING_SCHEME == "scheme2")
+	else if (config.ADDRESS_MAPPING_SCHEME == "scheme2")
 	{
-		addressMappingScheme = Scheme2;
+		config.addressMappingScheme = Scheme2;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("ADDR SCHEME: 2");
 		}
 	}
-	else if (ADDRESS_MAPPING_SCHEME == "scheme3")
+	else if (config.ADDRESS_MAPPING_SCHEME == "scheme3")
 	{
-		addressMappingScheme = Scheme3;
+		config.addressMappingScheme = Scheme3;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("ADDR SCHEME: 3");
 		}
 	}
-	else if (ADDRESS_MAPPING_SCHEME == "scheme4")
+	else if (config.ADDRESS_MAPPING_SCHEME == "scheme4")
 	{
-		addressMappingScheme = Scheme4;
+		config.addressMappingScheme = Scheme4;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("ADDR SCHEME: 4");
 		}
 	}
-	else if (ADDRESS_MAPPING_SCHEME == "scheme5")
+	else if (config.ADDRESS_MAPPING_SCHEME == "scheme5")
 	{
-		addressMappingScheme = Scheme5;
+		config.addressMappingScheme = Scheme5;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("ADDR SCHEME: 5");
 		}
 	}
-	else if (ADDRESS_MAPPING_SCHEME == "scheme6")
+	else if (config.ADDRESS_MAPPING_SCHEME == "scheme6")
 	{
-		addressMappingScheme = Scheme6;
+		config.addressMappingScheme = Scheme6;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("ADDR SCHEME: 6");
 		}
 	}
-	else if (ADDRESS_MAPPING_SCHEME == "scheme7")
+	else if (config.ADDRESS_MAPPING_SCHEME == "scheme7")
 	{
-		addressMappingScheme = Scheme7;
+		config.addressMappingScheme = Scheme7;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("ADDR SCHEME: 7");
 		}
 	}
+	else if (config.ADDRESS_MAPPING_SCHEME == "custom")
+	{
+		config.addressMappingScheme = CustomScheme;
+		if (DEBUG_INI_READER) 
+		{
+			DEBUG("ADDR SCHEME: custom");
+		}
+	}
 	else
 	{
-		cout << "WARNING: unknown address mapping scheme '"<<ADDRESS_MAPPING_SCHEME<<"'; valid values are 'scheme1'...'scheme7'. Defaulting to scheme1"<<endl;
-		addressMappingScheme = Scheme1;
+		cout << "WARNING: unknown address mapping scheme '"<<config.ADDRESS_MAPPING_SCHEME<<"'; valid values are 'scheme1'...'scheme7' and 'custom'. Defaulting to scheme1"<<endl;
+		config.addressMappingScheme = Scheme1;
 	}
 
-	if (ROW_BUFFER_POLICY == "open_page")
+	if (config.ROW_BUFFER_POLICY == "open_page")
 	{
-		rowBufferPolicy = OpenPage;
+		config.rowBufferPolicy = OpenPage;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("ROW BUFFER: open page");
 		}
 	}
-	else if (ROW_BUFFER_POLICY == "close_page")
+	else if (config.ROW_BUFFER_POLICY == "close_page")
 	{
-		rowBufferPolicy = ClosePage;
+		config.rowBufferPolicy = ClosePage;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("ROW BUFFER: close page");
 		}
 	}
+	else if (config.ROW_BUFFER_POLICY == "adaptive")
+	{
+		config.rowBufferPolicy = AdaptivePage;
+		if (DEBUG_INI_READER) 
+		{
+			DEBUG("ROW BUFFER: adaptive");
+		}
+	}
 	else
 	{
-		cout << "WARNING: unknown row buffer policy '"<<ROW_BUFFER_POLICY<<"'; valid values are 'open_page' or 'close_page', Defaulting to Close Page."<<endl;
-		rowBufferPolicy = ClosePage;
+		cout << "WARNING: unknown row buffer policy '"<<config.ROW_BUFFER_POLICY<<"'; valid values are 'open_page', 'close_page' or 'adaptive', Defaulting to Close Page."<<endl;
+		config.rowBufferPolicy = ClosePage;
 	}
 
-	if (QUEUING_STRUCTURE == "per_rank_per_bank")
+	if (config.QUEUING_STRUCTURE == "per_rank_per_bank")
 	{
-		queuingStructure = PerRankPerBank;
+		config.queuingStructure = PerRankPerBank;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("QUEUING STRUCT: per rank per bank");
 		}
 	}
-	else if (QUEUING_STRUCTURE == "per_rank")
+	else if (config.QUEUING_STRUCTURE == "per_rank")
 	{
-		queuingStructure = PerRank;
+		config.queuingStructure = PerRank;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("QUEUING STRUCT: per rank");
@@ -564,32 +557,85 @@ void IniReader::InitEnumsFromStrings()
 	}
 	else
 	{
-		cout << "WARNING: Unknown queueing structure '"<<QUEUING_STRUCTURE<<"'; valid options are 'per_rank' and 'per_rank_per_bank', defaulting to Per Rank Per Bank"<<endl;
-		queuingStructure = PerRankPerBank;
+		cout << "WARNING: Unknown queueing structure '"<<config.QUEUING_STRUCTURE<<"'; valid options are 'per_rank' and 'per_rank_per_bank', defaulting to Per Rank Per Bank"<<endl;
+		config.queuingStructure = PerRankPerBank;
 	}
 
-	if (SCHEDULING_POLICY == "rank_then_bank_round_robin")
+	if (config.REFRESH_POLICY == "per_bank")
 	{
-		schedulingPolicy = RankThenBankRoundRobin;
+		config.refreshPolicy = PerBankRefresh;
+		if (DEBUG_INI_READER) 
+		{
+			DEBUG("REFRESH: per bank");
+		}
+	}
+	else
+	{
+		//REFRESH_POLICY is newer than most ini files, so no value means all_bank
+		if (config.REFRESH_POLICY != "" && config.REFRESH_POLICY != "all_bank")
+		{
+			cout << "WARNING: Unknown refresh policy '"<<config.REFRESH_POLICY<<"'; valid options are 'all_bank' and 'per_bank', defaulting to all_bank"<<endl;
+		}
+		config.refreshPolicy = AllBankRefresh;
+	}
+
+	if (config.VIS_FILE_FORMAT == "binary")
+	{
+		config.visFileFormat = BinaryVisFile;
+		if (DEBUG_INI_READER) 
+		{
+			DEBUG("VIS FILE: binary");
+		}
+	}
+	else
+	{
+		if (config.VIS_FILE_FORMAT != "" && config.VIS_FILE_FORMAT != "csv")
+		{
+			cout << "WARNING: Unknown vis file format '"<<config.VIS_FILE_FORMAT<<"'; valid options are 'csv' and 'binary', defaulting to csv"<<endl;
+		}
+		config.visFileFormat = CsvVisFile;
+	}
+
+	if (config.SCHEDULING_POLICY == "rank_then_bank_round_robin")
+	{
+		config.schedulingPolicy = RankThenBankRoundRobin;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("SCHEDULING: Rank Then Bank");
 		}
 	}
-	else if (SCHEDULING_POLICY == "bank_then_rank_round_robin")
+	else if (config.SCHEDULING_POLICY == "bank_then_rank_round_robin")
 	{
-		schedulingPolicy = BankThenRankRoundRobin;
+		config.schedulingPolicy = BankThenRankRoundRobin;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("SCHEDULING: Bank Then Rank");
 		}
 	}
+	else if (config.SCHEDULING_POLICY == "fr_fcfs")
+	{
+		config.schedulingPolicy = FrFcfs;
+		if (DEBUG_INI_READER) 
+		{
+			DEBUG("SCHEDULING: FR-FCFS");
+		}
+	}
+	else if (config.SCHEDULING_POLICY == "fr_fcfs_cap")
+	{
+		config.schedulingPolicy = FrFcfsCap;
+		if (DEBUG_INI_READER) 
+		{
+			DEBUG("SCHEDULING: FR-FCFS with row hit cap");
+		}
+	}
 	else
 	{
-		cout << "WARNING: Unknown scheduling policy '"<<SCHEDULING_POLICY<<"'; valid options are 'rank_then_bank_round_robin' or 'bank_then_rank_round_robin'; defaulting to Bank Then Rank Round Robin" << endl;
-		schedulingPolicy = BankThenRankRoundRobin;
+		cout << "WARNING: Unknown scheduling policy '"<<config.SCHEDULING_POLICY<<"'; valid options are 'rank_then_bank_round_robin', 'bank_then_rank_round_robin', 'fr_fcfs' or 'fr_fcfs_cap'; defaulting to Bank Then Rank Round Robin" << endl;
+		config.schedulingPolicy = BankThenRankRoundRobin;
 	}
 
+	config.requestorQueueLimits = parseRequestorList("REQUESTOR_QUEUE_LIMITS", config.REQUESTOR_QUEUE_LIMITS);
+	config.requestorPriorities = parseRequestorList("REQUESTOR_PRIORITIES", config.REQUESTOR_PRIORITIES);
 }
 
 } // namespace DRAMSim
@@ -47,11 +47,15 @@
 using namespace std;
 
 // Uhhh, apparently the #name equals "name" -- HOORAY MACROS!
-#define DEFINE_UINT_PARAM(name, paramtype) {#name, &name, UINT, paramtype, false}
-#define DEFINE_STRING_PARAM(name, paramtype) {#name, &name, STRING, paramtype, false}
-#define DEFINE_FLOAT_PARAM(name,paramtype) {#name, &name, FLOAT, paramtype, false}
-#define DEFINE_BOOL_PARAM(name, paramtype) {#name, &name, BOOL, paramtype, false}
-#define DEFINE_UINT64_PARAM(name, paramtype) {#name, &name, UINT64, paramtype, false}
+// (these expect a Config named config to be in scope)
+#define DEFINE_UINT_PARAM(name, paramtype) {#name, &config.name, UINT, paramtype, false}
+#define DEFINE_STRING_PARAM(name, paramtype) {#name, &config.name, STRING, paramtype, false}
+#define DEFINE_FLOAT_PARAM(name,paramtype) {#name, &config.name, FLOAT, paramtype, false}
+#define DEFINE_BOOL_PARAM(name, paramtype) {#name, &config.name, BOOL, paramtype, false}
+#define DEFINE_UINT64_PARAM(name, paramtype) {#name, &config.name, UINT64, paramtype, false}
+// for keys that older ini files don't have
+#define DEFINE_OPTIONAL_UINT_PARAM(name, paramtype, defaultValue) {#name, &config.name, UINT, paramtype, false, true, defaultValue}
+#define DEFINE_OPTIONAL_STRING_PARAM(name, paramtype) {#name, &config.name, STRING, paramtype, false, true, 0}
 
 namespace DRAMSim
 {
@@ -66,20 +70,23 @@ typedef struct _configMap
 	varType variableType;
 	paramType parameterType;
 	bool wasSet;
+	bool isOptional; //if not set, UINT keys take defaultValue (STRING keys stay empty) instead of stopping
+	unsigned defaultValue;
 } ConfigMap;
 
 class IniReader
 {
 public:
-	static void SetKey(string key, string value, bool isSystemParam = false, size_t lineNumber = 0);
-	static void OverrideKeys(vector<string> keys, vector<string> values);
-	static void ReadIniFile(string filename, bool isSystemParam);
-	static void InitEnumsFromStrings();
-	static bool CheckIfAllSet();
-	static void WriteValuesOut(std::ofstream &visDataOut);
+	static void SetKey(Config &config, string key, string value, bool isSystemParam = false, size_t lineNumber = 0);
+	static void OverrideKeys(Config &config, vector<string> keys, vector<string> values);
+	static void ReadIniFile(Config &config, string filename, bool isSystemParam);
+	static void InitEnumsFromStrings(Config &config);
+	static bool CheckIfAllSet(Config &config);
+	static void WriteValuesOut(Config &config, std::ofstream &visDataOut);
 
 private:
-	static void WriteParams(std::ofstream &visDataOut, paramType t);
+	static vector<ConfigMap> GetConfigMap(Config &config);
+	static void WriteParams(Config &config, std::ofstream &visDataOut, paramType t);
 	static void Trim(string &str);
 };
 }
@@ -0,0 +1,116 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+
+
+
+
+
+//LatencyHistogram.cpp
+//
+//Class file for the log-linear latency histogram
+//
+
+#include <cstring>
+#include <cmath>
+#include "LatencyHistogram.h"
+
+using namespace DRAMSim;
+
+LatencyHistogram::LatencyHistogram()
+{
+	reset();
+}
+
+void LatencyHistogram::add(const LatencyHistogram &other)
+{
+	for (unsigned i=0; i<NUM_BUCKETS; i++)
+	{
+		counts[i] += other.counts[i];
+	}
+	total += other.total;
+	sum += other.sum;
+	if (other.maxLatency > maxLatency)
+		maxLatency = other.maxLatency;
+}
+
+void LatencyHistogram::reset()
+{
+	memset(counts, 0, sizeof(counts));
+	total = 0;
+	sum = 0;
+	maxLatency = 0;
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const
+{
+	if (total == 0)
+		return 0;
+	uint64_t target = (uint64_t)ceil(fraction * total);
+	if (target == 0)
+		target = 1;
+	uint64_t seen = 0;
+	for (unsigned i=0; i<NUM_BUCKETS; i++)
+	{
+		seen += counts[i];
+		if (seen >= target)
+			return bucketHigh(i) < maxLatency ? bucketHigh(i) : maxLatency;
+	}
+	return maxLatency;
+}
+
+LatencyStats LatencyHistogram::stats() const
+{
+	LatencyStats s;
+	s.count = total;
+	s.mean = mean();
+	s.p50 = percentile(0.50);
+	s.p90 = percentile(0.90);
+	s.p99 = percentile(0.99);
+	s.max = maxLatency;
+	return s;
+}
+
+uint64_t LatencyHistogram::bucketLow(unsigned index)
+{
+	if (index < 2 * SUB_BUCKETS)
+		return index;
+	unsigned shift = index / SUB_BUCKETS - 1;
+	return (uint64_t)(index - shift * SUB_BUCKETS) << shift;
+}
+
+uint64_t LatencyHistogram::bucketHigh(unsigned index)
+{
+	if (index < 2 * SUB_BUCKETS)
+		return index;
+	unsigned shift = index / SUB_BUCKETS - 1;
+	return ((uint64_t)(index - shift * SUB_BUCKETS + 1) << shift) - 1;
+}
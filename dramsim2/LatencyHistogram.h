@@ -0,0 +1,113 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+
+
+
+
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+//LatencyHistogram.h
+//
+//Header file for the log-linear latency histogram
+//
+
+#include <stdint.h>
+
+namespace DRAMSim
+{
+// read latency summary, in memory clock cycles
+struct LatencyStats
+{
+	uint64_t count;
+	double mean;
+	uint64_t p50;
+	uint64_t p90;
+	uint64_t p99;
+	uint64_t max;
+};
+
+// Fixed size log-linear (HDR style) histogram: latencies below
+// 2*SUB_BUCKETS are counted exactly, above that each power of two is split
+// into SUB_BUCKETS equal buckets, so a bucket is never wider than
+// 1/SUB_BUCKETS of the values in it. Recording is an array increment.
+class LatencyHistogram
+{
+public:
+	static const unsigned SUB_BUCKET_BITS = 5;
+	static const unsigned SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+	static const unsigned NUM_BUCKETS = (32 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+	LatencyHistogram();
+
+	void record(unsigned latency)
+	{
+		counts[bucketIndex(latency)]++;
+		total++;
+		sum += latency;
+		if (latency > maxLatency)
+			maxLatency = latency;
+	}
+	void add(const LatencyHistogram &other);
+	void reset();
+
+	uint64_t count() const { return total; }
+	uint64_t max() const { return maxLatency; }
+	double mean() const { return total ? (double)sum / total : 0.0; }
+	// smallest recorded latency (to bucket precision) that at least
+	// fraction of the recorded latencies do not exceed
+	uint64_t percentile(double fraction) const;
+	LatencyStats stats() const;
+
+	// walking the non-empty buckets for printing
+	uint64_t bucketCount(unsigned index) const { return counts[index]; }
+	static uint64_t bucketLow(unsigned index);
+	static uint64_t bucketHigh(unsigned index);
+
+	static unsigned bucketIndex(unsigned latency)
+	{
+		if (latency < 2 * SUB_BUCKETS)
+			return latency;
+		unsigned shift = (31 - __builtin_clz(latency)) - SUB_BUCKET_BITS;
+		return (shift + 1) * SUB_BUCKETS + ((latency >> shift) - SUB_BUCKETS);
+	}
+
+private:
+	uint64_t counts[NUM_BUCKETS];
+	uint64_t total;
+	uint64_t sum;
+	uint64_t maxLatency;
+};
+}
+
+#endif
@@ -39,20 +39,44 @@
 #include "MemorySystem.h"
 #include "AddressMapping.h"
 
-#define SEQUENTIAL(rank,bank) (rank*NUM_BANKS)+bank
+#define SEQUENTIAL(rank,bank) (rank*config.NUM_BANKS)+bank
 
 using namespace DRAMSim;
 
 MemoryController::MemoryController(MemorySystem *parent, std::ofstream *outfile) :
-		commandQueue (CommandQueue(bankStates)),
+		config(parent->config),
+		busPacketPool(parent->busPacketPool),
+		commandQueue (CommandQueue(bankStates, parent->busPacketPool, parent->config)),
 		poppedBusPacket(NULL),
+		drainingWrites(false),
+		drainBudget(0),
+		readsFirst(false),
+		lastDrainEnd(0),
+		writeDrains(0),
+		readsForwarded(0),
+		readsIssued(0),
+		writesIssued(0),
+		dataBusCycles(0),
+		queueDepthSum(0),
+		busyBankSum(0),
+		busyBankCycles(0),
 		csvOut(*outfile),
+		binaryStatsOut(NULL),
+		firstStatsColumn(0),
 		totalTransactions(0),
-		refreshRank(0)
+		refreshRank(0),
+		refreshesIssued(0),
+		mostRefreshesOwed(0)
 {
+	maxRequestorPriority = 0;
+	for (size_t i=0; i<config.requestorPriorities.size(); i++)
+	{
+		maxRequestorPriority = max(maxRequestorPriority, config.requestorPriorities[i]);
+	}
+
 	//get handle on parent
 	parentMemorySystem = parent;
-	if (VIS_FILE_OUTPUT)
+	if (config.VIS_FILE_OUTPUT)
 	{
 		visDataOut = outfile; 
 	}
@@ -67,32 +91,56 @@ MemoryController::MemoryController(MemorySystem *parent, std::ofstream *outfile)
 	//set here to avoid compile errors
 	currentClockCycle = 0;
 
+	if (config.WRITE_QUEUE_DEPTH > 0 &&
+	        (config.WRITE_HIGH_WATERMARK == 0 || config.WRITE_HIGH_WATERMARK > config.WRITE_QUEUE_DEPTH ||
+	         config.WRITE_LOW_WATERMARK >= config.WRITE_HIGH_WATERMARK))
+	{
+		ERROR("== Error - need 0 <= WRITE_LOW_WATERMARK < WRITE_HIGH_WATERMARK <= WRITE_QUEUE_DEPTH");
+		exit(-1);
+	}
+	if (config.REFRESH_POSTPONE > 8)
+	{
+		ERROR("== Error - REFRESH_POSTPONE can be at most 8");
+		exit(-1);
+	}
+	if (config.refreshPolicy == PerBankRefresh && config.tRFCpb == 0)
+	{
+		ERROR("== Error - per bank refresh needs tRFCpb in the device ini file");
+		exit(-1);
+	}
+
 	//reserve memory for vectors
-	transactionQueue.reserve(TRANS_QUEUE_DEPTH);
-	bankStates = vector< vector <BankState> >(NUM_RANKS, vector<BankState>(NUM_BANKS));
-	powerDown = vector<bool>(NUM_RANKS,false);
-	grandTotalBankAccesses = vector<uint64_t>(NUM_RANKS*NUM_BANKS,0);
-	totalReadsPerBank = vector<uint64_t>(NUM_RANKS*NUM_BANKS,0);
-	totalWritesPerBank = vector<uint64_t>(NUM_RANKS*NUM_BANKS,0);
-	totalReadsPerRank = vector<uint64_t>(NUM_RANKS,0);
-	totalWritesPerRank = vector<uint64_t>(NUM_RANKS,0);
-
-	writeDataCountdown.reserve(NUM_RANKS);
-	writeDataToSend.reserve(NUM_RANKS);
-	refreshCountdown.reserve(NUM_RANKS);
+	transactionQueue.reserve(config.TRANS_QUEUE_DEPTH);
+	writeQueue.reserve(config.WRITE_QUEUE_DEPTH);
+	transactionSlab.reserve(config.TRANS_QUEUE_DEPTH);
+	freeTransactionSlots.reserve(config.TRANS_QUEUE_DEPTH);
+	bankStates = vector< vector <BankState> >(config.NUM_RANKS, vector<BankState>(config.NUM_BANKS));
+	powerDown = vector<bool>(config.NUM_RANKS,false);
+	grandTotalBankAccesses = vector<uint64_t>(config.NUM_RANKS*config.NUM_BANKS,0);
+	totalReadsPerBank = vector<uint64_t>(config.NUM_RANKS*config.NUM_BANKS,0);
+	totalWritesPerBank = vector<uint64_t>(config.NUM_RANKS*config.NUM_BANKS,0);
+	totalReadsPerRank = vector<uint64_t>(config.NUM_RANKS,0);
+	totalWritesPerRank = vector<uint64_t>(config.NUM_RANKS,0);
+
+	writeDataCycle.reserve(config.NUM_RANKS);
+	writeDataToSend.reserve(config.NUM_RANKS);
+	refreshCountdown.reserve(config.NUM_RANKS);
+	refreshesOwed = vector<unsigned>(config.NUM_RANKS,0);
+	refreshBank = vector<unsigned>(config.NUM_RANKS,0);
 
 	//Power related packets
-	backgroundEnergy = vector <uint64_t >(NUM_RANKS,0);
-	burstEnergy = vector <uint64_t> (NUM_RANKS,0);
-	actpreEnergy = vector <uint64_t> (NUM_RANKS,0);
-	refreshEnergy = vector <uint64_t> (NUM_RANKS,0);
+	backgroundEnergy = vector <uint64_t >(config.NUM_RANKS,0);
+	burstEnergy = vector <uint64_t> (config.NUM_RANKS,0);
+	actpreEnergy = vector <uint64_t> (config.NUM_RANKS,0);
+	refreshEnergy = vector <uint64_t> (config.NUM_RANKS,0);
 
-	totalEpochLatency = vector<uint64_t> (NUM_RANKS*NUM_BANKS,0);
+	totalEpochLatency = vector<uint64_t> (config.NUM_RANKS*config.NUM_BANKS,0);
+	epochLatencies = vector<LatencyHistogram> (config.NUM_RANKS*config.NUM_BANKS);
 
 	//staggers when each rank is due for a refresh
-	for (size_t i=0;i<NUM_RANKS;i++)
+	for (size_t i=0;i<config.NUM_RANKS;i++)
 	{
-		refreshCountdown.push_back((int)((REFRESH_PERIOD/tCK)/NUM_RANKS)*(i+1));
+		refreshCountdown.push_back((int)((refreshInterval())/config.NUM_RANKS)*(i+1));
 	}
 }
 
@@ -106,27 +154,59 @@ void MemoryController::receiveFromBus(BusPacket *bpacket)
 		exit(0);
 	}
 
-	if (DEBUG_BUS)
+	if (config.DEBUG_BUS)
 	{
 		PRINTN(" -- MC Receiving From Data Bus : ");
 		bpacket->print();
 	}
 
 	//add to return read data queue
-	returnTransaction.push_back(Transaction(RETURN_DATA, bpacket->physicalAddress, bpacket->data));
+	returnTransaction.push_back(allocateTransaction(Transaction(RETURN_DATA, bpacket->physicalAddress, bpacket->data)));
 	totalReadsPerBank[SEQUENTIAL(bpacket->rank,bpacket->bank)]++;
 
-	// this delete statement saves a mindboggling amount of memory
-	delete(bpacket);
+	// this release saves a mindboggling amount of memory
+	busPacketPool.release(bpacket);
 }
 
-//sends read data back to the CPU
-void MemoryController::returnReadData(const Transaction &trans)
+//bank's implicit state change (see lastCommand) happens delay cycles from now
+void MemoryController::scheduleStateChange(unsigned rank, unsigned bank, unsigned delay)
 {
-	if (parentMemorySystem->ReturnReadData!=NULL)
+	if (delay == 0)
 	{
-		(*parentMemorySystem->ReturnReadData)(parentMemorySystem->systemID, trans.address, currentClockCycle);
+		//a zero countdown never fired
+		bankStates[rank][bank].stateChangeCycle = 0;
+		return;
 	}
+	bankStates[rank][bank].stateChangeCycle = currentClockCycle + delay;
+	pendingStateChanges.push(StateChange(currentClockCycle + delay, SEQUENTIAL(rank,bank)));
+}
+
+//copies a transaction into a free slot of the slab, growing it if needed
+unsigned MemoryController::allocateTransaction(const Transaction &trans)
+{
+	if (freeTransactionSlots.empty())
+	{
+		transactionSlab.push_back(trans);
+		return transactionSlab.size() - 1;
+	}
+	unsigned slot = freeTransactionSlots.back();
+	freeTransactionSlots.pop_back();
+	transactionSlab[slot] = trans;
+	return slot;
+}
+
+void MemoryController::releaseTransaction(unsigned slot)
+{
+	freeTransactionSlots.push_back(slot);
+}
+
+//sends read data back to the CPU
+void MemoryController::returnReadData(const Transaction &trans)
+{
+	RequestorState &source = requestorState(trans.requestor);
+	source.reads++;
+	source.readLatencies.record(currentClockCycle - trans.timeAdded);
+	parentMemorySystem->transactionDone(false, trans.address, currentClockCycle);
 }
 
 //gives the memory controller a handle on the rank objects
@@ -141,38 +221,37 @@ void MemoryController::update()
 
 	//PRINT(" ------------------------- [" << currentClockCycle << "] -------------------------");
 
-	//update bank states
-	for (size_t i=0;i<NUM_RANKS;i++)
+	//update bank states whose implicit state change is due
+	while (!pendingStateChanges.empty() && pendingStateChanges.top().first <= currentClockCycle)
 	{
-		for (size_t j=0;j<NUM_BANKS;j++)
+		StateChange change = pendingStateChanges.top();
+		pendingStateChanges.pop();
+		unsigned rank = change.second / config.NUM_BANKS;
+		unsigned bank = change.second % config.NUM_BANKS;
+
+		//the bank was rescheduled after this entry was pushed
+		if (bankStates[rank][bank].stateChangeCycle != change.first)
 		{
-			if (bankStates[i][j].stateChangeCountdown>0)
-			{
-				//decrement counters
-				bankStates[i][j].stateChangeCountdown--;
+			continue;
+		}
+		bankStates[rank][bank].stateChangeCycle = 0;
 
-				//if counter has reached 0, change state
-				if (bankStates[i][j].stateChangeCountdown == 0)
-				{
-					switch (bankStates[i][j].lastCommand)
-					{
-						//only these commands have an implicit state change
-					case WRITE_P:
-					case READ_P:
-						bankStates[i][j].currentBankState = Precharging;
-						bankStates[i][j].lastCommand = PRECHARGE;
-						bankStates[i][j].stateChangeCountdown = tRP;
-						break;
+		switch (bankStates[rank][bank].lastCommand)
+		{
+			//only these commands have an implicit state change
+		case WRITE_P:
+		case READ_P:
+			bankStates[rank][bank].currentBankState = Precharging;
+			bankStates[rank][bank].lastCommand = PRECHARGE;
+			scheduleStateChange(rank, bank, config.tRP);
+			break;
 
-					case REFRESH:
-					case PRECHARGE:
-						bankStates[i][j].currentBankState = Idle;
-						break;
-					default:
-						break;
-					}
-				}
-			}
+		case REFRESH:
+		case PRECHARGE:
+			bankStates[rank][bank].currentBankState = Idle;
+			break;
+		default:
+			break;
 		}
 	}
 
@@ -195,10 +274,7 @@ void MemoryController::update()
 		if (dataCyclesLeft == 0)
 		{
 			//inform upper levels that a write is done
-			if (parentMemorySystem->WriteDataDone!=NULL)
-			{
-				(*parentMemorySystem->WriteDataDone)(parentMemorySystem->systemID,outgoingDataPacket->physicalAddress, currentClockCycle);
-			}
+			parentMemorySystem->transactionDone(true, outgoingDataPacket->physicalAddress, currentClockCycle);
 
 			(*ranks)[outgoingDataPacket->rank].receiveFromBus(outgoingDataPacket);
 			outgoingDataPacket=NULL;
@@ -210,18 +286,13 @@ void MemoryController::update()
 	//and the appropriate amount of time has passed (WL)
 	//then send data on bus
 	//
-	//write data held in fifo vector along with countdowns
-	if (writeDataCountdown.size() > 0)
+	//write data held in fifo vector along with the cycle it is due
+	if (writeDataCycle.size() > 0)
 	{
-		for (size_t i=0;i<writeDataCountdown.size();i++)
-		{
-			writeDataCountdown[i]--;
-		}
-
-		if (writeDataCountdown[0]==0)
+		if (writeDataCycle[0] <= currentClockCycle)
 		{
 			//send to bus and print debug stuff
-			if (DEBUG_BUS)
+			if (config.DEBUG_BUS)
 			{
 				PRINTN(" -- MC Issuing On Data Bus    : ");
 				writeDataToSend[0]->print();
@@ -235,35 +306,73 @@ void MemoryController::update()
 			}
 
 			outgoingDataPacket = writeDataToSend[0];
-			dataCyclesLeft = BL/2;
+			dataCyclesLeft = config.BL/2;
 
 			totalTransactions++;
 			totalWritesPerBank[SEQUENTIAL(writeDataToSend[0]->rank,writeDataToSend[0]->bank)]++;
 
-			writeDataCountdown.erase(writeDataCountdown.begin());
+			writeDataCycle.erase(writeDataCycle.begin());
 			writeDataToSend.erase(writeDataToSend.begin());
 		}
 	}
 
-	//if its time for a refresh issue a refresh
-	// else pop from command queue if it's not empty
+	//if its time for a refresh the rank owes one more
 	if (refreshCountdown[refreshRank]==0)
 	{
-		commandQueue.needRefresh(refreshRank);
-		(*ranks)[refreshRank].refreshWaiting = true;
-		refreshCountdown[refreshRank] =	 REFRESH_PERIOD/tCK;
+		refreshesOwed[refreshRank]++;
+		if (refreshesOwed[refreshRank] > config.REFRESH_POSTPONE+1)
+		{
+			ERROR("== Error - rank "<<refreshRank<<" fell "<<refreshesOwed[refreshRank]<<" refreshes behind");
+			exit(-1);
+		}
+		mostRefreshesOwed = max(mostRefreshesOwed, refreshesOwed[refreshRank]);
+		refreshCountdown[refreshRank] =	 refreshInterval();
 		refreshRank++;
-		if (refreshRank == NUM_RANKS)
+		if (refreshRank == config.NUM_RANKS)
 		{
 			refreshRank = 0;
 		}
 	}
 	//if a rank is powered down, make sure we power it up in time for a refresh
-	else if (powerDown[refreshRank] && refreshCountdown[refreshRank] <= tXP)
+	else if (powerDown[refreshRank] && refreshCountdown[refreshRank] <= config.tXP)
 	{
 		(*ranks)[refreshRank].refreshWaiting = true;
 	}
 
+	//hand the command queue the next refresh owed (one at a time)
+	// then pop from command queue if it's not empty
+	if (!commandQueue.refreshPending())
+	{
+		for (size_t i=0;i<config.NUM_RANKS;i++)
+		{
+			unsigned r = (refreshRank + i) % config.NUM_RANKS;
+			if (refreshesOwed[r] == 0 || postponeRefresh(r))
+				continue;
+			commandQueue.needRefresh(r, refreshBank[r]);
+			(*ranks)[r].refreshWaiting = true;
+			refreshesOwed[r]--;
+			refreshesIssued++;
+			if (config.refreshPolicy == PerBankRefresh)
+			{
+				refreshBank[r] = (refreshBank[r] + 1) % config.NUM_BANKS;
+			}
+			break;
+		}
+	}
+	//once a rank owes more than it may put off, the waiting refresh (which
+	//the others queue behind) can't wait for row hits any more
+	if (commandQueue.refreshPending())
+	{
+		for (size_t r=0;r<config.NUM_RANKS;r++)
+		{
+			if (refreshesOwed[r] > config.REFRESH_POSTPONE)
+			{
+				commandQueue.hurryRefresh();
+				break;
+			}
+		}
+	}
+
 	//pass a pointer to a poppedBusPacket
 
 	//function returns true if there is something valid in poppedBusPacket
@@ -272,10 +381,10 @@ void MemoryController::update()
 		if (poppedBusPacket->busPacketType == WRITE || poppedBusPacket->busPacketType == WRITE_P)
 		{
 
-			writeDataToSend.push_back(new BusPacket(DATA, poppedBusPacket->physicalAddress, poppedBusPacket->column,
+			writeDataToSend.push_back(busPacketPool.allocate(DATA, poppedBusPacket->physicalAddress, poppedBusPacket->column,
 			                                    poppedBusPacket->row, poppedBusPacket->rank, poppedBusPacket->bank,
 			                                    poppedBusPacket->data));
-			writeDataCountdown.push_back(WL);
+			writeDataCycle.push_back(currentClockCycle + config.WL);
 		}
 
 		//
@@ -289,46 +398,48 @@ void MemoryController::update()
 			case READ_P:
 			case READ:
 				//add energy to account for total
-				if (DEBUG_POWER)
+				if (config.DEBUG_POWER)
 				{
 					PRINT(" ++ Adding Read energy to total energy");
 				}
-				burstEnergy[rank] += (IDD4R - IDD3N) * BL/2 * NUM_DEVICES;
+				burstEnergy[rank] += (config.IDD4R - config.IDD3N) * config.BL/2 * config.NUM_DEVICES;
+				readsIssued++;
+				dataBusCycles += config.BL/2;
 				if (poppedBusPacket->busPacketType == READ_P) 
 				{
 					//Don't bother setting next read or write times because the bank is no longer active
 					//bankStates[rank][bank].currentBankState = Idle;
-					bankStates[rank][bank].nextActivate = max(currentClockCycle + READ_AUTOPRE_DELAY,
+					bankStates[rank][bank].nextActivate = max(currentClockCycle + config.READ_AUTOPRE_DELAY,
 							bankStates[rank][bank].nextActivate);
 					bankStates[rank][bank].lastCommand = READ_P;
-					bankStates[rank][bank].stateChangeCountdown = READ_TO_PRE_DELAY;
+					scheduleStateChange(rank, bank, config.READ_TO_PRE_DELAY);
 				}
 				else if (poppedBusPacket->busPacketType == READ)
 				{
-					bankStates[rank][bank].nextPrecharge = max(currentClockCycle + READ_TO_PRE_DELAY,
+					bankStates[rank][bank].nextPrecharge = max(currentClockCycle + config.READ_TO_PRE_DELAY,
 							bankStates[rank][bank].nextPrecharge);
 					bankStates[rank][bank].lastCommand = READ;
 
 				}
 
-				for (size_t i=0;i<NUM_RANKS;i++)
+				for (size_t i=0;i<config.NUM_RANKS;i++)
 				{
-					for (size_t j=0;j<NUM_BANKS;j++)
+					for (size_t j=0;j<config.NUM_BANKS;j++)
 					{
 						if (i!=poppedBusPacket->rank)
 						{
 							//check to make sure it is active before trying to set (save's time?)
 							if (bankStates[i][j].currentBankState == RowActive)
 							{
-								bankStates[i][j].nextRead = max(currentClockCycle + BL/2 + tRTRS, bankStates[i][j].nextRead);
-								bankStates[i][j].nextWrite = max(currentClockCycle + READ_TO_WRITE_DELAY,
+								bankStates[i][j].nextRead = max(currentClockCycle + config.BL/2 + config.tRTRS, bankStates[i][j].nextRead);
+								bankStates[i][j].nextWrite = max(currentClockCycle + config.READ_TO_WRITE_DELAY,
 										bankStates[i][j].nextWrite);
 							}
 						}
 						else
 						{
-							bankStates[i][j].nextRead = max(currentClockCycle + max(tCCD, BL/2), bankStates[i][j].nextRead);
-							bankStates[i][j].nextWrite = max(currentClockCycle + READ_TO_WRITE_DELAY,
+							bankStates[i][j].nextRead = max(currentClockCycle + max(config.tCCD, config.BL/2), bankStates[i][j].nextRead);
+							bankStates[i][j].nextWrite = max(currentClockCycle + config.READ_TO_WRITE_DELAY,
 									bankStates[i][j].nextWrite);
 						}
 					}
@@ -348,43 +459,45 @@ void MemoryController::update()
 			case WRITE:
 				if (poppedBusPacket->busPacketType == WRITE_P) 
 				{
-					bankStates[rank][bank].nextActivate = max(currentClockCycle + WRITE_AUTOPRE_DELAY,
+					bankStates[rank][bank].nextActivate = max(currentClockCycle + config.WRITE_AUTOPRE_DELAY,
 							bankStates[rank][bank].nextActivate);
 					bankStates[rank][bank].lastCommand = WRITE_P;
-					bankStates[rank][bank].stateChangeCountdown = WRITE_TO_PRE_DELAY;
+					scheduleStateChange(rank, bank, config.WRITE_TO_PRE_DELAY);
 				}
 				else if (poppedBusPacket->busPacketType == WRITE)
 				{
-					bankStates[rank][bank].nextPrecharge = max(currentClockCycle + WRITE_TO_PRE_DELAY,
+					bankStates[rank][bank].nextPrecharge = max(currentClockCycle + config.WRITE_TO_PRE_DELAY,
 							bankStates[rank][bank].nextPrecharge);
 					bankStates[rank][bank].lastCommand = WRITE;
 				}
 
 
 				//add energy to account for total
-				if (DEBUG_POWER)
+				if (config.DEBUG_POWER)
 				{
 					PRINT(" ++ Adding Write energy to total energy");
 				}
-				burstEnergy[rank] += (IDD4W - IDD3N) * BL/2 * NUM_DEVICES;
+				burstEnergy[rank] += (config.IDD4W - config.IDD3N) * config.BL/2 * config.NUM_DEVICES;
+				writesIssued++;
+				dataBusCycles += config.BL/2;
 
-				for (size_t i=0;i<NUM_RANKS;i++)
+				for (size_t i=0;i<config.NUM_RANKS;i++)
 				{
-					for (size_t j=0;j<NUM_BANKS;j++)
+					for (size_t j=0;j<config.NUM_BANKS;j++)
 					{
 						if (i!=poppedBusPacket->rank)
 						{
 							if (bankStates[i][j].currentBankState == RowActive)
 							{
-								bankStates[i][j].nextWrite = max(currentClockCycle + BL/2 + tRTRS, bankStates[i][j].nextWrite);
-								bankStates[i][j].nextRead = max(currentClockCycle + WRITE_TO_READ_DELAY_R,
+								bankStates[i][j].nextWrite = max(currentClockCycle + config.BL/2 + config.tRTRS, bankStates[i][j].nextWrite);
+								bankStates[i][j].nextRead = max(currentClockCycle + config.WRITE_TO_READ_DELAY_R,
 										bankStates[i][j].nextRead);
 							}
 						}
 						else
 						{
-							bankStates[i][j].nextWrite = max(currentClockCycle + max(BL/2, tCCD), bankStates[i][j].nextWrite);
-							bankStates[i][j].nextRead = max(currentClockCycle + WRITE_TO_READ_DELAY_B,
+							bankStates[i][j].nextWrite = max(currentClockCycle + max(config.BL/2, config.tCCD), bankStates[i][j].nextWrite);
+							bankStates[i][j].nextRead = max(currentClockCycle + config.WRITE_TO_READ_DELAY_B,
 									bankStates[i][j].nextRead);
 						}
 					}
@@ -402,28 +515,28 @@ void MemoryController::update()
 				break;
 			case ACTIVATE:
 				//add energy to account for total
-				if (DEBUG_POWER)
+				if (config.DEBUG_POWER)
 				{
 					PRINT(" ++ Adding Activate and Precharge energy to total energy");
 				}
-				actpreEnergy[rank] += ((IDD0 * tRC) - ((IDD3N * tRAS) + (IDD2N * (tRC - tRAS)))) * NUM_DEVICES;
+				actpreEnergy[rank] += ((config.IDD0 * config.tRC) - ((config.IDD3N * config.tRAS) + (config.IDD2N * (config.tRC - config.tRAS)))) * config.NUM_DEVICES;
 
 				bankStates[rank][bank].currentBankState = RowActive;
 				bankStates[rank][bank].lastCommand = ACTIVATE;
 				bankStates[rank][bank].openRowAddress = poppedBusPacket->row;
-				bankStates[rank][bank].nextActivate = max(currentClockCycle + tRC, bankStates[rank][bank].nextActivate);
-				bankStates[rank][bank].nextPrecharge = max(currentClockCycle + tRAS, bankStates[rank][bank].nextPrecharge);
+				bankStates[rank][bank].nextActivate = max(currentClockCycle + config.tRC, bankStates[rank][bank].nextActivate);
+				bankStates[rank][bank].nextPrecharge = max(currentClockCycle + config.tRAS, bankStates[rank][bank].nextPrecharge);
 
 				//if we are using posted-CAS, the next column access can be sooner than normal operation
 
-				bankStates[rank][bank].nextRead = max(currentClockCycle + (tRCD-AL), bankStates[rank][bank].nextRead);
-				bankStates[rank][bank].nextWrite = max(currentClockCycle + (tRCD-AL), bankStates[rank][bank].nextWrite);
+				bankStates[rank][bank].nextRead = max(currentClockCycle + (config.tRCD-config.AL), bankStates[rank][bank].nextRead);
+				bankStates[rank][bank].nextWrite = max(currentClockCycle + (config.tRCD-config.AL), bankStates[rank][bank].nextWrite);
 
-				for (size_t i=0;i<NUM_BANKS;i++)
+				for (size_t i=0;i<config.NUM_BANKS;i++)
 				{
 					if (i!=poppedBusPacket->bank)
 					{
-						bankStates[rank][i].nextActivate = max(currentClockCycle + tRRD, bankStates[rank][i].nextActivate);
+						bankStates[rank][i].nextActivate = max(currentClockCycle + config.tRRD, bankStates[rank][i].nextActivate);
 					}
 				}
 
@@ -431,24 +544,35 @@ void MemoryController::update()
 			case PRECHARGE:
 				bankStates[rank][bank].currentBankState = Precharging;
 				bankStates[rank][bank].lastCommand = PRECHARGE;
-				bankStates[rank][bank].stateChangeCountdown = tRP;
-				bankStates[rank][bank].nextActivate = max(currentClockCycle + tRP, bankStates[rank][bank].nextActivate);
+				scheduleStateChange(rank, bank, config.tRP);
+				bankStates[rank][bank].nextActivate = max(currentClockCycle + config.tRP, bankStates[rank][bank].nextActivate);
 
 				break;
 			case REFRESH:
 				//add energy to account for total
-				if (DEBUG_POWER)
+				if (config.DEBUG_POWER)
 				{
 					PRINT(" ++ Adding Refresh energy to total energy");
 				}
-				refreshEnergy[rank] += (IDD5 - IDD3N) * tRFC * NUM_DEVICES;
+				if (config.refreshPolicy == PerBankRefresh)
+				{
+					//no IDD5 for a single bank, so charge each bank its share of an all bank refresh
+					refreshEnergy[rank] += (config.IDD5 - config.IDD3N) * config.tRFC * config.NUM_DEVICES / config.NUM_BANKS;
+
+					bankStates[rank][bank].nextActivate = currentClockCycle + config.tRFCpb;
+					bankStates[rank][bank].currentBankState = Refreshing;
+					bankStates[rank][bank].lastCommand = REFRESH;
+					scheduleStateChange(rank, bank, config.tRFCpb);
+					break;
+				}
+				refreshEnergy[rank] += (config.IDD5 - config.IDD3N) * config.tRFC * config.NUM_DEVICES;
 
-				for (size_t i=0;i<NUM_BANKS;i++)
+				for (size_t i=0;i<config.NUM_BANKS;i++)
 				{
-					bankStates[rank][i].nextActivate = currentClockCycle + tRFC;
+					bankStates[rank][i].nextActivate = currentClockCycle + config.tRFC;
 					bankStates[rank][i].currentBankState = Refreshing;
 					bankStates[rank][i].lastCommand = REFRESH;
-					bankStates[rank][i].stateChangeCountdown = tRFC;
+					scheduleStateChange(rank, i, config.tRFC);
 				}
 
 				break;
@@ -458,7 +582,7 @@ void MemoryController::update()
 		}
 
 		//issue on bus and print debug
-		if (DEBUG_BUS)
+		if (config.DEBUG_BUS)
 		{
 			PRINTN(" -- MC Issuing On Command Bus : ");
 			poppedBusPacket->print();
@@ -471,94 +595,152 @@ void MemoryController::update()
 			exit(-1);
 		}
 		outgoingCmdPacket = poppedBusPacket;
-		cmdCyclesLeft = tCMD;
+		cmdCyclesLeft = config.tCMD;
 
 	}
 
-	for (size_t i=0;i<transactionQueue.size();i++)
+	//with a write queue, writes go to the command queue in batches: from when
+	//the write queue reaches the high watermark until it is back down to the
+	//low one, and whenever no reads are waiting. a batch is never more than
+	//HIGH-LOW writes, and after a batch that was cut short the reads that
+	//waited through it go before the next one; otherwise writes arriving as
+	//fast as they drain would keep reads out forever
+	if (config.WRITE_QUEUE_DEPTH > 0)
 	{
-		//pop off top transaction from queue
-		//
-		//	assuming simple scheduling at the moment
-		//	will eventually add policies here
-		Transaction transaction = transactionQueue[i];
+		if (transactionQueue.empty() || transactionSlab[transactionQueue[0]].timeAdded > lastDrainEnd)
+		{
+			readsFirst = false;
+		}
+		if (!drainingWrites && !readsFirst && writeQueue.size() >= config.WRITE_HIGH_WATERMARK)
+		{
+			drainingWrites = true;
+			drainBudget = config.WRITE_HIGH_WATERMARK - config.WRITE_LOW_WATERMARK;
+			writeDrains++;
+		}
+		else if (drainingWrites && (writeQueue.size() <= config.WRITE_LOW_WATERMARK || drainBudget == 0))
+		{
+			drainingWrites = false;
+			readsFirst = drainBudget == 0;
+			lastDrainEnd = currentClockCycle;
+		}
+	}
+	vector<unsigned> &sourceQueue = (drainingWrites || transactionQueue.empty()) ? writeQueue : transactionQueue;
+
+	//the oldest transaction that fits in the command queue moves on; with
+	//REQUESTOR_PRIORITIES, the oldest of the highest priority that fits
+	size_t chosen = sourceQueue.size();
+	unsigned chosenPriority = 0;
+	unsigned newTransactionRank=0, newTransactionBank=0, newTransactionRow=0, newTransactionColumn=0;
+	for (size_t i=0;i<sourceQueue.size();i++)
+	{
+		const Transaction &transaction = transactionSlab[sourceQueue[i]];
+		unsigned priority = requestorPriority(transaction.requestor);
+		if (chosen < sourceQueue.size() && priority <= chosenPriority)
+		{
+			continue;
+		}
 
 		//map address to rank,bank,row,col
-		unsigned newTransactionChan, newTransactionRank, newTransactionBank, newTransactionRow, newTransactionColumn;
-
-		// pass these in as references so they get set by the addressMapping function
-		addressMapping(transaction.address, newTransactionChan, newTransactionRank, newTransactionBank, newTransactionRow, newTransactionColumn);
+		unsigned chan, rank, bank, row, column;
+		addressMapping(config, transaction.address, chan, rank, bank, row, column);
 
-		//if we have room, break up the transaction into the appropriate commands
-		//and add them to the command queue
-		if (commandQueue.hasRoomFor(2, newTransactionRank, newTransactionBank))
+		if (commandQueue.hasRoomFor(2, rank, bank))
 		{
-			if (DEBUG_ADDR_MAP) 
+			chosen = i;
+			chosenPriority = priority;
+			newTransactionRank = rank;
+			newTransactionBank = bank;
+			newTransactionRow = row;
+			newTransactionColumn = column;
+			if (priority == maxRequestorPriority)
 			{
-				PRINTN("== New Transaction - Mapping Address [0x" << hex << transaction.address << dec << "]");
-				if (transaction.transactionType == DATA_READ) 
-				{
-					PRINT(" (Read)");
-				}
-				else
-				{
-					PRINT(" (Write)");
-				}
-				PRINT("  Rank : " << newTransactionRank);
-				PRINT("  Bank : " << newTransactionBank);
-				PRINT("  Row  : " << newTransactionRow);
-				PRINT("  Col  : " << newTransactionColumn);
+				break;
 			}
+		}
+	}
 
-			// If we have a read, save the transaction so when the data comes back
-			// in a bus packet, we can staple it back into a transaction and return it
-			if (transaction.transactionType == DATA_READ)
+	//break up the transaction into the appropriate commands and add them to
+	//the command queue
+	if (chosen < sourceQueue.size())
+	{
+		unsigned slot = sourceQueue[chosen];
+		const Transaction &transaction = transactionSlab[slot];
+		if (config.DEBUG_ADDR_MAP) 
+		{
+			PRINTN("== New Transaction - Mapping Address [0x" << hex << transaction.address << dec << "]");
+			if (transaction.transactionType == DATA_READ) 
 			{
-				pendingReadTransactions.push_back(transaction);
+				PRINT(" (Read)");
 			}
+			else
+			{
+				PRINT(" (Write)");
+			}
+			PRINT("  Rank : " << newTransactionRank);
+			PRINT("  Bank : " << newTransactionBank);
+			PRINT("  Row  : " << newTransactionRow);
+			PRINT("  Col  : " << newTransactionColumn);
+		}
 
-			//now that we know there is room in the command queue, we can remove from the transaction queue
-			transactionQueue.erase(transactionQueue.begin()+i);
-
-			//create activate command to the row we just translated
-			BusPacket *ACTcommand = new BusPacket(ACTIVATE, transaction.address,
-					newTransactionColumn, newTransactionRow, newTransactionRank,
-					newTransactionBank, 0);
-
-			//create read or write command and enqueue it
-			BusPacketType bpType = transaction.getBusPacketType();
-			BusPacket *command = new BusPacket(bpType, transaction.address,
-					newTransactionColumn, newTransactionRow, newTransactionRank,
-					newTransactionBank, transaction.data);
-
-			/* only allow one transaction to be scheduled per cycle -- this should
-			 * be a reasonable assumption considering how much logic would be
-			 * required to schedule multiple entries per cycle (parallel data
-			 * lines, switching logic, decision logic)
-			 */
-			commandQueue.enqueue(ACTcommand);
-			commandQueue.enqueue(command);
-			break;
+		// If we have a read, save the transaction so when the data comes back
+		// in a bus packet, we can staple it back into a transaction and return it
+		RequestorState &source = requestorState(transaction.requestor);
+		if (transaction.transactionType == DATA_READ)
+		{
+			pendingReadTransactions.push_back(slot);
+		}
+		else
+		{
+			source.writes++;
 		}
-		else // no room, do nothing this cycle
+
+		//now that we know there is room in the command queue, we can remove from the transaction queue
+		sourceQueue.erase(sourceQueue.begin()+chosen);
+		source.queued--;
+		if (drainingWrites && drainBudget > 0)
 		{
-			//PRINT( "== Warning - No room in command queue" << endl;
+			drainBudget--;
+		}
+
+		//create activate command to the row we just translated
+		BusPacket *ACTcommand = busPacketPool.allocate(ACTIVATE, transaction.address,
+				newTransactionColumn, newTransactionRow, newTransactionRank,
+				newTransactionBank, 0);
+
+		//create read or write command and enqueue it
+		BusPacketType bpType = transaction.getBusPacketType(config.rowBufferPolicy);
+		BusPacket *command = busPacketPool.allocate(bpType, transaction.address,
+				newTransactionColumn, newTransactionRow, newTransactionRank,
+				newTransactionBank, transaction.data);
+
+		/* only allow one transaction to be scheduled per cycle -- this should
+		 * be a reasonable assumption considering how much logic would be
+		 * required to schedule multiple entries per cycle (parallel data
+		 * lines, switching logic, decision logic)
+		 */
+		commandQueue.enqueue(ACTcommand);
+		commandQueue.enqueue(command);
+
+		//writes are done with once their commands are queued
+		if (transaction.transactionType != DATA_READ)
+		{
+			releaseTransaction(slot);
 		}
 	}
 
 
 	//calculate power
 	//  this is done on a per-rank basis, since power characterization is done per device (not per bank)
-	for (size_t i=0;i<NUM_RANKS;i++)
+	for (size_t i=0;i<config.NUM_RANKS;i++)
 	{
-		if (USE_LOW_POWER)
+		if (config.USE_LOW_POWER)
 		{
 			//if there are no commands in the queue and that particular rank is not waiting for a refresh...
 			if (commandQueue.isEmpty(i) && !(*ranks)[i].refreshWaiting)
 			{
 				//check to make sure all banks are idle
 				bool allIdle = true;
-				for (size_t j=0;j<NUM_BANKS;j++)
+				for (size_t j=0;j<config.NUM_BANKS;j++)
 				{
 					if (bankStates[i][j].currentBankState != Idle)
 					{
@@ -572,10 +754,10 @@ void MemoryController::update()
 				{
 					powerDown[i] = true;
 					(*ranks)[i].powerDown();
-					for (size_t j=0;j<NUM_BANKS;j++)
+					for (size_t j=0;j<config.NUM_BANKS;j++)
 					{
 						bankStates[i][j].currentBankState = PowerDown;
-						bankStates[i][j].nextPowerUp = currentClockCycle + tCKE;
+						bankStates[i][j].nextPowerUp = currentClockCycle + config.tCKE;
 					}
 				}
 			}
@@ -584,17 +766,17 @@ void MemoryController::update()
 			{
 				powerDown[i] = false;
 				(*ranks)[i].powerUp();
-				for (size_t j=0;j<NUM_BANKS;j++)
+				for (size_t j=0;j<config.NUM_BANKS;j++)
 				{
 					bankStates[i][j].currentBankState = Idle;
-					bankStates[i][j].nextActivate = currentClockCycle + tXP;
+					bankStates[i][j].nextActivate = currentClockCycle + config.tXP;
 				}
 			}
 		}
 
 		//check for open bank
 		bool bankOpen = false;
-		for (size_t j=0;j<NUM_BANKS;j++)
+		for (size_t j=0;j<config.NUM_BANKS;j++)
 		{
 			if (bankStates[i][j].currentBankState == Refreshing ||
 			        bankStates[i][j].currentBankState == RowActive)
@@ -607,48 +789,64 @@ void MemoryController::update()
 		//background power is dependent on whether or not a bank is open or not
 		if (bankOpen)
 		{
-			if (DEBUG_POWER)
+			if (config.DEBUG_POWER)
 			{
 				PRINT(" ++ Adding IDD3N to total energy [from rank "<< i <<"]");
 			}
-			backgroundEnergy[i] += IDD3N * NUM_DEVICES;
+			backgroundEnergy[i] += config.IDD3N * config.NUM_DEVICES;
 		}
 		else
 		{
 			//if we're in power-down mode, use the correct current
 			if (powerDown[i])
 			{
-				if (DEBUG_POWER)
+				if (config.DEBUG_POWER)
 				{
 					PRINT(" ++ Adding IDD2P to total energy [from rank " << i << "]");
 				}
-				backgroundEnergy[i] += IDD2P * NUM_DEVICES;
+				backgroundEnergy[i] += config.IDD2P * config.NUM_DEVICES;
 			}
 			else
 			{
-				if (DEBUG_POWER)
+				if (config.DEBUG_POWER)
 				{
 					PRINT(" ++ Adding IDD2N to total energy [from rank " << i << "]");
 				}
-				backgroundEnergy[i] += IDD2N * NUM_DEVICES;
+				backgroundEnergy[i] += config.IDD2N * config.NUM_DEVICES;
 			}
 		}
 	}
 
+	//reads that were answered from the write queue
+	for (size_t i=0;i<forwardedReads.size();i++)
+	{
+		Transaction &read = transactionSlab[forwardedReads[i]];
+		unsigned latency = currentClockCycle - read.timeAdded;
+		unsigned chan,rank,bank,row,col;
+		addressMapping(config, read.address,chan,rank,bank,row,col);
+		insertHistogram(latency,rank,bank);
+		insertDrainHistogram(read, latency);
+		returnReadData(read);
+		releaseTransaction(forwardedReads[i]);
+	}
+	forwardedReads.clear();
+
 	//check for outstanding data to return to the CPU
 	if (returnTransaction.size()>0)
 	{
-		if (DEBUG_BUS)
+		const Transaction &returned = transactionSlab[returnTransaction[0]];
+		if (config.DEBUG_BUS)
 		{
 			PRINTN(" -- MC Issuing to CPU bus : ");
-			returnTransaction[0].print();
+			transactionSlab[returnTransaction[0]].print();
 		}
 		totalTransactions++;
 
 		//find the pending read transaction to calculate latency
 		for (size_t i=0;i<pendingReadTransactions.size();i++)
 		{
-			if (pendingReadTransactions[i].address == returnTransaction[0].address)
+			const Transaction &pending = transactionSlab[pendingReadTransactions[i]];
+			if (pending.address == returned.address)
 			{
 				//if(currentClockCycle - pendingReadTransactions[i].timeAdded > 2000)
 				//	{
@@ -656,20 +854,23 @@ void MemoryController::update()
 				//		exit(0);
 				//	}
 				unsigned chan,rank,bank,row,col;
-				addressMapping(returnTransaction[0].address,chan,rank,bank,row,col);
-				insertHistogram(currentClockCycle-pendingReadTransactions[i].timeAdded,rank,bank);
+				addressMapping(config, returned.address,chan,rank,bank,row,col);
+				insertHistogram(currentClockCycle-pending.timeAdded,rank,bank);
+				insertDrainHistogram(pending, currentClockCycle-pending.timeAdded);
 				//return latency
-				returnReadData(pendingReadTransactions[i]);
+				returnReadData(pending);
 
+				releaseTransaction(pendingReadTransactions[i]);
 				pendingReadTransactions.erase(pendingReadTransactions.begin()+i);
 				break;
 			}
 		}
+		releaseTransaction(returnTransaction[0]);
 		returnTransaction.erase(returnTransaction.begin());
 	}
 
 	//decrement refresh counters
-	for (size_t i=0;i<NUM_RANKS;i++)
+	for (size_t i=0;i<config.NUM_RANKS;i++)
 	{
 		refreshCountdown[i]--;
 	}
@@ -677,23 +878,32 @@ void MemoryController::update()
 	//
 	//print debug
 	//
-	if (DEBUG_TRANS_Q)
+	if (config.DEBUG_TRANS_Q)
 	{
 		PRINT("== Printing transaction queue");
 		for (size_t i=0;i<transactionQueue.size();i++)
 		{
 			PRINTN("  " << i << "]");
-			transactionQueue[i].print();
+			transactionSlab[transactionQueue[i]].print();
+		}
+		if (config.WRITE_QUEUE_DEPTH > 0)
+		{
+			PRINT("== Printing write queue" << (drainingWrites ? " (draining)" : ""));
+			for (size_t i=0;i<writeQueue.size();i++)
+			{
+				PRINTN("  " << i << "]");
+				transactionSlab[writeQueue[i]].print();
+			}
 		}
 	}
 
-	if (DEBUG_BANKSTATE)
+	if (config.DEBUG_BANKSTATE)
 	{
 		//TODO: move this to BankState.cpp
 		PRINT("== Printing bank states (According to MC)");
-		for (size_t i=0;i<NUM_RANKS;i++)
+		for (size_t i=0;i<config.NUM_RANKS;i++)
 		{
-			for (size_t j=0;j<NUM_BANKS;j++)
+			for (size_t j=0;j<config.NUM_BANKS;j++)
 			{
 				if (bankStates[i][j].currentBankState == RowActive)
 				{
@@ -720,28 +930,40 @@ void MemoryController::update()
 		}
 	}
 
-	if (DEBUG_CMD_Q)
+	if (config.DEBUG_CMD_Q)
 	{
 		commandQueue.print();
 	}
 
+	//transactions still waiting for their column access: the ones in the
+	//transaction queues plus the ones already turned into commands
+	queueDepthSum += transactionQueue.size() + writeQueue.size() + commandQueue.queuedAccesses();
+	unsigned busyBanks = commandQueue.busyBanks();
+	if (busyBanks > 0)
+	{
+		busyBankSum += busyBanks;
+		busyBankCycles++;
+	}
+
 	commandQueue.step();
 
 	//print stats if we're at the end of an epoch
-	if (currentClockCycle % EPOCH_LENGTH == 0)
+	if (currentClockCycle % config.EPOCH_LENGTH == 0)
 	{
 		this->printStats();
 
 		totalTransactions = 0;
-		for (size_t i=0;i<NUM_RANKS;i++)
+		for (size_t i=0;i<config.NUM_RANKS;i++)
 		{
-			for (size_t j=0; j<NUM_BANKS; j++)
+			for (size_t j=0; j<config.NUM_BANKS; j++)
 			{
 				//XXX: this means the bank list won't be printed for partial epochs
 				grandTotalBankAccesses[SEQUENTIAL(i,j)] += totalReadsPerBank[SEQUENTIAL(i,j)] + totalWritesPerBank[SEQUENTIAL(i,j)];
 				totalReadsPerBank[SEQUENTIAL(i,j)] = 0;
 				totalWritesPerBank[SEQUENTIAL(i,j)] = 0;
 				totalEpochLatency[SEQUENTIAL(i,j)] = 0;
+				latencies.add(epochLatencies[SEQUENTIAL(i,j)]);
+				epochLatencies[SEQUENTIAL(i,j)].reset();
 			}
 
 			burstEnergy[i] = 0;
@@ -754,18 +976,79 @@ void MemoryController::update()
 	}
 }
 
+//true if both a read and a write would be accepted
 bool MemoryController::WillAcceptTransaction()
 {
-	return transactionQueue.size() < TRANS_QUEUE_DEPTH;
+	return queueHasRoom(false) && queueHasRoom(true);
+}
+
+//true if a read (or write) from requestor would be accepted; a full write
+//queue does not hold up reads, nor a full transaction queue writes
+bool MemoryController::WillAcceptTransaction(bool isWrite, unsigned requestor)
+{
+	return queueHasRoom(isWrite) && requestorHasRoom(requestor);
+}
+
+bool MemoryController::queueHasRoom(bool isWrite, size_t waiting) const
+{
+	if (isWrite && config.WRITE_QUEUE_DEPTH > 0)
+	{
+		return writeQueue.size() + waiting < config.WRITE_QUEUE_DEPTH;
+	}
+	return transactionQueue.size() + waiting < config.TRANS_QUEUE_DEPTH;
+}
+
+bool MemoryController::requestorHasRoom(unsigned requestor, size_t waiting) const
+{
+	if (requestor >= config.requestorQueueLimits.size() || config.requestorQueueLimits[requestor] == 0)
+	{
+		return true;
+	}
+	unsigned queued = requestor < requestors.size() ? requestors[requestor].queued : 0;
+	return queued + waiting < config.requestorQueueLimits[requestor];
+}
+
+//the requestor's entry, added on its first transaction
+MemoryController::RequestorState &MemoryController::requestorState(unsigned requestor)
+{
+	if (requestor >= requestors.size())
+	{
+		requestors.resize(requestor+1);
+	}
+	return requestors[requestor];
 }
 
 //allows outside source to make request of memory system
 bool MemoryController::addTransaction(Transaction &trans)
 {
-	if (WillAcceptTransaction())
+	if (!requestorHasRoom(trans.requestor))
 	{
+		return false;
+	}
+	if (config.WRITE_QUEUE_DEPTH > 0 && trans.transactionType == DATA_WRITE)
+	{
+		if (writeQueue.size() >= config.WRITE_QUEUE_DEPTH)
+		{
+			return false;
+		}
 		trans.timeAdded = currentClockCycle;
-		transactionQueue.push_back(trans);
+		writeQueue.push_back(allocateTransaction(trans));
+		requestorState(trans.requestor).queued++;
+		return true;
+	}
+
+	trans.timeAdded = currentClockCycle;
+	if (trans.transactionType == DATA_READ && forwardFromWriteQueue(trans))
+	{
+		forwardedReads.push_back(allocateTransaction(trans));
+		readsForwarded++;
+		return true;
+	}
+
+	if (transactionQueue.size() < config.TRANS_QUEUE_DEPTH)
+	{
+		transactionQueue.push_back(allocateTransaction(trans));
+		requestorState(trans.requestor).queued++;
 		return true;
 	}
 	else 
@@ -774,8 +1057,84 @@ bool MemoryController::addTransaction(Transaction &trans)
 	}
 }
 
+//whether a queued write covers the line a read wants
+bool MemoryController::forwardFromWriteQueue(const Transaction &read)
+{
+	uint64_t lineBytes = (config.JEDEC_DATA_BUS_BITS*config.BL)/8;
+	for (size_t i=0;i<writeQueue.size();i++)
+	{
+		if (transactionSlab[writeQueue[i]].address / lineBytes == read.address / lineBytes)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//cycles between the refreshes a rank owes; per bank refresh owes one per
+//bank in the time all bank refresh owes one
+float MemoryController::refreshInterval()
+{
+	if (config.refreshPolicy == PerBankRefresh)
+	{
+		return (config.REFRESH_PERIOD/config.tCK)/config.NUM_BANKS;
+	}
+	return config.REFRESH_PERIOD/config.tCK;
+}
+
+//whether a refresh the rank owes can wait for the reads queued ahead of it;
+//up to REFRESH_POSTPONE refreshes are put off this way and caught up on once
+//the reads are gone
+bool MemoryController::postponeRefresh(unsigned rank)
+{
+	if (refreshesOwed[rank] > config.REFRESH_POSTPONE)
+	{
+		return false;
+	}
+	if (config.refreshPolicy == PerBankRefresh)
+	{
+		return commandQueue.readsQueued(rank, refreshBank[rank]);
+	}
+	for (size_t b=0;b<config.NUM_BANKS;b++)
+	{
+		if (commandQueue.readsQueued(rank, b))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
 
 //prints statistics at the end of an epoch or  simulation
+void MemoryController::addBinaryStatsColumns(BinaryStatsWriter *writer)
+{
+	unsigned myChannel = parentMemorySystem->systemID;
+	binaryStatsOut = writer;
+	firstStatsColumn = writer->numColumns();
+	// the names and order of the csv output
+	if (myChannel == 0)
+	{
+		writer->addColumn("ms");
+	}
+	for (size_t r=0; r<config.NUM_RANKS; r++)
+	{
+		writer->addColumn(CSVWriter::IndexedName("Background_Power",myChannel,r).str);
+		writer->addColumn(CSVWriter::IndexedName("ACT_PRE_Power",myChannel,r).str);
+		writer->addColumn(CSVWriter::IndexedName("Burst_Power",myChannel,r).str);
+		writer->addColumn(CSVWriter::IndexedName("Refresh_Power",myChannel,r).str);
+		for (size_t b=0; b<config.NUM_BANKS; b++)
+		{
+			writer->addColumn(CSVWriter::IndexedName("Bandwidth",myChannel,r,b).str);
+			writer->addColumn(CSVWriter::IndexedName("Average_Latency",myChannel,r,b).str);
+		}
+		writer->addColumn(CSVWriter::IndexedName("Rank_Aggregate_Bandwidth",myChannel,r).str);
+		writer->addColumn(CSVWriter::IndexedName("Rank_Average_Bandwidth",myChannel,r).str);
+	}
+	writer->addColumn(CSVWriter::IndexedName("Aggregate_Bandwidth",myChannel).str);
+	writer->addColumn(CSVWriter::IndexedName("Average_Bandwidth",myChannel).str);
+}
+
 void MemoryController::printStats(bool finalStats)
 {
 	unsigned myChannel = parentMemorySystem->systemID;
@@ -785,29 +1144,31 @@ void MemoryController::printStats(bool finalStats)
 
 	//if we are not at the end of the epoch, make sure to adjust for the actual number of cycles elapsed
 
-	uint64_t cyclesElapsed = (currentClockCycle % EPOCH_LENGTH == 0) ? EPOCH_LENGTH : currentClockCycle % EPOCH_LENGTH;
-	unsigned bytesPerTransaction = (JEDEC_DATA_BUS_BITS*BL)/8;
+	uint64_t cyclesElapsed = (currentClockCycle % config.EPOCH_LENGTH == 0) ? config.EPOCH_LENGTH : currentClockCycle % config.EPOCH_LENGTH;
+	unsigned bytesPerTransaction = (config.JEDEC_DATA_BUS_BITS*config.BL)/8;
 	uint64_t totalBytesTransferred = totalTransactions * bytesPerTransaction;
-	double secondsThisEpoch = (double)cyclesElapsed * tCK * 1E-9;
+	double secondsThisEpoch = (double)cyclesElapsed * config.tCK * 1E-9;
 
 	// only per rank
-	vector<double> backgroundPower = vector<double>(NUM_RANKS,0.0);
-	vector<double> burstPower = vector<double>(NUM_RANKS,0.0);
-	vector<double> refreshPower = vector<double>(NUM_RANKS,0.0);
-	vector<double> actprePower = vector<double>(NUM_RANKS,0.0);
-	vector<double> averagePower = vector<double>(NUM_RANKS,0.0);
+	vector<double> backgroundPower = vector<double>(config.NUM_RANKS,0.0);
+	vector<double> burstPower = vector<double>(config.NUM_RANKS,0.0);
+	vector<double> refreshPower = vector<double>(config.NUM_RANKS,0.0);
+	vector<double> actprePower = vector<double>(config.NUM_RANKS,0.0);
+	vector<double> averagePower = vector<double>(config.NUM_RANKS,0.0);
 
 	// per bank variables
-	vector<double> averageLatency = vector<double>(NUM_RANKS*NUM_BANKS,0.0);
-	vector<double> bandwidth = vector<double>(NUM_RANKS*NUM_BANKS,0.0);
+	vector<double> averageLatency = vector<double>(config.NUM_RANKS*config.NUM_BANKS,0.0);
+	vector<double> bandwidth = vector<double>(config.NUM_RANKS*config.NUM_BANKS,0.0);
 
 	double totalBandwidth=0.0;
-	for (size_t i=0;i<NUM_RANKS;i++)
+	for (size_t i=0;i<config.NUM_RANKS;i++)
 	{
-		for (size_t j=0; j<NUM_BANKS; j++)
+		for (size_t j=0; j<config.NUM_BANKS; j++)
 		{
 			bandwidth[SEQUENTIAL(i,j)] = (((double)(totalReadsPerBank[SEQUENTIAL(i,j)]+totalWritesPerBank[SEQUENTIAL(i,j)]) * (double)bytesPerTransaction)/(1024.0*1024.0*1024.0)) / secondsThisEpoch;
-			averageLatency[SEQUENTIAL(i,j)] = ((float)totalEpochLatency[SEQUENTIAL(i,j)] / (float)(totalReadsPerBank[SEQUENTIAL(i,j)])) * tCK;
+			//over the reads returned this epoch, which include the ones answered
+			//from the write queue that never reached the bank
+			averageLatency[SEQUENTIAL(i,j)] = ((float)totalEpochLatency[SEQUENTIAL(i,j)] / (float)(epochLatencies[SEQUENTIAL(i,j)].count())) * config.tCK;
 			totalBandwidth+=bandwidth[SEQUENTIAL(i,j)];
 			totalReadsPerRank[i] += totalReadsPerBank[SEQUENTIAL(i,j)];
 			totalWritesPerRank[i] += totalWritesPerBank[SEQUENTIAL(i,j)];
@@ -827,12 +1188,20 @@ void MemoryController::printStats(bool finalStats)
 	PRINT( " ("<<totalBytesTransferred <<" bytes) aggregate average bandwidth "<<totalBandwidth<<"GB/s");
 
 	// only the first memory channel should print the timestamp
-	if (VIS_FILE_OUTPUT && myChannel == 0)
+	unsigned column = firstStatsColumn;
+	if (binaryStatsOut != NULL)
 	{
-		csvOut << "ms" <<currentClockCycle * tCK * 1E-6; 
+		if (myChannel == 0)
+		{
+			binaryStatsOut->set(column++, currentClockCycle * config.tCK * 1E-6);
+		}
+	}
+	else if (config.VIS_FILE_OUTPUT && myChannel == 0)
+	{
+		csvOut << "ms" <<currentClockCycle * config.tCK * 1E-6; 
 	}
 	double totalAggregateBandwidth = 0.0;	
-	for (size_t r=0;r<NUM_RANKS;r++)
+	for (size_t r=0;r<config.NUM_RANKS;r++)
 	{
 
 		PRINT( "      -Rank   "<<r<<" : ");
@@ -840,17 +1209,21 @@ void MemoryController::printStats(bool finalStats)
 		PRINT( " ("<<totalReadsPerRank[r] * bytesPerTransaction<<" bytes)");
 		PRINTN( "        -Writes : " << totalWritesPerRank[r]);
 		PRINT( " ("<<totalWritesPerRank[r] * bytesPerTransaction<<" bytes)");
-		for (size_t j=0;j<NUM_BANKS;j++)
+		LatencyHistogram rankLatencies;
+		for (size_t j=0;j<config.NUM_BANKS;j++)
 		{
 			PRINT( "        -Bandwidth / Latency  (Bank " <<j<<"): " <<bandwidth[SEQUENTIAL(r,j)] << " GB/s\t\t" <<averageLatency[SEQUENTIAL(r,j)] << " ns");
+			rankLatencies.add(epochLatencies[SEQUENTIAL(r,j)]);
 		}
+		PRINT( "        -Read latency p50 / p90 / p99 / max : " << rankLatencies.percentile(0.50) << " / " << rankLatencies.percentile(0.90)
+		       << " / " << rankLatencies.percentile(0.99) << " / " << rankLatencies.max() << " cycles");
 
 		// factor of 1000 at the end is to account for the fact that totalEnergy is accumulated in mJ since IDD values are given in mA
-		backgroundPower[r] = ((double)backgroundEnergy[r] / (double)(cyclesElapsed)) * Vdd / 1000.0;
-		burstPower[r] = ((double)burstEnergy[r] / (double)(cyclesElapsed)) * Vdd / 1000.0;
-		refreshPower[r] = ((double) refreshEnergy[r] / (double)(cyclesElapsed)) * Vdd / 1000.0;
-		actprePower[r] = ((double)actpreEnergy[r] / (double)(cyclesElapsed)) * Vdd / 1000.0;
-		averagePower[r] = ((backgroundEnergy[r] + burstEnergy[r] + refreshEnergy[r] + actpreEnergy[r]) / (double)cyclesElapsed) * Vdd / 1000.0;
+		backgroundPower[r] = ((double)backgroundEnergy[r] / (double)(cyclesElapsed)) * config.Vdd / 1000.0;
+		burstPower[r] = ((double)burstEnergy[r] / (double)(cyclesElapsed)) * config.Vdd / 1000.0;
+		refreshPower[r] = ((double) refreshEnergy[r] / (double)(cyclesElapsed)) * config.Vdd / 1000.0;
+		actprePower[r] = ((double)actpreEnergy[r] / (double)(cyclesElapsed)) * config.Vdd / 1000.0;
+		averagePower[r] = ((backgroundEnergy[r] + burstEnergy[r] + refreshEnergy[r] + actpreEnergy[r]) / (double)cyclesElapsed) * config.Vdd / 1000.0;
 
 		if ((*parentMemorySystem->ReportPower)!=NULL)
 		{
@@ -864,7 +1237,25 @@ void MemoryController::printStats(bool finalStats)
 		PRINT( "     -Burst      (watts)     : " << burstPower[r]);
 		PRINT( "     -Refresh    (watts)     : " << refreshPower[r] );
 
-		if (VIS_FILE_OUTPUT)
+		if (binaryStatsOut != NULL)
+		{
+			// same columns as the csv output below
+			binaryStatsOut->set(column++, backgroundPower[r]);
+			binaryStatsOut->set(column++, actprePower[r]);
+			binaryStatsOut->set(column++, burstPower[r]);
+			binaryStatsOut->set(column++, refreshPower[r]);
+			double totalRankBandwidth=0.0;
+			for (size_t b=0; b<config.NUM_BANKS; b++)
+			{
+				binaryStatsOut->set(column++, bandwidth[SEQUENTIAL(r,b)]);
+				totalRankBandwidth += bandwidth[SEQUENTIAL(r,b)];
+				totalAggregateBandwidth += bandwidth[SEQUENTIAL(r,b)];
+				binaryStatsOut->set(column++, averageLatency[SEQUENTIAL(r,b)]);
+			}
+			binaryStatsOut->set(column++, totalRankBandwidth);
+			binaryStatsOut->set(column++, totalRankBandwidth/config.NUM_RANKS);
+		}
+		else if (config.VIS_FILE_OUTPUT)
 		{
 			// write the vis file output
 			csvOut << CSVWriter::IndexedName("Background_Power",myChannel,r) <<backgroundPower[r];
@@ -872,7 +1263,7 @@ void MemoryController::printStats(bool finalStats)
 			csvOut << CSVWriter::IndexedName("Burst_Power",myChannel,r) << burstPower[r];
 			csvOut << CSVWriter::IndexedName("Refresh_Power",myChannel,r) << refreshPower[r];
 			double totalRankBandwidth=0.0;
-			for (size_t b=0; b<NUM_BANKS; b++)
+			for (size_t b=0; b<config.NUM_BANKS; b++)
 			{
 				csvOut << CSVWriter::IndexedName("Bandwidth",myChannel,r,b) << bandwidth[SEQUENTIAL(r,b)];
 				totalRankBandwidth += bandwidth[SEQUENTIAL(r,b)];
@@ -880,42 +1271,108 @@ void MemoryController::printStats(bool finalStats)
 				csvOut << CSVWriter::IndexedName("Average_Latency",myChannel,r,b) << averageLatency[SEQUENTIAL(r,b)];
 			}
 			csvOut << CSVWriter::IndexedName("Rank_Aggregate_Bandwidth",myChannel,r) << totalRankBandwidth; 
-			csvOut << CSVWriter::IndexedName("Rank_Average_Bandwidth",myChannel,r) << totalRankBandwidth/NUM_RANKS; 
+			csvOut << CSVWriter::IndexedName("Rank_Average_Bandwidth",myChannel,r) << totalRankBandwidth/config.NUM_RANKS; 
 		}
 	}
-	if (VIS_FILE_OUTPUT)
+	if (binaryStatsOut != NULL)
+	{
+		binaryStatsOut->set(column++, totalAggregateBandwidth);
+		binaryStatsOut->set(column++, totalAggregateBandwidth / (config.NUM_RANKS*config.NUM_BANKS));
+		// the channels print their stats in turn, the last one ends the row
+		if (myChannel == config.NUM_CHANS-1)
+		{
+			binaryStatsOut->writeRow();
+		}
+	}
+	else if (config.VIS_FILE_OUTPUT)
 	{
 		csvOut << CSVWriter::IndexedName("Aggregate_Bandwidth",myChannel) << totalAggregateBandwidth;
-		csvOut << CSVWriter::IndexedName("Average_Bandwidth",myChannel) << totalAggregateBandwidth / (NUM_RANKS*NUM_BANKS);
+		csvOut << CSVWriter::IndexedName("Average_Bandwidth",myChannel) << totalAggregateBandwidth / (config.NUM_RANKS*config.NUM_BANKS);
 		csvOut.finalize(); 
 	}
 
 	// only print the latency histogram at the end of the simulation since it clogs the output too much to print every epoch
 	if (finalStats)
 	{
-		PRINT( " ---  Latency list ("<<latencies.size()<<")");
+		LatencyHistogram allLatencies;
+		collectReadLatencies(allLatencies, false);
+		unsigned usedBuckets = 0;
+		for (unsigned i=0; i<LatencyHistogram::NUM_BUCKETS; i++)
+		{
+			if (allLatencies.bucketCount(i) > 0)
+				usedBuckets++;
+		}
+
+		PRINT( " ---  Latency list ("<<usedBuckets<<")");
 		PRINT( "       [lat] : #");
-		if (VIS_FILE_OUTPUT)
+		if (config.VIS_FILE_OUTPUT)
 		{
 			(*visDataOut) << "!!HISTOGRAM_DATA"<<endl;
 		}
 
-		map<unsigned,unsigned>::iterator it; //
-		for (it=latencies.begin(); it!=latencies.end(); it++)
+		for (unsigned i=0; i<LatencyHistogram::NUM_BUCKETS; i++)
+		{
+			if (allLatencies.bucketCount(i) == 0)
+				continue;
+			PRINT( "       ["<< LatencyHistogram::bucketLow(i) <<"-"<<LatencyHistogram::bucketHigh(i)<<"] : "<< allLatencies.bucketCount(i) );
+			if (config.VIS_FILE_OUTPUT)
+			{
+				(*visDataOut) << LatencyHistogram::bucketLow(i) <<"="<< allLatencies.bucketCount(i) << endl;
+			}
+		}
+		PRINT( " ---  Read latency p50 / p90 / p99 / max : " << allLatencies.percentile(0.50) << " / " << allLatencies.percentile(0.90)
+		       << " / " << allLatencies.percentile(0.99) << " / " << allLatencies.max() << " cycles");
+
+		PRINT( " ---  Row buffer hits / misses / conflicts");
+		for (size_t r=0;r<config.NUM_RANKS;r++)
+		{
+			PRINT("Rank "<<r<<":");
+			for (size_t b=0;b<config.NUM_BANKS;b++)
+			{
+				const RowBufferCounts &counts = commandQueue.rowBufferCounts[r][b];
+				PRINT( "  b"<<b<<": "<<counts.hits<<" / "<<counts.misses<<" / "<<counts.conflicts);
+			}
+		}
+		PRINT( " ---  Queue depth / bank parallelism / data bus utilization : " << (double)queueDepthSum / currentClockCycle
+		       << " / " << (busyBankCycles ? (double)busyBankSum / busyBankCycles : 0.0)
+		       << " / " << 100.0 * dataBusCycles / currentClockCycle << "%");
+
+		if (config.refreshPolicy == PerBankRefresh || config.REFRESH_POSTPONE > 0)
+		{
+			PRINT( " ---  Refresh : "<<refreshesIssued<<" issued, at most "<<mostRefreshesOwed<<" owed at once");
+		}
+
+		if (requestors.size() > 1)
+		{
+			PRINT( " ---  Requestor reads / writes / read latency mean / p99");
+			for (size_t i=0;i<requestors.size();i++)
+			{
+				const RequestorState &source = requestors[i];
+				PRINT( "  r"<<i<<": "<<source.reads<<" / "<<source.writes<<" / "<<source.readLatencies.mean()
+				       <<" / "<<source.readLatencies.percentile(0.99)<<" cycles");
+			}
+		}
+
+		if (config.WRITE_QUEUE_DEPTH > 0)
 		{
-			PRINT( "       ["<< it->first <<"-"<<it->first+(HISTOGRAM_BIN_SIZE-1)<<"] : "<< it->second );
-			if (VIS_FILE_OUTPUT)
+			PRINT( " ---  Write queue : "<<writeDrains<<" drains, "<<readsForwarded<<" reads forwarded from pending writes");
+			PRINT( " ---  Latency list split by write draining ("<<usedBuckets<<")");
+			PRINT( "       [lat] : # no drain / # drain");
+			for (unsigned i=0; i<LatencyHistogram::NUM_BUCKETS; i++)
 			{
-				(*visDataOut) << it->first <<"="<< it->second << endl;
+				if (allLatencies.bucketCount(i) == 0)
+					continue;
+				uint64_t drained = drainLatencies.bucketCount(i);
+				PRINT( "       ["<< LatencyHistogram::bucketLow(i) <<"-"<<LatencyHistogram::bucketHigh(i)<<"] : "<< allLatencies.bucketCount(i) - drained << " / " << drained );
 			}
 		}
-		if (currentClockCycle % EPOCH_LENGTH == 0)
+		if (currentClockCycle % config.EPOCH_LENGTH == 0)
 		{
 			PRINT( " --- Grand Total Bank usage list");
-			for (size_t i=0;i<NUM_RANKS;i++)
+			for (size_t i=0;i<config.NUM_RANKS;i++)
 			{
 				PRINT("Rank "<<i<<":"); 
-				for (size_t j=0;j<NUM_BANKS;j++)
+				for (size_t j=0;j<config.NUM_BANKS;j++)
 				{
 					PRINT( "  b"<<j<<": "<<grandTotalBankAccesses[SEQUENTIAL(i,j)]);
 				}
@@ -941,10 +1398,74 @@ MemoryController::~MemoryController()
 	//ERROR("MEMORY CONTROLLER DESTRUCTOR");
 	//abort();
 }
+//also counts a read's latency in drainLatencies if the controller drained
+//writes at some point while the read was waiting
+void MemoryController::insertDrainHistogram(const Transaction &read, unsigned latencyValue)
+{
+	if (drainingWrites || (writeDrains > 0 && lastDrainEnd >= read.timeAdded))
+	{
+		drainLatencies.record(latencyValue);
+	}
+}
+
 //inserts a latency into the latency histogram
 void MemoryController::insertHistogram(unsigned latencyValue, unsigned rank, unsigned bank)
 {
 	totalEpochLatency[SEQUENTIAL(rank,bank)] += latencyValue;
-	//poor man's way to bin things.
-	latencies[(latencyValue/HISTOGRAM_BIN_SIZE)*HISTOGRAM_BIN_SIZE]++;
+	epochLatencies[SEQUENTIAL(rank,bank)].record(latencyValue);
+}
+
+void MemoryController::collectStats(MemoryStats &stats) const
+{
+	stats.cycles = currentClockCycle;
+	stats.reads += readsIssued;
+	stats.writes += writesIssued;
+	for (size_t r=0; r<config.NUM_RANKS; r++)
+	{
+		for (size_t b=0; b<config.NUM_BANKS; b++)
+		{
+			const RowBufferCounts &counts = commandQueue.rowBufferCounts[r][b];
+			stats.rowBuffer.hits += counts.hits;
+			stats.rowBuffer.misses += counts.misses;
+			stats.rowBuffer.conflicts += counts.conflicts;
+			stats.bankRowBuffer.push_back(counts);
+		}
+	}
+	stats.averageQueueDepth += queueDepthSum;
+	stats.bankParallelism += busyBankSum;
+	stats.busyCycles += busyBankCycles;
+	stats.busUtilization += dataBusCycles;
+	if (stats.requestors.size() < requestors.size())
+	{
+		stats.requestors.resize(requestors.size());
+	}
+	for (size_t i=0; i<requestors.size(); i++)
+	{
+		stats.requestors[i].reads += requestors[i].reads;
+		stats.requestors[i].writes += requestors[i].writes;
+	}
+}
+
+void MemoryController::collectRequestorLatencies(vector<LatencyHistogram> &histograms) const
+{
+	if (histograms.size() < requestors.size())
+	{
+		histograms.resize(requestors.size());
+	}
+	for (size_t i=0; i<requestors.size(); i++)
+	{
+		histograms[i].add(requestors[i].readLatencies);
+	}
+}
+
+void MemoryController::collectReadLatencies(LatencyHistogram &histogram, bool epochOnly) const
+{
+	if (!epochOnly)
+	{
+		histogram.add(latencies);
+	}
+	for (size_t i=0; i<epochLatencies.size(); i++)
+	{
+		histogram.add(epochLatencies[i]);
+	}
 }
@@ -45,7 +45,11 @@
 #include "BankState.h"
 #include "Rank.h"
 #include "CSVWriter.h"
+#include "BinaryStatsWriter.h"
+#include "LatencyHistogram.h"
 #include <map>
+#include <queue>
+#include <functional>
 
 using namespace std;
 
@@ -62,31 +66,108 @@ public:
 
 	bool addTransaction(Transaction &trans);
 	bool WillAcceptTransaction();
+	bool WillAcceptTransaction(bool isWrite, unsigned requestor);
+	//whether the queue a read or write goes to has room with waiting more
+	//transactions on the way
+	bool queueHasRoom(bool isWrite, size_t waiting = 0) const;
+	//whether requestor is below its REQUESTOR_QUEUE_LIMITS entry with waiting
+	//more of its transactions on the way
+	bool requestorHasRoom(unsigned requestor, size_t waiting = 0) const;
 	void returnReadData(const Transaction &trans);
 	void receiveFromBus(BusPacket *bpacket);
 	void attachRanks(vector<Rank> *ranks);
 	void update();
 	void printStats(bool finalStats = false);
+	//with VIS_FILE_FORMAT=binary: names this channel's epoch statistics
+	//columns in writer, which printStats() then fills
+	void addBinaryStatsColumns(BinaryStatsWriter *writer);
+	//adds the read latencies seen so far (or only this epoch) to histogram
+	void collectReadLatencies(LatencyHistogram &histogram, bool epochOnly) const;
+	//adds this channel's run totals to stats; the averages get the sums,
+	//for the caller to divide once all channels are in
+	void collectStats(MemoryStats &stats) const;
+	//adds the read latencies of each requestor to histograms (by requestor)
+	void collectRequestorLatencies(vector<LatencyHistogram> &histograms) const;
 
 
 	//fields
-	vector<Transaction> transactionQueue;
+	vector<unsigned> transactionQueue; // slots in transactionSlab
+	vector<unsigned> writeQueue; // writes, when WRITE_QUEUE_DEPTH is set
 	vector< vector <BankState> > bankStates;
 private:
 	//functions
 	void insertHistogram(unsigned latencyValue, unsigned rank, unsigned bank);
+	void insertDrainHistogram(const Transaction &read, unsigned latencyValue);
+	bool forwardFromWriteQueue(const Transaction &read);
+	float refreshInterval();
+	bool postponeRefresh(unsigned rank);
+	void scheduleStateChange(unsigned rank, unsigned bank, unsigned delay);
+	unsigned allocateTransaction(const Transaction &trans);
+	void releaseTransaction(unsigned slot);
+	struct RequestorState;
+	RequestorState &requestorState(unsigned requestor);
+	unsigned requestorPriority(unsigned requestor) const
+	{
+		return requestor < config.requestorPriorities.size() ? config.requestorPriorities[requestor] : 0;
+	}
 
 	//fields
 	MemorySystem *parentMemorySystem;
+	const Config &config;
+	BusPacketPool &busPacketPool;
 
 	CommandQueue commandQueue;
 	BusPacket *poppedBusPacket;
 	vector<unsigned>refreshCountdown;
 	vector<BusPacket *> writeDataToSend;
-	vector<unsigned> writeDataCountdown;
-	vector<Transaction> returnTransaction;
-	vector<Transaction> pendingReadTransactions;
-	map<unsigned,unsigned> latencies; // latencyValue -> latencyCount
+	vector<uint64_t> writeDataCycle; // when each of writeDataToSend goes on the bus
+
+	//(cycle, SEQUENTIAL(rank,bank)) of the pending implicit bank state
+	//changes, earliest first
+	typedef pair<uint64_t, unsigned> StateChange;
+	priority_queue<StateChange, vector<StateChange>, greater<StateChange> > pendingStateChanges;
+
+	//every transaction the controller holds lives in a slot of
+	//transactionSlab; the queues below only pass slot numbers around
+	vector<Transaction> transactionSlab;
+	vector<unsigned> freeTransactionSlots;
+	vector<unsigned> returnTransaction;
+	vector<unsigned> pendingReadTransactions;
+	vector<LatencyHistogram> epochLatencies; // per bank, reads returned this epoch
+	LatencyHistogram latencies; // reads returned in earlier epochs
+	LatencyHistogram drainLatencies; // all the reads that saw a write drain
+
+	//write queue draining
+	bool drainingWrites;
+	unsigned drainBudget; // writes left in the current drain
+	bool readsFirst; // the last drain was cut short; reads from before its end go next
+	uint64_t lastDrainEnd;
+	uint64_t writeDrains;
+	uint64_t readsForwarded;
+	//run totals for getStats(): column accesses issued, data bus busy cycles,
+	//transactions waiting for their column access and banks with work summed
+	//over the cycles, and the cycles in which any bank had work
+	uint64_t readsIssued;
+	uint64_t writesIssued;
+	uint64_t dataBusCycles;
+	uint64_t queueDepthSum;
+	uint64_t busyBankSum;
+	uint64_t busyBankCycles;
+	vector<unsigned> forwardedReads; // reads answered from writeQueue, returned next update
+
+	//per requestor: its transactions in transactionQueue and writeQueue,
+	//the reads returned to it (and their latencies) and its writes that
+	//went to the command queue
+	struct RequestorState
+	{
+		RequestorState() : queued(0), reads(0), writes(0) {}
+		unsigned queued;
+		uint64_t reads;
+		uint64_t writes;
+		LatencyHistogram readLatencies;
+	};
+	vector<RequestorState> requestors;
+	unsigned maxRequestorPriority;
 	vector<bool> powerDown;
 
 	vector<Rank> *ranks;
@@ -94,6 +175,8 @@ private:
 	//output file
 	std::ofstream *visDataOut;
 	CSVWriter csvOut; 
+	BinaryStatsWriter *binaryStatsOut;
+	unsigned firstStatsColumn;
 
 	// these packets are counting down waiting to be transmitted on the "bus"
 	BusPacket *outgoingCmdPacket;
@@ -121,6 +204,10 @@ private:
 
 
 	unsigned refreshRank;
+	vector<unsigned> refreshesOwed; // per rank, due but not yet handed to commandQueue
+	vector<unsigned> refreshBank; // per rank, the bank the next per bank refresh is for
+	uint64_t refreshesIssued;
+	unsigned mostRefreshesOwed;
 	
 public:
 	// energy values are per rank -- SST uses these directly, so make these public 
@@ -0,0 +1,93 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+
+
+
+
+
+#ifndef MEMORYSTATS_H
+#define MEMORYSTATS_H
+
+//MemoryStats.h
+//
+//Header file for the run statistics of MultiChannelMemorySystem::getStats()
+//
+
+#include <stdint.h>
+#include <vector>
+#include "LatencyHistogram.h"
+
+namespace DRAMSim
+{
+// column accesses that found their row open (hit), the bank closed (miss)
+// or another row open (conflict) when they were queued
+struct RowBufferCounts
+{
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t conflicts;
+};
+
+// one requestor's traffic, over all channels
+struct RequestorStats
+{
+	uint64_t reads; // returned
+	uint64_t writes; // handed to the command queue
+	LatencyStats readLatency; // in memory clock cycles
+	double bandwidth; // GB/s of reads and writes
+};
+
+// totals over all channels since the start of the run
+struct MemoryStats
+{
+	uint64_t cycles;
+	uint64_t reads; // column accesses issued
+	uint64_t writes;
+	RowBufferCounts rowBuffer;
+	// per bank, at (channel*NUM_RANKS + rank)*NUM_BANKS + bank
+	std::vector<RowBufferCounts> bankRowBuffer;
+	// transactions of a channel waiting for their column access (in the
+	// transaction queues or the command queue), per cycle and channel
+	double averageQueueDepth;
+	// bank level parallelism: banks of a channel with column accesses
+	// queued, averaged over the busyCycles
+	double bankParallelism;
+	// cycles in which a channel had column accesses queued, summed over channels
+	uint64_t busyCycles;
+	// share of the cycles the data bus was busy, over all channels
+	double busUtilization;
+	// indexed by requestor, up to the highest one that sent anything
+	std::vector<RequestorStats> requestors;
+};
+}
+
+#endif
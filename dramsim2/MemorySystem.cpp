@@ -38,26 +38,24 @@
 
 #include "MemorySystem.h"
 #include "IniReader.h"
+#include "AddressMapping.h"
 #include <unistd.h>
 
 using namespace std;
 
 
-ofstream cmd_verify_out; //used in Rank.cpp and MemoryController.cpp if VERIFICATION_OUTPUT is set
-
-unsigned NUM_DEVICES;
-unsigned NUM_RANKS;
 
 namespace DRAMSim {
 #ifdef LOG_OUTPUT
 ofstream dramsim_log;
 #endif
 
-powerCallBack_t MemorySystem::ReportPower = NULL;
-
-MemorySystem::MemorySystem(unsigned id, unsigned int megsOfMemory, ofstream &visDataOut_) :
+MemorySystem::MemorySystem(unsigned id, unsigned int megsOfMemory, Config &config_, ofstream &visDataOut_) :
+		config(config_),
 		ReturnReadData(NULL),
 		WriteDataDone(NULL),
+		completions(NULL),
+		ReportPower(NULL),
 		systemID(id),
 		visDataOut(visDataOut_)
 {
@@ -111,23 +109,27 @@ MemorySystem::MemorySystem(unsigned id, unsigned int megsOfMemory, ofstream &vis
 	*********************/
 
 	// number of bytes per rank
-	unsigned long megsOfStoragePerRank = ((((long long)NUM_ROWS * (NUM_COLS * DEVICE_WIDTH) * NUM_BANKS) * ((long long)JEDEC_DATA_BUS_BITS / DEVICE_WIDTH)) / 8) >> 20;
+	unsigned long megsOfStoragePerRank = ((((long long)config.NUM_ROWS * (config.NUM_COLS * config.DEVICE_WIDTH) * config.NUM_BANKS) * ((long long)config.JEDEC_DATA_BUS_BITS / config.DEVICE_WIDTH)) / 8) >> 20;
 
 	// If this is set, effectively override the number of ranks
 	if (megsOfMemory != 0)
 	{
-		NUM_RANKS = megsOfMemory / megsOfStoragePerRank;
-		if (NUM_RANKS == 0)
+		config.NUM_RANKS = megsOfMemory / megsOfStoragePerRank;
+		if (config.NUM_RANKS == 0)
 		{
 			PRINT("WARNING: Cannot create memory system with "<<megsOfMemory<<"MB, defaulting to minimum size of "<<megsOfStoragePerRank<<"MB");
-			NUM_RANKS=1;
+			config.NUM_RANKS=1;
 		}
 	}
 
-	NUM_DEVICES = JEDEC_DATA_BUS_BITS/DEVICE_WIDTH;
-	TOTAL_STORAGE = (NUM_RANKS * megsOfStoragePerRank); 
+	config.NUM_DEVICES = config.JEDEC_DATA_BUS_BITS/config.DEVICE_WIDTH;
+	config.TOTAL_STORAGE = (config.NUM_RANKS * megsOfStoragePerRank); 
+
+	// NUM_RANKS is known now, so the timing and address widths can be filled in
+	config.computeDerived();
+	compileAddressMapping(config);
 
-	DEBUG("CH. " <<systemID<<" TOTAL_STORAGE : "<< TOTAL_STORAGE << "MB | "<<NUM_RANKS<<" Ranks | "<< NUM_DEVICES <<" Devices per rank");
+	DEBUG("CH. " <<systemID<<" TOTAL_STORAGE : "<< config.TOTAL_STORAGE << "MB | "<<config.NUM_RANKS<<" Ranks | "<< config.NUM_DEVICES <<" Devices per rank");
 
 
 	memoryController = new MemoryController(this, &visDataOut);
@@ -135,11 +137,12 @@ MemorySystem::MemorySystem(unsigned id, unsigned int megsOfMemory, ofstream &vis
 	// TODO: change to other vector constructor?
 	ranks = new vector<Rank>();
 
-	for (size_t i=0; i<NUM_RANKS; i++)
+	for (size_t i=0; i<config.NUM_RANKS; i++)
 	{
-		Rank r = Rank();
+		Rank r = Rank(config);
 		r.setId(i);
 		r.attachMemoryController(memoryController);
+		r.attachBusPacketPool(&busPacketPool);
 		ranks->push_back(r);
 	}
 
@@ -159,12 +162,6 @@ MemorySystem::~MemorySystem()
 	delete(memoryController);
 	ranks->clear();
 	delete(ranks);
-
-	if (VERIFICATION_OUTPUT)
-	{
-		cmd_verify_out.flush();
-		cmd_verify_out.close();
-	}
 }
 
 bool MemorySystem::WillAcceptTransaction()
@@ -172,14 +169,14 @@ bool MemorySystem::WillAcceptTransaction()
 	return memoryController->WillAcceptTransaction();
 }
 
-bool MemorySystem::addTransaction(bool isWrite, uint64_t addr)
+bool MemorySystem::addTransaction(bool isWrite, uint64_t addr, unsigned requestor)
 {
 	TransactionType type = isWrite ? DATA_WRITE : DATA_READ;
-	Transaction trans(type,addr,NULL);
+	Transaction trans(type,addr,NULL,requestor);
 	// push_back in memoryController will make a copy of this during
 	// addTransaction so it's kosher for the reference to be local 
 
-	if (memoryController->WillAcceptTransaction()) 
+	if (memoryController->WillAcceptTransaction(isWrite, requestor)) 
 	{
 		return memoryController->addTransaction(trans);
 	}
@@ -215,21 +212,30 @@ void MemorySystem::update()
 
 	//updates the state of each of the objects
 	// NOTE - do not change order
-	for (size_t i=0;i<NUM_RANKS;i++)
+	for (size_t i=0;i<config.NUM_RANKS;i++)
 	{
 		(*ranks)[i].update();
 	}
 
-	//pendingTransactions will only have stuff in it if MARSS is adding stuff
-	if (pendingTransactions.size() > 0 && memoryController->WillAcceptTransaction())
+	//pendingTransactions will only have stuff in it if MARSS is adding stuff;
+	//the oldest one with room in its queue and under its requestor's queue
+	//limit goes first
+	if (pendingTransactions.size() > 0)
 	{
-		memoryController->addTransaction(pendingTransactions.front());
-		pendingTransactions.pop_front();
+		for (deque<Transaction>::iterator it=pendingTransactions.begin(); it!=pendingTransactions.end(); it++)
+		{
+			if (memoryController->WillAcceptTransaction(it->transactionType == DATA_WRITE, it->requestor))
+			{
+				memoryController->addTransaction(*it);
+				pendingTransactions.erase(it);
+				break;
+			}
+		}
 	}
 	memoryController->update();
 
 	//simply increments the currentClockCycle field for each object
-	for (size_t i=0;i<NUM_RANKS;i++)
+	for (size_t i=0;i<config.NUM_RANKS;i++)
 	{
 		(*ranks)[i].step();
 	}
@@ -248,6 +254,35 @@ void MemorySystem::RegisterCallbacks( Callback_t* readCB, Callback_t* writeCB,
 	ReportPower = reportPower;
 }
 
+//reports a finished transaction to the upper levels
+void MemorySystem::transactionDone(bool isWrite, uint64_t address, uint64_t cycle)
+{
+	if (completions != NULL)
+	{
+		completions->append(systemID, isWrite, address, cycle);
+		return;
+	}
+	Callback_t *cb = isWrite ? WriteDataDone : ReturnReadData;
+	if (cb != NULL)
+	{
+		(*cb)(systemID, address, cycle);
+	}
+}
+
+void CompletionArray::append(unsigned id, bool isWrite, uint64_t address, uint64_t cycle)
+{
+	if (count == capacity)
+	{
+		ERROR("The completion buffer is full ("<<capacity<<" entries), take the completions after every update()");
+		exit(-1);
+	}
+	TransactionCompletion &c = entries[count++];
+	c.id = id;
+	c.isWrite = isWrite;
+	c.address = address;
+	c.cycle = cycle;
+}
+
 } /*namespace DRAMSim */
 
 
@@ -48,16 +48,26 @@
 
 namespace DRAMSim
 {
+//a caller-owned array that finished transactions are appended to
+struct CompletionArray
+{
+	TransactionCompletion *entries;
+	size_t capacity;
+	size_t count;
+
+	void append(unsigned id, bool isWrite, uint64_t address, uint64_t cycle);
+};
+
 typedef CallbackBase<void,unsigned,uint64_t,uint64_t> Callback_t;
 class MemorySystem : public SimulatorObject
 {
 public:
 	//functions
-	MemorySystem(unsigned id, unsigned megsOfMemory, ofstream &visDataOut);
+	MemorySystem(unsigned id, unsigned megsOfMemory, Config &config, ofstream &visDataOut);
 	virtual ~MemorySystem();
 	void update();
 	bool addTransaction(Transaction &trans);
-	bool addTransaction(bool isWrite, uint64_t addr);
+	bool addTransaction(bool isWrite, uint64_t addr, unsigned requestor = 0);
 	void printStats();
 	void printStats(bool unused);
 	bool WillAcceptTransaction();
@@ -65,8 +75,11 @@ public:
 	    Callback_t *readDone,
 	    Callback_t *writeDone,
 	    void (*reportPower)(double bgpower, double burstpower, double refreshpower, double actprepower));
+	void transactionDone(bool isWrite, uint64_t address, uint64_t cycle);
 
 	//fields
+	Config &config;
+	BusPacketPool busPacketPool;
 	MemoryController *memoryController;
 	vector<Rank> *ranks;
 	deque<Transaction> pendingTransactions; 
@@ -75,8 +88,10 @@ public:
 	//function pointers
 	Callback_t* ReturnReadData;
 	Callback_t* WriteDataDone;
+	//if set, finished transactions go here instead of to the callbacks
+	CompletionArray *completions;
 	//TODO: make this a functor as well?
-	static powerCallBack_t ReportPower;
+	powerCallBack_t ReportPower;
 	unsigned systemID;
 
 private:
@@ -29,7 +29,9 @@
 *********************************************************************************/
 #include <errno.h> 
 #include <sstream> //stringstream
+#include <algorithm> // stable_sort()
 #include <stdlib.h> // getenv()
+#include <string.h> // memcpy()
 // for directory operations 
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -43,9 +45,15 @@
 using namespace DRAMSim; 
 
 
-MultiChannelMemorySystem::MultiChannelMemorySystem(const string &deviceIniFilename_, const string &systemIniFilename_, const string &pwd_, const string &traceFilename_, unsigned megsOfMemory_)
-	:megsOfMemory(megsOfMemory_), deviceIniFilename(deviceIniFilename_), systemIniFilename(systemIniFilename_), traceFilename(traceFilename_), pwd(pwd_)
+MultiChannelMemorySystem::MultiChannelMemorySystem(const string &deviceIniFilename_, const string &systemIniFilename_, const string &pwd_, const string &traceFilename_, unsigned megsOfMemory_, const vector<string> &iniOverrides)
+	:config(), megsOfMemory(megsOfMemory_), deviceIniFilename(deviceIniFilename_), systemIniFilename(systemIniFilename_), traceFilename(traceFilename_), pwd(pwd_), outputFilesInitialized(false),
+	readDoneCB(NULL), writeDoneCB(NULL), batchEnd(0), batchNumber(0), workersRunning(0), stopWorkers(false)
 {
+	currentClockCycle = 0;
+	completionArray.entries = NULL;
+	completionArray.capacity = 0;
+	completionArray.count = 0;
+
 	if (!isPowerOfTwo(megsOfMemory))
 	{
 		ERROR("Please specify a power of 2 memory size"); 
@@ -67,28 +75,57 @@ MultiChannelMemorySystem::MultiChannelMemorySystem(const string &deviceIniFilena
 	}
 
 	DEBUG("== Loading device model file '"<<deviceIniFilename<<"' == ");
-	IniReader::ReadIniFile(deviceIniFilename, false);
+	IniReader::ReadIniFile(config, deviceIniFilename, false);
 	DEBUG("== Loading system model file '"<<systemIniFilename<<"' == ");
-	IniReader::ReadIniFile(systemIniFilename, true);
+	IniReader::ReadIniFile(config, systemIniFilename, true);
+	for (size_t i=0; i<iniOverrides.size(); i++)
+	{
+		overrideSystemParam(iniOverrides[i]);
+	}
 
-	IniReader::InitEnumsFromStrings();
-	if (!IniReader::CheckIfAllSet())
+	IniReader::InitEnumsFromStrings(config);
+	if (!IniReader::CheckIfAllSet(config))
 	{
 		exit(-1);
 	}
 
-	if (NUM_CHANS == 0) 
+	if (config.NUM_CHANS == 0) 
 	{
 		ERROR("Zero channels"); 
 		abort(); 
 	}
 
-	for (size_t i=0; i<NUM_CHANS; i++)
+	for (size_t i=0; i<config.NUM_CHANS; i++)
 	{
-		MemorySystem *channel = new MemorySystem(i, megsOfMemory/NUM_CHANS, visDataOut);
+		MemorySystem *channel = new MemorySystem(i, megsOfMemory/config.NUM_CHANS, config, visDataOut);
 		channels.push_back(channel);
 	}
 
+	if (config.PARALLEL_BATCH_CYCLES > 0 && (config.VERIFICATION_OUTPUT || config.DEBUG_TRANS_Q || config.DEBUG_CMD_Q || config.DEBUG_ADDR_MAP ||
+	                                  config.DEBUG_BANKSTATE || config.DEBUG_BUS || config.DEBUG_BANKS || config.DEBUG_POWER))
+	{
+		PRINT("WARNING: debug and verification output would interleave between channels, ignoring PARALLEL_BATCH_CYCLES");
+		config.PARALLEL_BATCH_CYCLES = 0;
+	}
+	if (config.VIS_FILE_OUTPUT && config.visFileFormat == BinaryVisFile)
+	{
+		for (size_t i=0; i<config.NUM_CHANS; i++)
+		{
+			channels[i]->memoryController->addBinaryStatsColumns(&binaryStatsOut);
+		}
+	}
+	if (isParallel())
+	{
+		channelInput.resize(config.NUM_CHANS);
+		completionBuffers.resize(config.NUM_CHANS);
+		for (size_t i=0; i<config.NUM_CHANS; i++)
+		{
+			bufferCallbacks.push_back(new Callback<CompletionBuffer, void, unsigned, uint64_t, uint64_t>(&completionBuffers[i], &CompletionBuffer::readDone));
+			bufferCallbacks.push_back(new Callback<CompletionBuffer, void, unsigned, uint64_t, uint64_t>(&completionBuffers[i], &CompletionBuffer::writeDone));
+			channels[i]->RegisterCallbacks(bufferCallbacks[2*i], bufferCallbacks[2*i+1], NULL);
+		}
+		startWorkers();
+	}
 }
 /**
  * This function creates up to 3 output files: 
@@ -103,6 +140,12 @@ MultiChannelMemorySystem::MultiChannelMemorySystem(const string &deviceIniFilena
  **/
 void MultiChannelMemorySystem::InitOutputFiles(string traceFilename)
 {
+	if (outputFilesInitialized)
+	{
+		return;
+	}
+	outputFilesInitialized = true;
+
 	size_t lastSlash;
 	size_t deviceIniFilenameLength = deviceIniFilename.length();
 	string sim_description_str;
@@ -116,8 +159,8 @@ void MultiChannelMemorySystem::InitOutputFiles(string traceFilename)
 
 
 	// create a properly named verification output file if need be and open it
-	// as the stream 'cmd_verify_out'
-	if (VERIFICATION_OUTPUT)
+	// as the stream 'config.cmd_verify_out'
+	if (config.VERIFICATION_OUTPUT)
 	{
 		string basefilename = deviceIniFilename.substr(deviceIniFilename.find_last_of("/")+1);
 		string verify_filename =  "sim_out_"+basefilename;
@@ -126,8 +169,8 @@ void MultiChannelMemorySystem::InitOutputFiles(string traceFilename)
 			verify_filename += "."+sim_description_str;
 		}
 		verify_filename += ".tmp";
-		cmd_verify_out.open(verify_filename.c_str());
-		if (!cmd_verify_out)
+		config.cmd_verify_out.open(verify_filename.c_str());
+		if (!config.cmd_verify_out)
 		{
 			ERROR("Cannot open "<< verify_filename);
 			abort(); 
@@ -135,7 +178,7 @@ void MultiChannelMemorySystem::InitOutputFiles(string traceFilename)
 	}
 	// This sets up the vis file output along with the creating the result
 	// directory structure if it doesn't exist
-	if (VIS_FILE_OUTPUT)
+	if (config.VIS_FILE_OUTPUT)
 	{
 		// chop off the .ini if it's there
 		if (deviceIniFilename.substr(deviceIniFilenameLength-4) == ".ini")
@@ -180,17 +223,25 @@ void MultiChannelMemorySystem::InitOutputFiles(string traceFilename)
 		// finally, figure out the filename
 		string sched = "BtR";
 		string queue = "pRank";
-		if (schedulingPolicy == RankThenBankRoundRobin)
+		if (config.schedulingPolicy == RankThenBankRoundRobin)
 		{
 			sched = "RtB";
 		}
-		if (queuingStructure == PerRankPerBank)
+		else if (config.schedulingPolicy == FrFcfs)
+		{
+			sched = "FRFCFS";
+		}
+		else if (config.schedulingPolicy == FrFcfsCap)
+		{
+			sched = "FRFCFScap";
+		}
+		if (config.queuingStructure == PerRankPerBank)
 		{
 			queue = "pRankpBank";
 		}
 
 		/* I really don't see how "the C++ way" is better than snprintf()  */
-		out << (TOTAL_STORAGE>>10) << "GB." << NUM_CHANS << "Ch." << NUM_RANKS <<"R." <<ADDRESS_MAPPING_SCHEME<<"."<<ROW_BUFFER_POLICY<<"."<< TRANS_QUEUE_DEPTH<<"TQ."<<CMD_QUEUE_DEPTH<<"CQ."<<sched<<"."<<queue;
+		out << (config.TOTAL_STORAGE>>10) << "GB." << config.NUM_CHANS << "Ch." << config.NUM_RANKS <<"R." <<config.ADDRESS_MAPPING_SCHEME<<"."<<config.ROW_BUFFER_POLICY<<"."<< config.TRANS_QUEUE_DEPTH<<"TQ."<<config.CMD_QUEUE_DEPTH<<"CQ."<<sched<<"."<<queue;
 		if (sim_description)
 		{
 			out << "." << sim_description;
@@ -222,7 +273,19 @@ void MultiChannelMemorySystem::InitOutputFiles(string traceFilename)
 			exit(-1);
 		}
 		//write out the ini config values for the visualizer tool
-		IniReader::WriteValuesOut(visDataOut);
+		IniReader::WriteValuesOut(config, visDataOut);
+
+		if (config.visFileFormat == BinaryVisFile)
+		{
+			// foo.vis -> foo.visb
+			string binaryPath = path + "b";
+			cerr << "writing epoch statistics to " <<binaryPath<<endl;
+			if (!binaryStatsOut.open(binaryPath))
+			{
+				ERROR("Cannot open '"<<binaryPath<<"'");
+				exit(-1);
+			}
+		}
 
 	}
 #ifdef LOG_OUTPUT
@@ -295,7 +358,13 @@ void MultiChannelMemorySystem::mkdirIfNotExist(string path)
 void MultiChannelMemorySystem::overrideSystemParam(string key, string value)
 {
 	cerr << "Override key " <<key<<"="<<value<<endl;
-	IniReader::SetKey(key, value, true);
+	IniReader::SetKey(config, key, value, true);
+	config.computeDerived();
+	// before the channels exist, MemorySystem() does this once NUM_RANKS is known
+	if (!channels.empty())
+	{
+		compileAddressMapping(config);
+	}
 }
 
 void MultiChannelMemorySystem::overrideSystemParam(string keyValuePair)
@@ -312,40 +381,238 @@ void MultiChannelMemorySystem::overrideSystemParam(string keyValuePair)
 
 MultiChannelMemorySystem::~MultiChannelMemorySystem()
 {
+	if (!workers.empty())
+	{
+		pthread_mutex_lock(&batchLock);
+		stopWorkers = true;
+		pthread_cond_broadcast(&batchStart);
+		pthread_mutex_unlock(&batchLock);
+		for (size_t i=0; i<workers.size(); i++)
+		{
+			pthread_join(workers[i].thread, NULL);
+		}
+	}
 // Should only ever be called on exit, so don't bother to delete stuff, just
 // flush our streams and close em up
 #ifdef LOG_OUTPUT
 	dramsim_log.flush();
 	dramsim_log.close();
 #endif
-	if (VIS_FILE_OUTPUT) 
+	if (config.VIS_FILE_OUTPUT) 
 	{	
 		visDataOut.flush();
 		visDataOut.close();
+		binaryStatsOut.close();
+	}
+	if (config.VERIFICATION_OUTPUT)
+	{
+		config.cmd_verify_out.flush();
+		config.cmd_verify_out.close();
 	}
 }
 void MultiChannelMemorySystem::update() 
 {
-	if (currentClockCycle == 0)
+	if (!outputFilesInitialized)
 	{
 		InitOutputFiles(traceFilename);
 	}
 
-	for (size_t i=0; i<NUM_CHANS; i++)
+	if (!isParallel())
 	{
-		channels[i]->update(); 
+		for (size_t i=0; i<config.NUM_CHANS; i++)
+		{
+			channels[i]->update(); 
+		}
+	}
+	else if (currentClockCycle % config.EPOCH_LENGTH == 0)
+	{
+		// epoch stats go to the shared vis file and stdout, so these cycles
+		// are run one channel after the other
+		syncChannels(currentClockCycle);
+		for (size_t i=0; i<config.NUM_CHANS; i++)
+		{
+			runChannel(i, currentClockCycle+1);
+		}
+		deliverCompletions();
+	}
+	else if (currentClockCycle+1 - channels[0]->currentClockCycle >= config.PARALLEL_BATCH_CYCLES)
+	{
+		syncChannels(currentClockCycle+1);
 	}
 	currentClockCycle++; 
 }
+
+bool MultiChannelMemorySystem::isParallel()
+{
+	return config.PARALLEL_BATCH_CYCLES > 0 && config.NUM_CHANS > 1;
+}
+
+// the channel's queues as of the last batch, less whatever is already waiting
+// to go in; a transaction accepted this way can't be turned away later
+bool MultiChannelMemorySystem::channelHasRoom(unsigned channel, bool isWrite, unsigned requestor)
+{
+	MemoryController *memoryController = channels[channel]->memoryController;
+	size_t waiting = channelInput[channel].size() + channels[channel]->pendingTransactions.size();
+	// every waiting transaction might go to the same queue and be requestor's
+	return memoryController->queueHasRoom(isWrite, waiting) &&
+	       memoryController->requestorHasRoom(requestor, waiting);
+}
+
+// updates one channel until it reaches endCycle, handing it each buffered
+// transaction in the cycle it was added
+void MultiChannelMemorySystem::runChannel(unsigned channel, uint64_t endCycle)
+{
+	MemorySystem *memorySystem = channels[channel];
+	vector<TimedTransaction> &input = channelInput[channel];
+	size_t next = 0;
+	while (memorySystem->currentClockCycle < endCycle)
+	{
+		for (; next < input.size() && input[next].cycle <= memorySystem->currentClockCycle; next++)
+		{
+			Transaction &trans = input[next].trans;
+			if (input[next].queueIfFull)
+			{
+				memorySystem->addTransaction(trans.transactionType == DATA_WRITE, trans.address, trans.requestor);
+			}
+			else if (!memorySystem->addTransaction(trans))
+			{
+				memorySystem->pendingTransactions.push_back(trans);
+			}
+		}
+		memorySystem->update();
+	}
+	input.erase(input.begin(), input.begin()+next);
+}
+
+// runs every channel up to endCycle, channel 0 on this thread and the others
+// on the workers, then reports what completed
+void MultiChannelMemorySystem::syncChannels(uint64_t endCycle)
+{
+	if (channels[0]->currentClockCycle >= endCycle)
+	{
+		return;
+	}
+	pthread_mutex_lock(&batchLock);
+	batchEnd = endCycle;
+	batchNumber++;
+	workersRunning = workers.size();
+	pthread_cond_broadcast(&batchStart);
+	pthread_mutex_unlock(&batchLock);
+
+	runChannel(0, endCycle);
+
+	pthread_mutex_lock(&batchLock);
+	while (workersRunning > 0)
+	{
+		pthread_cond_wait(&batchDone, &batchLock);
+	}
+	pthread_mutex_unlock(&batchLock);
+
+	deliverCompletions();
+}
+
+bool MultiChannelMemorySystem::completesBefore(const CompletionBuffer::Completion &a, const CompletionBuffer::Completion &b)
+{
+	return a.cycle < b.cycle;
+}
+
+// calls the registered callbacks in the order serial updates would have:
+// by cycle, then by channel
+void MultiChannelMemorySystem::deliverCompletions()
+{
+	vector<CompletionBuffer::Completion> completions;
+	for (size_t i=0; i<config.NUM_CHANS; i++)
+	{
+		completions.insert(completions.end(), completionBuffers[i].completions.begin(), completionBuffers[i].completions.end());
+		completionBuffers[i].completions.clear();
+	}
+	stable_sort(completions.begin(), completions.end(), completesBefore);
+	for (size_t i=0; i<completions.size(); i++)
+	{
+		if (completionArray.entries != NULL)
+		{
+			completionArray.append(completions[i].channel, completions[i].isWrite, completions[i].address, completions[i].cycle);
+			continue;
+		}
+		TransactionCompleteCB *cb = completions[i].isWrite ? writeDoneCB : readDoneCB;
+		if (cb != NULL)
+		{
+			(*cb)(completions[i].channel, completions[i].address, completions[i].cycle);
+		}
+	}
+}
+
+void MultiChannelMemorySystem::CompletionBuffer::readDone(unsigned id, uint64_t address, uint64_t cycle)
+{
+	Completion c = {cycle, address, id, false};
+	completions.push_back(c);
+}
+
+void MultiChannelMemorySystem::CompletionBuffer::writeDone(unsigned id, uint64_t address, uint64_t cycle)
+{
+	Completion c = {cycle, address, id, true};
+	completions.push_back(c);
+}
+
+void MultiChannelMemorySystem::startWorkers()
+{
+	pthread_mutex_init(&batchLock, NULL);
+	pthread_cond_init(&batchStart, NULL);
+	pthread_cond_init(&batchDone, NULL);
+	workers.resize(config.NUM_CHANS-1);
+	for (size_t i=0; i<workers.size(); i++)
+	{
+		workers[i].memorySystem = this;
+		workers[i].channel = i+1;
+		if (pthread_create(&workers[i].thread, NULL, workerMain, &workers[i]) != 0)
+		{
+			ERROR("Cannot start the thread for channel "<<i+1);
+			exit(-1);
+		}
+	}
+}
+
+void *MultiChannelMemorySystem::workerMain(void *arg)
+{
+	ChannelWorker *worker = (ChannelWorker *)arg;
+	MultiChannelMemorySystem *memorySystem = worker->memorySystem;
+	unsigned lastBatch = 0;
+
+	pthread_mutex_lock(&memorySystem->batchLock);
+	while (true)
+	{
+		while (memorySystem->batchNumber == lastBatch && !memorySystem->stopWorkers)
+		{
+			pthread_cond_wait(&memorySystem->batchStart, &memorySystem->batchLock);
+		}
+		if (memorySystem->stopWorkers)
+		{
+			break;
+		}
+		lastBatch = memorySystem->batchNumber;
+		uint64_t endCycle = memorySystem->batchEnd;
+		pthread_mutex_unlock(&memorySystem->batchLock);
+
+		memorySystem->runChannel(worker->channel, endCycle);
+
+		pthread_mutex_lock(&memorySystem->batchLock);
+		if (--memorySystem->workersRunning == 0)
+		{
+			pthread_cond_signal(&memorySystem->batchDone);
+		}
+	}
+	pthread_mutex_unlock(&memorySystem->batchLock);
+	return NULL;
+}
 unsigned MultiChannelMemorySystem::findChannelNumber(uint64_t addr)
 {
 	// Single channel case is a trivial shortcut case 
-	if (NUM_CHANS == 1)
+	if (config.NUM_CHANS == 1)
 	{
 		return 0; 
 	}
 
-	if (!isPowerOfTwo(NUM_CHANS))
+	if (!isPowerOfTwo(config.NUM_CHANS))
 	{
 		ERROR("We can only support power of two # of channels.\n" <<
 				"I don't know what Intel was thinking, but trying to address map half a bit is a neat trick that we're not sure how to do"); 
@@ -354,10 +621,10 @@ unsigned MultiChannelMemorySystem::findChannelNumber(uint64_t addr)
 
 	// only chan is used from this set 
 	unsigned channelNumber,rank,bank,row,col;
-	addressMapping(addr, channelNumber, rank, bank, row, col); 
-	if (channelNumber >= NUM_CHANS)
+	addressMapping(config, addr, channelNumber, rank, bank, row, col); 
+	if (channelNumber >= config.NUM_CHANS)
 	{
-		ERROR("Got channel index "<<channelNumber<<" but only "<<NUM_CHANS<<" exist"); 
+		ERROR("Got channel index "<<channelNumber<<" but only "<<config.NUM_CHANS<<" exist"); 
 		abort();
 	}
 	//DEBUG("Channel idx = "<<channelNumber<<" totalbits="<<totalBits<<" channelbits="<<channelBits); 
@@ -368,13 +635,56 @@ unsigned MultiChannelMemorySystem::findChannelNumber(uint64_t addr)
 bool MultiChannelMemorySystem::addTransaction(Transaction &trans)
 {
 	unsigned channelNumber = findChannelNumber(trans.address); 
-	return channels[channelNumber]->addTransaction(trans); 
+	if (isParallel() && !channelHasRoom(channelNumber, trans.transactionType == DATA_WRITE, trans.requestor))
+	{
+		return false;
+	}
+
+	// the channel keeps its own copy of the data until the write reaches
+	// its bank (Rank::receiveFromBus() frees it)
+	void *callerData = trans.data;
+	if (trans.transactionType == DATA_WRITE && callerData != NULL)
+	{
+		trans.data = malloc(config.transactionSize);
+		memcpy(trans.data, callerData, config.transactionSize);
+	}
+
+	bool added = true;
+	if (isParallel())
+	{
+		TimedTransaction timed = {currentClockCycle, trans, false};
+		channelInput[channelNumber].push_back(timed);
+	}
+	else
+	{
+		added = channels[channelNumber]->addTransaction(trans);
+	}
+
+	if (!added && trans.data != callerData)
+	{
+		free(trans.data);
+	}
+	trans.data = callerData;
+	return added;
 }
 
 bool MultiChannelMemorySystem::addTransaction(bool isWrite, uint64_t addr)
+{
+	return addTransaction(isWrite, addr, 0);
+}
+
+bool MultiChannelMemorySystem::addTransaction(bool isWrite, uint64_t addr, unsigned requestor)
 {
 	unsigned channelNumber = findChannelNumber(addr); 
-	return channels[channelNumber]->addTransaction(isWrite, addr); 
+	if (isParallel())
+	{
+		// like MemorySystem::addTransaction(bool, ...), kept even if the
+		// channel is full; runChannel() puts it in pendingTransactions then
+		TimedTransaction timed = {currentClockCycle, Transaction(isWrite ? DATA_WRITE : DATA_READ, addr, NULL, requestor), true};
+		channelInput[channelNumber].push_back(timed);
+		return true;
+	}
+	return channels[channelNumber]->addTransaction(isWrite, addr, requestor); 
 }
 
 /*
@@ -387,16 +697,30 @@ bool MultiChannelMemorySystem::addTransaction(bool isWrite, uint64_t addr)
 */
 
 bool MultiChannelMemorySystem::willAcceptTransaction(uint64_t addr)
+{
+	return willAcceptTransaction(addr, 0);
+}
+
+bool MultiChannelMemorySystem::willAcceptTransaction(uint64_t addr, unsigned requestor)
+{
+	return willAcceptTransaction(false, addr, requestor) && willAcceptTransaction(true, addr, requestor);
+}
+
+bool MultiChannelMemorySystem::willAcceptTransaction(bool isWrite, uint64_t addr, unsigned requestor)
 {
 	unsigned chan, rank,bank,row,col; 
-	addressMapping(addr, chan, rank, bank, row, col); 
-	return channels[chan]->WillAcceptTransaction(); 
+	addressMapping(config, addr, chan, rank, bank, row, col); 
+	if (isParallel())
+	{
+		return channelHasRoom(chan, isWrite, requestor);
+	}
+	return channels[chan]->memoryController->WillAcceptTransaction(isWrite, requestor); 
 }
 
 bool MultiChannelMemorySystem::willAcceptTransaction()
 {
-	for (size_t c=0; c<NUM_CHANS; c++) {
-		if (!channels[c]->WillAcceptTransaction())
+	for (size_t c=0; c<config.NUM_CHANS; c++) {
+		if (isParallel() ? !(channelHasRoom(c, false, 0) && channelHasRoom(c, true, 0)) : !channels[c]->WillAcceptTransaction())
 		{
 			return false; 
 		}
@@ -407,23 +731,129 @@ bool MultiChannelMemorySystem::willAcceptTransaction()
 
 
 void MultiChannelMemorySystem::printStats() {
-	for (size_t i=0; i<NUM_CHANS; i++)
+	if (isParallel())
+	{
+		syncChannels(currentClockCycle);
+	}
+	for (size_t i=0; i<config.NUM_CHANS; i++)
 	{
 		PRINT("==== Channel ["<<i<<"] ====");
 		channels[i]->printStats(); 
 		PRINT("//// Channel ["<<i<<"] ////");
 	}
+	// library users often never delete the memory system
+	binaryStatsOut.flush();
+}
+LatencyStats MultiChannelMemorySystem::getReadLatencyStats(bool epochOnly)
+{
+	LatencyHistogram histogram;
+	for (size_t i=0; i<config.NUM_CHANS; i++)
+	{
+		channels[i]->memoryController->collectReadLatencies(histogram, epochOnly);
+	}
+	return histogram.stats();
+}
+MemoryStats MultiChannelMemorySystem::getStats()
+{
+	MemoryStats stats;
+	stats.cycles = 0;
+	stats.reads = 0;
+	stats.writes = 0;
+	stats.rowBuffer.hits = 0;
+	stats.rowBuffer.misses = 0;
+	stats.rowBuffer.conflicts = 0;
+	stats.averageQueueDepth = 0.0;
+	stats.bankParallelism = 0.0;
+	stats.busyCycles = 0;
+	stats.busUtilization = 0.0;
+	vector<LatencyHistogram> requestorLatencies;
+	for (size_t i=0; i<config.NUM_CHANS; i++)
+	{
+		channels[i]->memoryController->collectStats(stats);
+		channels[i]->memoryController->collectRequestorLatencies(requestorLatencies);
+	}
+	for (size_t i=0; i<stats.requestors.size(); i++)
+	{
+		RequestorStats &requestor = stats.requestors[i];
+		requestor.readLatency = requestorLatencies[i].stats();
+		// bytes per ns is GB/s
+		requestor.bandwidth = stats.cycles ? (double)(requestor.reads + requestor.writes) * config.transactionSize / (stats.cycles * config.tCK) : 0.0;
+	}
+	if (stats.cycles > 0)
+	{
+		stats.averageQueueDepth /= (double)stats.cycles * config.NUM_CHANS;
+		stats.busUtilization /= (double)stats.cycles * config.NUM_CHANS;
+	}
+	if (stats.busyCycles > 0)
+	{
+		stats.bankParallelism /= stats.busyCycles;
+	}
+	return stats;
+}
+unsigned MultiChannelMemorySystem::getNumChannels()
+{
+	return config.NUM_CHANS;
+}
+unsigned MultiChannelMemorySystem::getChannel(uint64_t addr)
+{
+	return findChannelNumber(addr);
+}
+unsigned MultiChannelMemorySystem::getQueueOccupancy(unsigned channel)
+{
+	MemoryController *memoryController = channels[channel]->memoryController;
+	size_t queued = memoryController->transactionQueue.size() + memoryController->writeQueue.size() +
+	                channels[channel]->pendingTransactions.size();
+	if (isParallel())
+	{
+		queued += channelInput[channel].size();
+	}
+	return queued;
 }
 void MultiChannelMemorySystem::RegisterCallbacks( 
 		TransactionCompleteCB *readDone,
 		TransactionCompleteCB *writeDone,
 		void (*reportPower)(double bgpower, double burstpower, double refreshpower, double actprepower))
 {
-	for (size_t i=0; i<NUM_CHANS; i++)
+	if (isParallel())
+	{
+		// the channels report to completionBuffers, which pass completions on
+		// at the end of each batch
+		readDoneCB = readDone;
+		writeDoneCB = writeDone;
+		for (size_t i=0; i<config.NUM_CHANS; i++)
+		{
+			channels[i]->RegisterCallbacks(bufferCallbacks[2*i], bufferCallbacks[2*i+1], reportPower); 
+		}
+		return;
+	}
+	for (size_t i=0; i<config.NUM_CHANS; i++)
 	{
 		channels[i]->RegisterCallbacks(readDone, writeDone, reportPower); 
 	}
 }
+
+void MultiChannelMemorySystem::RegisterCompletionBuffer(TransactionCompletion *buffer, size_t capacity)
+{
+	completionArray.entries = buffer;
+	completionArray.capacity = buffer != NULL ? capacity : 0;
+	completionArray.count = 0;
+	// in parallel mode the completions are still collected per channel and
+	// only moved to the buffer once the batch is done
+	if (!isParallel())
+	{
+		for (size_t i=0; i<config.NUM_CHANS; i++)
+		{
+			channels[i]->completions = buffer != NULL ? &completionArray : NULL;
+		}
+	}
+}
+
+size_t MultiChannelMemorySystem::takeCompletions()
+{
+	size_t count = completionArray.count;
+	completionArray.count = 0;
+	return count;
+}
 namespace DRAMSim {
 MultiChannelMemorySystem *getMemorySystemInstance(const string &dev, const string &sys, const string &pwd, const string &trc, unsigned megsOfMemory) 
 {
@@ -31,6 +31,7 @@
 #include "Transaction.h"
 #include "SystemConfiguration.h"
 #include "MemorySystem.h"
+#include <pthread.h>
 
 
 namespace DRAMSim {
@@ -40,19 +41,54 @@ class MultiChannelMemorySystem : public SimulatorObject
 {
 	public: 
 
-	MultiChannelMemorySystem(const string &dev, const string &sys, const string &pwd, const string &trc, unsigned megsOfMemory);
+	// iniOverrides are KEY=VALUE pairs applied on top of the ini files
+	MultiChannelMemorySystem(const string &dev, const string &sys, const string &pwd, const string &trc, unsigned megsOfMemory, const vector<string> &iniOverrides = vector<string>());
 		virtual ~MultiChannelMemorySystem();
+			// false if the channel is full. a write's data is copied, so the
+			// caller may free it as soon as the transaction is accepted
 			bool addTransaction(Transaction &trans);
+			// never turns a transaction away: one whose channel is full waits
+			// in a buffer past the queue and true is still returned, in serial
+			// and PARALLEL_BATCH_CYCLES mode alike; ask willAcceptTransaction()
+			// first for backpressure
 			bool addTransaction(bool isWrite, uint64_t addr);
 			bool willAcceptTransaction(); 
 			bool willAcceptTransaction(uint64_t addr); 
+			// the same for a transaction from requestor (see
+			// REQUESTOR_QUEUE_LIMITS), which the ones above take to be 0
+			bool addTransaction(bool isWrite, uint64_t addr, unsigned requestor);
+			bool willAcceptTransaction(uint64_t addr, unsigned requestor);
+			// only asks for room in the queue a read (or write) goes to; the
+			// ones above ask for room for either
+			bool willAcceptTransaction(bool isWrite, uint64_t addr, unsigned requestor);
 			void update();
 			void printStats();
+			// read latencies over all channels, for the whole run or only the
+			// current epoch; with PARALLEL_BATCH_CYCLES, as of the last batch
+			LatencyStats getReadLatencyStats(bool epochOnly = false);
+			// row buffer, queue, bank parallelism, bus and per requestor
+			// statistics of the whole run; with PARALLEL_BATCH_CYCLES, as of
+			// the last batch
+			MemoryStats getStats();
+			// the transactions a channel holds, including those not yet handed
+			// to its controller; with PARALLEL_BATCH_CYCLES, as of the last batch
+			unsigned getNumChannels();
+			unsigned getChannel(uint64_t addr);
+			unsigned getQueueOccupancy(unsigned channel);
 			void RegisterCallbacks( 
 				TransactionCompleteCB *readDone,
 				TransactionCompleteCB *writeDone,
 				void (*reportPower)(double bgpower, double burstpower, double refreshpower, double actprepower));
+			// the pull alternative to the callbacks: update() appends finished
+			// transactions to buffer instead, and takeCompletions() returns how
+			// many it holds and empties it for the next update(). Running out of
+			// room is an error; with PARALLEL_BATCH_CYCLES a single update() can
+			// add a whole batch. NULL goes back to the callbacks.
+			void RegisterCompletionBuffer(TransactionCompletion *buffer, size_t capacity);
+			size_t takeCompletions();
 
+	// called by the first update() if it hasn't been already; only the
+	// first call does anything
 	void InitOutputFiles(string tracefilename);
 
 	// mostly for other simulators
@@ -61,6 +97,11 @@ class MultiChannelMemorySystem : public SimulatorObject
 
 	//output file
 	std::ofstream visDataOut;
+	//the epoch statistics with VIS_FILE_FORMAT=binary
+	BinaryStatsWriter binaryStatsOut;
+
+	//parameters read from the ini files, shared by all channels
+	Config config;
 
 	private:
 		unsigned findChannelNumber(uint64_t addr);
@@ -70,8 +111,65 @@ class MultiChannelMemorySystem : public SimulatorObject
 		string systemIniFilename;
 		string traceFilename;
 		string pwd;
+		bool outputFilesInitialized;
 		static void mkdirIfNotExist(string path);
 		static bool fileExists(string path); 
 
+		// With PARALLEL_BATCH_CYCLES set, update() only counts cycles and
+		// the channels catch up a batch at a time, each on its own thread.
+		// Transactions wait in channelInput until their cycle comes up and
+		// completions are collected per channel and reported in cycle
+		// order once the batch is done.
+		struct TimedTransaction
+		{
+			uint64_t cycle;
+			Transaction trans;
+			bool queueIfFull; // added through addTransaction(bool, uint64_t)
+		};
+		class CompletionBuffer
+		{
+			public:
+			struct Completion
+			{
+				uint64_t cycle;
+				uint64_t address;
+				unsigned channel;
+				bool isWrite;
+			};
+			vector<Completion> completions;
+			void readDone(unsigned id, uint64_t address, uint64_t cycle);
+			void writeDone(unsigned id, uint64_t address, uint64_t cycle);
+		};
+		struct ChannelWorker
+		{
+			MultiChannelMemorySystem *memorySystem;
+			unsigned channel;
+			pthread_t thread;
+		};
+		bool isParallel();
+		bool channelHasRoom(unsigned channel, bool isWrite, unsigned requestor);
+		void runChannel(unsigned channel, uint64_t endCycle);
+		void syncChannels(uint64_t endCycle);
+		void deliverCompletions();
+		static bool completesBefore(const CompletionBuffer::Completion &a, const CompletionBuffer::Completion &b);
+		void startWorkers();
+		static void *workerMain(void *arg);
+
+		vector< vector<TimedTransaction> > channelInput;
+		vector<CompletionBuffer> completionBuffers;
+		vector<TransactionCompleteCB *> bufferCallbacks;
+		TransactionCompleteCB *readDoneCB;
+		TransactionCompleteCB *writeDoneCB;
+		CompletionArray completionArray;
+
+		vector<ChannelWorker> workers;
+		pthread_mutex_t batchLock;
+		pthread_cond_t batchStart;
+		pthread_cond_t batchDone;
+		uint64_t batchEnd;
+		unsigned batchNumber;
+		unsigned workersRunning;
+		bool stopWorkers;
+
 	};
 }
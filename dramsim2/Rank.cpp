@@ -37,22 +37,24 @@
 using namespace std;
 using namespace DRAMSim;
 
-Rank::Rank() :
+Rank::Rank(const Config &config) :
 		// store the rank #, mostly for convenience and printing
 		id(-1),
 		isPowerDown(false),
+		config(config),
 		refreshWaiting(false),
-		readReturnCountdown(0)
+		readReturnCycle(0)
 {
 
 	memoryController = NULL;
+	busPacketPool = NULL;
 	outgoingDataPacket = NULL;
 	dataCyclesLeft = 0;
-	bankStates = vector<BankState>(NUM_BANKS, BankState());
+	bankStates = vector<BankState>(config.NUM_BANKS, BankState());
 	currentClockCycle = 0;
 
 #ifndef NO_STORAGE
-	banks = vector<Bank>(NUM_BANKS, Bank());
+	banks = vector<Bank>(config.NUM_BANKS, Bank(config));
 #endif
 
 }
@@ -70,18 +72,24 @@ void Rank::attachMemoryController(MemoryController *memoryController)
 	this->memoryController = memoryController;
 }
 
+// commands received from the bus are given back to this pool
+void Rank::attachBusPacketPool(BusPacketPool *pool)
+{
+	this->busPacketPool = pool;
+}
+
 void Rank::receiveFromBus(BusPacket *packet)
 {
 	BusPacket returnPacket;
 
-	if (DEBUG_BUS)
+	if (config.DEBUG_BUS)
 	{
 		PRINTN(" -- R" << this->id << " Receiving On Bus    : ");
 		packet->print();
 	}
-	if (VERIFICATION_OUTPUT)
+	if (config.VERIFICATION_OUTPUT)
 	{
-		packet->print(currentClockCycle,false);
+		packet->print(config.cmd_verify_out,currentClockCycle,false);
 	}
 
 	switch (packet->busPacketType)
@@ -98,11 +106,11 @@ void Rank::receiveFromBus(BusPacket *packet)
 		}
 
 		//update state table
-		bankStates[packet->bank].nextPrecharge = max(bankStates[packet->bank].nextPrecharge, currentClockCycle + READ_TO_PRE_DELAY);
-		for (size_t i=0;i<NUM_BANKS;i++)
+		bankStates[packet->bank].nextPrecharge = max(bankStates[packet->bank].nextPrecharge, currentClockCycle + config.READ_TO_PRE_DELAY);
+		for (size_t i=0;i<config.NUM_BANKS;i++)
 		{
-			bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + max(tCCD, BL/2));
-			bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + READ_TO_WRITE_DELAY);
+			bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + max(config.tCCD, config.BL/2));
+			bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + config.READ_TO_WRITE_DELAY);
 		}
 
 		//get the read data and put it in the storage which delays until the appropriate time (RL)
@@ -112,7 +120,7 @@ void Rank::receiveFromBus(BusPacket *packet)
 		packet->busPacketType = DATA;
 #endif
 		readReturnPacket.push_back(packet);
-		readReturnCountdown.push_back(RL);
+		readReturnCycle.push_back(currentClockCycle + config.RL);
 		break;
 	case READ_P:
 		//make sure a read is allowed
@@ -126,12 +134,12 @@ void Rank::receiveFromBus(BusPacket *packet)
 
 		//update state table
 		bankStates[packet->bank].currentBankState = Idle;
-		bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + READ_AUTOPRE_DELAY);
-		for (size_t i=0;i<NUM_BANKS;i++)
+		bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + config.READ_AUTOPRE_DELAY);
+		for (size_t i=0;i<config.NUM_BANKS;i++)
 		{
 			//will set next read/write for all banks - including current (which shouldnt matter since its now idle)
-			bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + max(BL/2, tCCD));
-			bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + READ_TO_WRITE_DELAY);
+			bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + max(config.BL/2, config.tCCD));
+			bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + config.READ_TO_WRITE_DELAY);
 		}
 
 		//get the read data and put it in the storage which delays until the appropriate time (RL)
@@ -142,7 +150,7 @@ void Rank::receiveFromBus(BusPacket *packet)
 #endif
 
 		readReturnPacket.push_back(packet);
-		readReturnCountdown.push_back(RL);
+		readReturnCycle.push_back(currentClockCycle + config.RL);
 		break;
 	case WRITE:
 		//make sure a write is allowed
@@ -156,18 +164,18 @@ void Rank::receiveFromBus(BusPacket *packet)
 		}
 
 		//update state table
-		bankStates[packet->bank].nextPrecharge = max(bankStates[packet->bank].nextPrecharge, currentClockCycle + WRITE_TO_PRE_DELAY);
-		for (size_t i=0;i<NUM_BANKS;i++)
+		bankStates[packet->bank].nextPrecharge = max(bankStates[packet->bank].nextPrecharge, currentClockCycle + config.WRITE_TO_PRE_DELAY);
+		for (size_t i=0;i<config.NUM_BANKS;i++)
 		{
-			bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + WRITE_TO_READ_DELAY_B);
-			bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + max(BL/2, tCCD));
+			bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + config.WRITE_TO_READ_DELAY_B);
+			bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + max(config.BL/2, config.tCCD));
 		}
 
 		//take note of where data is going when it arrives
 		incomingWriteBank = packet->bank;
 		incomingWriteRow = packet->row;
 		incomingWriteColumn = packet->column;
-		delete(packet);
+		busPacketPool->release(packet);
 		break;
 	case WRITE_P:
 		//make sure a write is allowed
@@ -181,18 +189,18 @@ void Rank::receiveFromBus(BusPacket *packet)
 
 		//update state table
 		bankStates[packet->bank].currentBankState = Idle;
-		bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + WRITE_AUTOPRE_DELAY);
-		for (size_t i=0;i<NUM_BANKS;i++)
+		bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + config.WRITE_AUTOPRE_DELAY);
+		for (size_t i=0;i<config.NUM_BANKS;i++)
 		{
-			bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + max(tCCD, BL/2));
-			bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + WRITE_TO_READ_DELAY_B);
+			bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + max(config.tCCD, config.BL/2));
+			bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + config.WRITE_TO_READ_DELAY_B);
 		}
 
 		//take note of where data is going when it arrives
 		incomingWriteBank = packet->bank;
 		incomingWriteRow = packet->row;
 		incomingWriteColumn = packet->column;
-		delete(packet);
+		busPacketPool->release(packet);
 		break;
 	case ACTIVATE:
 		//make sure activate is allowed
@@ -206,30 +214,30 @@ void Rank::receiveFromBus(BusPacket *packet)
 		}
 
 		bankStates[packet->bank].currentBankState = RowActive;
-		bankStates[packet->bank].nextActivate = currentClockCycle + tRC;
+		bankStates[packet->bank].nextActivate = currentClockCycle + config.tRC;
 		bankStates[packet->bank].openRowAddress = packet->row;
 
 		//if AL is greater than one, then posted-cas is enabled - handle accordingly
-		if (AL>0)
+		if (config.AL>0)
 		{
-			bankStates[packet->bank].nextWrite = currentClockCycle + (tRCD-AL);
-			bankStates[packet->bank].nextRead = currentClockCycle + (tRCD-AL);
+			bankStates[packet->bank].nextWrite = currentClockCycle + (config.tRCD-config.AL);
+			bankStates[packet->bank].nextRead = currentClockCycle + (config.tRCD-config.AL);
 		}
 		else
 		{
-			bankStates[packet->bank].nextWrite = currentClockCycle + (tRCD-AL);
-			bankStates[packet->bank].nextRead = currentClockCycle + (tRCD-AL);
+			bankStates[packet->bank].nextWrite = currentClockCycle + (config.tRCD-config.AL);
+			bankStates[packet->bank].nextRead = currentClockCycle + (config.tRCD-config.AL);
 		}
 
-		bankStates[packet->bank].nextPrecharge = currentClockCycle + tRAS;
-		for (size_t i=0;i<NUM_BANKS;i++)
+		bankStates[packet->bank].nextPrecharge = currentClockCycle + config.tRAS;
+		for (size_t i=0;i<config.NUM_BANKS;i++)
 		{
 			if (i != packet->bank)
 			{
-				bankStates[i].nextActivate = max(bankStates[i].nextActivate, currentClockCycle + tRRD);
+				bankStates[i].nextActivate = max(bankStates[i].nextActivate, currentClockCycle + config.tRRD);
 			}
 		}
-		delete(packet); 
+		busPacketPool->release(packet); 
 		break;
 	case PRECHARGE:
 		//make sure precharge is allowed
@@ -241,21 +249,24 @@ void Rank::receiveFromBus(BusPacket *packet)
 		}
 
 		bankStates[packet->bank].currentBankState = Idle;
-		bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + tRP);
-		delete(packet); 
+		bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + config.tRP);
+		busPacketPool->release(packet); 
 		break;
 	case REFRESH:
 		refreshWaiting = false;
-		for (size_t i=0;i<NUM_BANKS;i++)
+		for (size_t i=0;i<config.NUM_BANKS;i++)
 		{
+			//a per bank refresh only needs (and only blocks) its own bank
+			if (config.refreshPolicy == PerBankRefresh && i != packet->bank)
+				continue;
 			if (bankStates[i].currentBankState != Idle)
 			{
 				ERROR("== Error - Rank " << id << " received a REF when not allowed");
 				exit(0);
 			}
-			bankStates[i].nextActivate = currentClockCycle + tRFC;
+			bankStates[i].nextActivate = currentClockCycle + (config.refreshPolicy == PerBankRefresh ? config.tRFCpb : config.tRFC);
 		}
-		delete(packet); 
+		busPacketPool->release(packet); 
 		break;
 	case DATA:
 		// TODO: replace this check with something that works?
@@ -275,7 +286,9 @@ void Rank::receiveFromBus(BusPacket *packet)
 #else
 		// end of the line for the write packet
 #endif
-		delete(packet);
+		// the copy MultiChannelMemorySystem::addTransaction() made
+		free(packet->data);
+		busPacketPool->release(packet);
 		break;
 	default:
 		ERROR("== Error - Unknown BusPacketType trying to be sent to Bank");
@@ -305,26 +318,19 @@ void Rank::update()
 		}
 	}
 
-	// decrement the counter for all packets waiting to be sent back
-	for (size_t i=0;i<readReturnCountdown.size();i++)
-	{
-		readReturnCountdown[i]--;
-	}
-
-
-	if (readReturnCountdown.size() > 0 && readReturnCountdown[0]==0)
+	if (readReturnCycle.size() > 0 && readReturnCycle[0] <= currentClockCycle)
 	{
 		// RL time has passed since the read was issued; this packet is
 		// ready to go out on the bus
 
 		outgoingDataPacket = readReturnPacket[0];
-		dataCyclesLeft = BL/2;
+		dataCyclesLeft = config.BL/2;
 
 		// remove the packet from the ranks
 		readReturnPacket.erase(readReturnPacket.begin());
-		readReturnCountdown.erase(readReturnCountdown.begin());
+		readReturnCycle.erase(readReturnCycle.begin());
 
-		if (DEBUG_BUS)
+		if (config.DEBUG_BUS)
 		{
 			PRINTN(" -- R" << this->id << " Issuing On Data Bus : ");
 			outgoingDataPacket->print();
@@ -338,7 +344,7 @@ void Rank::update()
 void Rank::powerDown()
 {
 	//perform checks
-	for (size_t i=0;i<NUM_BANKS;i++)
+	for (size_t i=0;i<config.NUM_BANKS;i++)
 	{
 		if (bankStates[i].currentBankState != Idle)
 		{
@@ -346,7 +352,7 @@ void Rank::powerDown()
 			exit(0);
 		}
 
-		bankStates[i].nextPowerUp = currentClockCycle + tCKE;
+		bankStates[i].nextPowerUp = currentClockCycle + config.tCKE;
 		bankStates[i].currentBankState = PowerDown;
 	}
 
@@ -364,7 +370,7 @@ void Rank::powerUp()
 
 	isPowerDown = false;
 
-	for (size_t i=0;i<NUM_BANKS;i++)
+	for (size_t i=0;i<config.NUM_BANKS;i++)
 	{
 		if (bankStates[i].nextPowerUp > currentClockCycle)
 		{
@@ -372,7 +378,7 @@ void Rank::powerUp()
 			ERROR(bankStates[i].nextPowerUp << "    " << currentClockCycle);
 			exit(0);
 		}
-		bankStates[i].nextActivate = currentClockCycle + tXP;
+		bankStates[i].nextActivate = currentClockCycle + config.tXP;
 		bankStates[i].currentBankState = Idle;
 	}
 }
@@ -57,9 +57,10 @@ private:
 
 public:
 	//functions
-	Rank();
+	Rank(const Config &config);
 	void receiveFromBus(BusPacket *packet);
 	void attachMemoryController(MemoryController *mc);
+	void attachBusPacketPool(BusPacketPool *pool);
 	int getId() const;
 	void setId(int id);
 	void update();
@@ -67,15 +68,17 @@ public:
 	void powerDown();
 
 	//fields
+	const Config &config;
 	vector<Bank> banks;
 	MemoryController *memoryController;
+	BusPacketPool *busPacketPool;
 	BusPacket *outgoingDataPacket;
 	unsigned dataCyclesLeft;
 	bool refreshWaiting;
 
 	//these are vectors so that each element is per-bank
 	vector<BusPacket *> readReturnPacket;
-	vector<unsigned> readReturnCountdown;
+	vector<uint64_t> readReturnCycle; // when each of readReturnPacket goes on the bus
 	vector<BankState> bankStates;
 };
 }
@@ -38,6 +38,8 @@
 #include <vector>
 #include <string>
 #include <cstdlib>
+#include <set>
+#include <algorithm>
 #include <stdint.h>
 #include "PrintMacros.h"
 
@@ -51,101 +53,6 @@
 
 
 
-//number of latencies per bucket in the latency histogram
-//TODO: move to system ini file
-#define HISTOGRAM_BIN_SIZE 10
-
-extern std::ofstream cmd_verify_out; //used by BusPacket.cpp if VERIFICATION_OUTPUT is enabled
-//extern std::ofstream visDataOut;
-
-//TODO: namespace these to DRAMSim:: 
-extern bool VERIFICATION_OUTPUT; // output suitable to feed to modelsim
-
-extern bool DEBUG_TRANS_Q;
-extern bool DEBUG_CMD_Q;
-extern bool DEBUG_ADDR_MAP;
-extern bool DEBUG_BANKSTATE;
-extern bool DEBUG_BUS;
-extern bool DEBUG_BANKS;
-extern bool DEBUG_POWER;
-extern bool USE_LOW_POWER;
-extern bool VIS_FILE_OUTPUT;
-
-extern uint64_t TOTAL_STORAGE;
-extern unsigned NUM_BANKS;
-extern unsigned NUM_RANKS;
-extern unsigned NUM_CHANS;
-extern unsigned NUM_ROWS;
-extern unsigned NUM_COLS;
-extern unsigned DEVICE_WIDTH;
-
-//in nanoseconds
-extern unsigned REFRESH_PERIOD;
-extern float tCK;
-
-extern unsigned CL;
-extern unsigned AL;
-#define RL (CL+AL)
-#define WL (RL-1)
-extern unsigned BL;
-extern unsigned tRAS;
-extern unsigned tRCD;
-extern unsigned tRRD;
-extern unsigned tRC;
-extern unsigned tRP;
-extern unsigned tCCD;
-extern unsigned tRTP;
-extern unsigned tWTR;
-extern unsigned tWR;
-extern unsigned tRTRS;
-extern unsigned tRFC;
-extern unsigned tFAW;
-extern unsigned tCKE;
-extern unsigned tXP;
-
-extern unsigned tCMD;
-
-extern unsigned IDD0;
-extern unsigned IDD1;
-extern unsigned IDD2P;
-extern unsigned IDD2Q;
-extern unsigned IDD2N;
-extern unsigned IDD3Pf;
-extern unsigned IDD3Ps;
-extern unsigned IDD3N;
-extern unsigned IDD4W;
-extern unsigned IDD4R;
-extern unsigned IDD5;
-extern unsigned IDD6;
-extern unsigned IDD6L;
-extern unsigned IDD7;
-extern float Vdd; 
-extern unsigned NUM_DEVICES;
-
-//same bank
-#define READ_TO_PRE_DELAY (AL+BL/2+max(((int)tRTP),2)-2)
-#define WRITE_TO_PRE_DELAY (WL+BL/2+tWR)
-#define READ_TO_WRITE_DELAY (RL+BL/2+tRTRS-WL)
-#define READ_AUTOPRE_DELAY (AL+tRTP+tRP)
-#define WRITE_AUTOPRE_DELAY (WL+BL/2+tWR+tRP)
-#define WRITE_TO_READ_DELAY_B (WL+BL/2+tWTR) //interbank
-#define WRITE_TO_READ_DELAY_R (WL+BL/2+tRTRS-RL) //interrank
-
-extern unsigned JEDEC_DATA_BUS_BITS;
-
-//Memory Controller related parameters
-extern unsigned TRANS_QUEUE_DEPTH;
-extern unsigned CMD_QUEUE_DEPTH;
-
-extern unsigned EPOCH_LENGTH;
-
-extern unsigned TOTAL_ROW_ACCESSES;
-
-extern std::string ROW_BUFFER_POLICY;
-extern std::string SCHEDULING_POLICY;
-extern std::string ADDRESS_MAPPING_SCHEME;
-extern std::string QUEUING_STRUCTURE;
-
 enum TraceType
 {
 	k6,
@@ -161,14 +68,27 @@ enum AddressMappingScheme
 	Scheme4,
 	Scheme5,
 	Scheme6,
-	Scheme7
+	Scheme7,
+	CustomScheme
+};
+
+// the fields addressMapping() splits an address into
+enum AddressField
+{
+	ChannelField,
+	RankField,
+	BankField,
+	RowField,
+	ColumnField,
+	NUM_ADDRESS_FIELDS
 };
 
 // used in MemoryController and CommandQueue
 enum RowBufferPolicy
 {
 	OpenPage,
-	ClosePage
+	ClosePage,
+	AdaptivePage // open page, but idle rows are closed after a timeout
 };
 
 // Only used in CommandQueue
@@ -178,25 +98,35 @@ enum QueuingStructure
 	PerRankPerBank
 };
 
+// all banks of a rank at once (REF) or one bank at a time (REFpb)
+enum RefreshPolicy
+{
+	AllBankRefresh,
+	PerBankRefresh
+};
+
+// the epoch statistics of the vis file as CSV text or in a BinaryStatsWriter file
+enum VisFileFormat
+{
+	CsvVisFile,
+	BinaryVisFile
+};
+
 enum SchedulingPolicy
 {
 	RankThenBankRoundRobin,
-	BankThenRankRoundRobin
+	BankThenRankRoundRobin,
+	FrFcfs,
+	FrFcfsCap
 };
 
 
-// set by IniReader.cpp
-
 
 namespace DRAMSim
 {
 typedef void (*returnCallBack_t)(unsigned id, uint64_t addr, uint64_t clockcycle);
 typedef void (*powerCallBack_t)(double bgpower, double burstpower, double refreshpower, double actprepower);
 
-extern RowBufferPolicy rowBufferPolicy;
-extern SchedulingPolicy schedulingPolicy;
-extern AddressMappingScheme addressMappingScheme;
-extern QueuingStructure queuingStructure;
 //
 //FUNCTIONS
 //
@@ -219,6 +149,213 @@ inline bool isPowerOfTwo(unsigned long x)
 	return (1UL<<dramsim_log2(x)) == x;
 }
 
+// the address mapping is compiled by compileAddressMapping() into these two
+// tables, applied in order: every extract ORs address bits into a field,
+// then every hash flips one field bit by the parity of some address bits
+struct AddressMapExtract
+{
+	uint64_t mask; // field |= ((address >> shift) & mask) << fieldShift
+	unsigned shift;
+	unsigned fieldShift;
+	AddressField field;
+};
+struct AddressMapHash
+{
+	uint64_t mask; // field ^= parity(address & mask) << fieldBit
+	unsigned fieldBit;
+	AddressField field;
+};
+
+// Everything read from the device and system ini files, plus the values
+// derived from them. Each MultiChannelMemorySystem owns one and hands it
+// down to its channels, so differently configured memories can share a
+// process.
+class Config
+{
+public:
+	bool VERIFICATION_OUTPUT; // output suitable to feed to modelsim
+
+	bool DEBUG_TRANS_Q;
+	bool DEBUG_CMD_Q;
+	bool DEBUG_ADDR_MAP;
+	bool DEBUG_BANKSTATE;
+	bool DEBUG_BUS;
+	bool DEBUG_BANKS;
+	bool DEBUG_POWER;
+	bool USE_LOW_POWER;
+	bool VIS_FILE_OUTPUT;
+
+	uint64_t TOTAL_STORAGE;
+	unsigned NUM_BANKS;
+	unsigned NUM_RANKS;
+	unsigned NUM_CHANS;
+	unsigned NUM_ROWS;
+	unsigned NUM_COLS;
+	unsigned DEVICE_WIDTH;
+
+	//in nanoseconds
+	unsigned REFRESH_PERIOD;
+	float tCK;
+
+	unsigned CL;
+	unsigned AL;
+	unsigned BL;
+	unsigned tRAS;
+	unsigned tRCD;
+	unsigned tRRD;
+	unsigned tRC;
+	unsigned tRP;
+	unsigned tCCD;
+	unsigned tRTP;
+	unsigned tWTR;
+	unsigned tWR;
+	unsigned tRTRS;
+	unsigned tRFC;
+	unsigned tRFCpb; // per bank refresh, only needed with REFRESH_POLICY=per_bank
+	unsigned tFAW;
+	unsigned tCKE;
+	unsigned tXP;
+
+	unsigned tCMD;
+
+	unsigned IDD0;
+	unsigned IDD1;
+	unsigned IDD2P;
+	unsigned IDD2Q;
+	unsigned IDD2N;
+	unsigned IDD3Pf;
+	unsigned IDD3Ps;
+	unsigned IDD3N;
+	unsigned IDD4W;
+	unsigned IDD4R;
+	unsigned IDD5;
+	unsigned IDD6;
+	unsigned IDD6L;
+	unsigned IDD7;
+	float Vdd; 
+	unsigned NUM_DEVICES;
+
+	unsigned JEDEC_DATA_BUS_BITS;
+
+	//Memory Controller related parameters
+	unsigned TRANS_QUEUE_DEPTH;
+	unsigned CMD_QUEUE_DEPTH;
+
+	//cycles within an epoch
+	unsigned EPOCH_LENGTH;
+
+	//row accesses allowed before closing (open page)
+	unsigned TOTAL_ROW_ACCESSES;
+
+	//cycles an idle row stays open with the adaptive policy (0 to tune it per bank)
+	unsigned ROW_IDLE_TIMEOUT;
+
+	//write queue size (0 for none) and when it starts/stops draining
+	unsigned WRITE_QUEUE_DEPTH;
+	unsigned WRITE_HIGH_WATERMARK;
+	unsigned WRITE_LOW_WATERMARK;
+
+	//refreshes a rank (or bank) may fall behind by while reads are waiting for it (at most 8)
+	unsigned REFRESH_POSTPONE;
+
+	//cycles the channels run on their own threads between synchronizations (0 to update them in turn)
+	unsigned PARALLEL_BATCH_CYCLES;
+
+	// strings and their associated enums
+	std::string ROW_BUFFER_POLICY;
+	std::string SCHEDULING_POLICY;
+	std::string ADDRESS_MAPPING_SCHEME;
+	std::string QUEUING_STRUCTURE;
+	std::string REFRESH_POLICY;
+	std::string VIS_FILE_FORMAT;
+
+	// with ADDRESS_MAPPING_SCHEME=custom: the address bits of each field,
+	// lowest field bit first (e.g. "6-8"), and optionally a mask per field
+	// bit whose address bits are XORed into it (e.g. "0x3000,0x6000")
+	std::string ADDR_MAP_CHANNEL_BITS;
+	std::string ADDR_MAP_RANK_BITS;
+	std::string ADDR_MAP_BANK_BITS;
+	std::string ADDR_MAP_ROW_BITS;
+	std::string ADDR_MAP_COL_BITS;
+	std::string ADDR_MAP_CHANNEL_XOR;
+	std::string ADDR_MAP_RANK_XOR;
+	std::string ADDR_MAP_BANK_XOR;
+	std::string ADDR_MAP_ROW_XOR;
+	std::string ADDR_MAP_COL_XOR;
+
+	// per requestor (Transaction::requestor), comma separated: the most
+	// transactions it may hold in a channel's queues (0 for no limit) and
+	// its priority when they move on to the command queue (higher first).
+	// Requestors past the end of a list get 0
+	std::string REQUESTOR_QUEUE_LIMITS;
+	std::string REQUESTOR_PRIORITIES;
+
+	// set from the strings above by IniReader::InitEnumsFromStrings()
+	RowBufferPolicy rowBufferPolicy;
+	SchedulingPolicy schedulingPolicy;
+	AddressMappingScheme addressMappingScheme;
+	QueuingStructure queuingStructure;
+	RefreshPolicy refreshPolicy;
+	VisFileFormat visFileFormat;
+	std::vector<unsigned> requestorQueueLimits;
+	std::vector<unsigned> requestorPriorities;
+
+	// ini keys that have been set, for IniReader::CheckIfAllSet()
+	std::set<std::string> keysSet;
+
+	// everything below is filled in by computeDerived() once NUM_RANKS is known
+	unsigned RL;
+	unsigned WL;
+
+	//same bank
+	unsigned READ_TO_PRE_DELAY;
+	unsigned WRITE_TO_PRE_DELAY;
+	unsigned READ_TO_WRITE_DELAY;
+	unsigned READ_AUTOPRE_DELAY;
+	unsigned WRITE_AUTOPRE_DELAY;
+	unsigned WRITE_TO_READ_DELAY_B; //interbank
+	unsigned WRITE_TO_READ_DELAY_R; //interrank
+
+	// bytes per transaction and the address field widths (in bits) used by
+	// addressMapping()
+	unsigned transactionSize;
+	unsigned byteOffsetWidth;
+	unsigned colLowBitWidth;
+	unsigned channelBitWidth, rankBitWidth, bankBitWidth, rowBitWidth, colHighBitWidth;
+
+	// filled in by compileAddressMapping() once the widths are known
+	std::vector<AddressMapExtract> addressMapExtracts;
+	std::vector<AddressMapHash> addressMapHashes;
+
+	// opened by MultiChannelMemorySystem if VERIFICATION_OUTPUT is set; the
+	// ranks write the commands they receive to it
+	mutable std::ofstream cmd_verify_out;
+
+	void computeDerived()
+	{
+		RL = CL+AL;
+		WL = RL-1;
+		READ_TO_PRE_DELAY = AL+BL/2+std::max(((int)tRTP),2)-2;
+		WRITE_TO_PRE_DELAY = WL+BL/2+tWR;
+		READ_TO_WRITE_DELAY = RL+BL/2+tRTRS-WL;
+		READ_AUTOPRE_DELAY = AL+tRTP+tRP;
+		WRITE_AUTOPRE_DELAY = WL+BL/2+tWR+tRP;
+		WRITE_TO_READ_DELAY_B = WL+BL/2+tWTR;
+		WRITE_TO_READ_DELAY_R = WL+BL/2+tRTRS-RL;
+
+		transactionSize = (JEDEC_DATA_BUS_BITS/8)*BL;
+		// a burst moves JEDEC_DATA_BUS_BITS/8 bytes, and the column bits
+		// within a transaction (colLow) are always zero
+		byteOffsetWidth = dramsim_log2(JEDEC_DATA_BUS_BITS/8);
+		colLowBitWidth = dramsim_log2(transactionSize) - byteOffsetWidth;
+		channelBitWidth = dramsim_log2(NUM_CHANS);
+		rankBitWidth = dramsim_log2(NUM_RANKS);
+		bankBitWidth = dramsim_log2(NUM_BANKS);
+		rowBitWidth = dramsim_log2(NUM_ROWS);
+		colHighBitWidth = dramsim_log2(NUM_COLS) - colLowBitWidth;
+	}
+};
+
 
 };
 
@@ -41,11 +41,17 @@
 #include <getopt.h>
 #include <map>
 #include <list>
+#include <unordered_map>
+#include <iomanip>
+#include <sys/time.h>
+#include <pthread.h>
 
 #include "SystemConfiguration.h"
 #include "MemorySystem.h"
 #include "MultiChannelMemorySystem.h"
 #include "Transaction.h"
+#include "TraceReader.h"
+#include "TrafficGenerator.h"
 
 
 using namespace DRAMSim;
@@ -138,8 +144,9 @@ class TransactionReceiver
 void usage()
 {
 	cout << "DRAMSim2 Usage: " << endl;
-	cout << "DRAMSim -t tracefile -s system.ini -d ini/device.ini [-c #] [-p pwd] [-q] [-S 2048] [-n] [-o OPTION_A=1234]" <<endl;
-	cout << "\t-t, --tracefile=FILENAME \tspecify a tracefile to run  "<<endl;
+	cout << "DRAMSim -t tracefile -s system.ini -d ini/device.ini [-c #] [-p pwd] [-q] [-S 2048] [-n] [-b] [-o OPTION_A=1234] [-x OPTION_A=1,OPTION_B=2 ...] [-C out.bin]" <<endl;
+	cout << "DRAMSim -g PATTERN[,KEY=VALUE...] -s system.ini -d ini/device.ini [-c #] [-S 2048] [-o OPTION_A=1234]" <<endl;
+	cout << "\t-t, --tracefile=FILENAME \tspecify a tracefile to run (text, optionally gzip or zstd compressed, or binary)"<<endl;
 	cout << "\t-s, --systemini=FILENAME \tspecify an ini file that describes the memory system parameters  "<<endl;
 	cout << "\t-d, --deviceini=FILENAME \tspecify an ini file that describes the device-level parameters"<<endl;
 	cout << "\t-c, --numcycles=# \t\tspecify number of cycles to run the simulation for [default=30] "<<endl;
@@ -148,10 +155,30 @@ void usage()
 	cout << "\t-p, --pwd=DIRECTORY\t\tSet the working directory (i.e. usually DRAMSim directory where ini/ and results/ are)"<<endl;
 	cout << "\t-S, --size=# \t\t\tSize of the memory system in megabytes [default=2048M]"<<endl;
 	cout << "\t-n, --notiming \t\t\tDo not use the clock cycle information in the trace file"<<endl;
+	cout << "\t-b, --benchmark \t\tReport the wall-clock time and simulation speed at the end"<<endl;
+	cout << "\t-C, --convert=FILENAME \t\twrite the trace to FILENAME in the binary trace format and exit"<<endl;
+	cout << "\t-x, --sweep=OPTION_A=1,OPTION_B=2\tadd a configuration to a sweep; the trace is parsed once and replayed into"<<endl;
+	cout << "\t\t\t\t\teach configuration on its own thread, then a table comparing them is printed"<<endl;
+	cout << "\t-g, --generate=PATTERN[,KEY=VALUE...]\tinstead of a trace, run synthetic traffic and print the achieved bandwidth,"<<endl;
+	cout << "\t\t\t\t\tread latency and simulation speed. PATTERN is stream, stride, random, chase (each"<<endl;
+	cout << "\t\t\t\t\tchain waits for its last read), hammer (alternates between rows) or mix (random"<<endl;
+	cout << "\t\t\t\t\twith 30% writes). KEYs: rate=transactions per cycle [1], or LOW:HIGH:STEP for a"<<endl;
+	cout << "\t\t\t\t\tcurve; footprint=bytes [256M]; outstanding=# [64, chains for chase: 1];"<<endl;
+	cout << "\t\t\t\t\tstride=bytes [4096]; rows=# [2]; writes=share of writes; seed=#"<<endl;
+}
+
+//wall-clock time in seconds, for --benchmark
+static double wallTime()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * 1e-6;
 }
 #endif
 
-void *parseTraceFileLine(string &line, uint64_t &addr, enum TransactionType &transType, uint64_t &clockCycle, TraceType type, bool useClockCycle)
+//dataBytes is the size of a transaction; the write data buffer returned is at
+//	least that big so the banks can copy a whole transaction out of it
+void *parseTraceFileLine(string &line, uint64_t &addr, enum TransactionType &transType, uint64_t &clockCycle, TraceType type, bool useClockCycle, size_t dataBytes)
 {
 	size_t previousIndex=0;
 	size_t spaceIndex=0;
@@ -294,10 +321,11 @@ void *parseTraceFileLine(string &line, uint64_t &addr, enum TransactionType &tra
 #ifndef NO_STORAGE
 		if (dataStr.size() > 0 && transType == DATA_WRITE)
 		{
-			// 32 bytes of data per transaction
-			dataBuffer = (uint64_t *)calloc(sizeof(uint64_t),4);
+			// a transaction of data, but at least 32 bytes
+			size_t dataWords = max((size_t)4, dataBytes/sizeof(uint64_t));
+			dataBuffer = (uint64_t *)calloc(sizeof(uint64_t),dataWords);
 			size_t strlen = dataStr.size();
-			for (int i=0; i < 4; i++)
+			for (size_t i=0; i < dataWords; i++)
 			{
 				size_t startIndex = i*16;
 				if (startIndex > strlen)
@@ -322,31 +350,391 @@ void *parseTraceFileLine(string &line, uint64_t &addr, enum TransactionType &tra
 
 #ifndef _SIM_
 
-void alignTransactionAddress(Transaction &trans)
+void alignTransactionAddress(const Config &config, Transaction &trans)
 {
 	// zero out the low order bits which correspond to the size of a transaction
 
-	unsigned throwAwayBits = dramsim_log2((BL*JEDEC_DATA_BUS_BITS/8));
+	unsigned throwAwayBits = dramsim_log2(config.transactionSize);
 
 	trans.address >>= throwAwayBits;
 	trans.address <<= throwAwayBits;
 }
+
+// one configuration of a --sweep run: its memory system, the thread that
+// replays the trace into it and what it measured
+class SweepRun
+{
+	public:
+		SweepRun(const string &label_, MultiChannelMemorySystem *memorySystem_, const vector<TraceRecord> &trace_, unsigned numCycles_) :
+			label(label_), memorySystem(memorySystem_), trace(trace_), numCycles(numCycles_),
+			transactionsAdded(0), readsDone(0), writesDone(0), totalReadLatency(0), maxReadLatency(0), elapsed(0.0)
+		{}
+
+		void add_pending(const Transaction &t, uint64_t cycle)
+		{
+			transactionsAdded++;
+			if (t.transactionType == DATA_READ)
+			{
+				pendingReads[t.address].push_back(cycle);
+			}
+		}
+
+		void read_complete(unsigned id, uint64_t address, uint64_t done_cycle)
+		{
+			map<uint64_t, list<uint64_t> >::iterator it = pendingReads.find(address);
+			if (it == pendingReads.end() || it->second.empty())
+			{
+				ERROR("Cant find a pending read for this one");
+				exit(-1);
+			}
+			uint64_t latency = done_cycle - it->second.front();
+			it->second.pop_front();
+			if (it->second.empty())
+			{
+				pendingReads.erase(it);
+			}
+			readsDone++;
+			totalReadLatency += latency;
+			maxReadLatency = max(maxReadLatency, latency);
+		}
+		void write_complete(unsigned id, uint64_t address, uint64_t done_cycle)
+		{
+			writesDone++;
+		}
+
+		string label;
+		MultiChannelMemorySystem *memorySystem;
+		const vector<TraceRecord> &trace;
+		unsigned numCycles;
+		pthread_t thread;
+
+		uint64_t transactionsAdded;
+		uint64_t readsDone;
+		uint64_t writesDone;
+		uint64_t totalReadLatency;
+		uint64_t maxReadLatency;
+		double elapsed;
+
+	private:
+		map<uint64_t, list<uint64_t> > pendingReads; // address -> cycles the reads were added
+};
+
+// parses the rest of traceFile into trace
+static void loadTrace(TraceReader &traceFile, TraceType traceType, bool useClockCycle, vector<TraceRecord> &trace)
+{
+	if (traceFile.isBinary())
+	{
+		TraceRecord record;
+		while (traceFile.getRecord(record))
+		{
+			if (!useClockCycle)
+			{
+				record.cycle = 0;
+			}
+			trace.push_back(record);
+		}
+		return;
+	}
+
+	string line;
+	uint64_t addr;
+	uint64_t clockCycle=0;
+	enum TransactionType transType;
+	while (traceFile.getline(line))
+	{
+		if (line.size() == 0)
+		{
+			continue;
+		}
+		void *data = parseTraceFileLine(line, addr, transType, clockCycle, traceType, useClockCycle, 0);
+		// only the timing is compared, so the write data isn't kept
+		free(data);
+
+		TraceRecord record;
+		record.address = addr;
+		record.cycle = clockCycle;
+		record.isWrite = (transType == DATA_WRITE);
+		trace.push_back(record);
+	}
+}
+
+// same as the loop in main(), but from the parsed trace
+static void *replayTrace(void *arg)
+{
+	SweepRun &run = *(SweepRun *)arg;
+	MultiChannelMemorySystem *memorySystem = run.memorySystem;
+	Transaction trans;
+	uint64_t clockCycle=0;
+	bool pendingTrans = false;
+	size_t next = 0;
+
+	double startTime = wallTime();
+	for (size_t i=0;i<run.numCycles;i++)
+	{
+		if (!pendingTrans)
+		{
+			if (next < run.trace.size())
+			{
+				const TraceRecord &record = run.trace[next++];
+				trans = Transaction(record.isWrite ? DATA_WRITE : DATA_READ, record.address, NULL);
+				alignTransactionAddress(memorySystem->config, trans);
+				clockCycle = record.cycle;
+				pendingTrans = i < clockCycle || !memorySystem->addTransaction(trans);
+				if (!pendingTrans)
+				{
+					run.add_pending(trans, i);
+				}
+			}
+		}
+		else if (i >= clockCycle)
+		{
+			pendingTrans = !memorySystem->addTransaction(trans);
+			if (!pendingTrans)
+			{
+				run.add_pending(trans, i);
+			}
+		}
+
+		memorySystem->update();
+	}
+	run.elapsed = wallTime() - startTime;
+	return NULL;
+}
+
+// Parses the trace once and replays it into one memory system per entry of
+// sweepConfigs (each a comma separated list of KEY=VALUE overrides, on top
+// of iniOverrides), each on its own thread, then prints a table comparing them
+static void runSweep(const vector<string> &sweepConfigs, const vector<string> &iniOverrides,
+                     const string &deviceIniFilename, const string &systemIniFilename, const string &pwdString,
+                     const string &traceFileName, TraceReader &traceFile, TraceType traceType, unsigned megsOfMemory,
+                     unsigned numCycles, bool useClockCycle, bool benchmark)
+{
+	vector<TraceRecord> trace;
+	double startTime = wallTime();
+	loadTrace(traceFile, traceType, useClockCycle, trace);
+	traceFile.close();
+	double parseTime = wallTime() - startTime;
+
+	// the per-epoch output of the runs would interleave, so only the table is printed
+	SHOW_SIM_OUTPUT = false;
+
+	vector<SweepRun *> runs;
+	for (size_t i=0; i<sweepConfigs.size(); i++)
+	{
+		vector<string> overrides = iniOverrides;
+		stringstream ss(sweepConfigs[i]);
+		string keyValuePair;
+		while (getline(ss, keyValuePair, ','))
+		{
+			overrides.push_back(keyValuePair);
+		}
+
+		MultiChannelMemorySystem *memorySystem = new MultiChannelMemorySystem(deviceIniFilename, systemIniFilename, pwdString, traceFileName, megsOfMemory, overrides);
+		SweepRun *run = new SweepRun(sweepConfigs[i], memorySystem, trace, numCycles);
+		TransactionCompleteCB *read_cb = new Callback<SweepRun, void, unsigned, uint64_t, uint64_t>(run, &SweepRun::read_complete);
+		TransactionCompleteCB *write_cb = new Callback<SweepRun, void, unsigned, uint64_t, uint64_t>(run, &SweepRun::write_complete);
+		memorySystem->RegisterCallbacks(read_cb, write_cb, NULL);
+		// here rather than in the first update(), where the threads would
+		// race to create the results directories and number the .vis files
+		memorySystem->InitOutputFiles(traceFileName);
+		runs.push_back(run);
+	}
+
+	startTime = wallTime();
+	for (size_t i=0; i<runs.size(); i++)
+	{
+		if (pthread_create(&runs[i]->thread, NULL, replayTrace, runs[i]) != 0)
+		{
+			ERROR("Could not start the thread for '"<<runs[i]->label<<"'");
+			exit(-1);
+		}
+	}
+	for (size_t i=0; i<runs.size(); i++)
+	{
+		pthread_join(runs[i]->thread, NULL);
+	}
+	double elapsed = wallTime() - startTime;
+
+	size_t labelWidth = 6;
+	for (size_t i=0; i<runs.size(); i++)
+	{
+		labelWidth = max(labelWidth, runs[i]->label.size());
+	}
+
+	cout << "== Sweep of "<<runs.size()<<" configurations over "<<trace.size()<<" trace lines, "<<numCycles<<" cycles each"<<endl;
+	cout << left << setw(labelWidth) << "config" << right
+	     << setw(12) << "trans" << setw(12) << "reads" << setw(12) << "writes"
+	     << setw(14) << "avg rd lat" << setw(12) << "max rd lat" << setw(10) << "GB/s";
+	if (benchmark)
+	{
+		cout << setw(10) << "wall s";
+	}
+	cout << endl;
+	cout.setf(ios::fixed, ios::floatfield);
+	for (size_t i=0; i<runs.size(); i++)
+	{
+		SweepRun &run = *runs[i];
+		const Config &config = run.memorySystem->config;
+		double averageLatency = run.readsDone ? (double)run.totalReadLatency / run.readsDone : 0.0;
+		// bytes per ns is GB/s
+		double bandwidth = (double)(run.readsDone + run.writesDone) * config.transactionSize / (numCycles * config.tCK);
+		cout << left << setw(labelWidth) << run.label << right
+		     << setw(12) << run.transactionsAdded << setw(12) << run.readsDone << setw(12) << run.writesDone
+		     << setw(14) << setprecision(1) << averageLatency << setw(12) << run.maxReadLatency
+		     << setw(10) << setprecision(3) << bandwidth;
+		if (benchmark)
+		{
+			cout << setw(10) << setprecision(3) << run.elapsed;
+		}
+		cout << endl;
+	}
+	if (benchmark)
+	{
+		cout << "== Parsed the trace in "<<parseTime<<" s, ran the sweep in "<<elapsed<<" s"<<endl;
+	}
+
+	for (size_t i=0; i<runs.size(); i++)
+	{
+		// writes the final stats to the vis file
+		runs[i]->memorySystem->printStats();
+		delete runs[i]->memorySystem;
+		delete runs[i];
+	}
+}
+
+// Runs the traffic of params once per rate, each on a fresh memory system
+// for numCycles, and prints the achieved bandwidth and read latency against
+// the offered rate, along with the simulation speed
+static void runTraffic(const TrafficParams &params, const vector<string> &iniOverrides,
+                       const string &deviceIniFilename, const string &systemIniFilename, const string &pwdString,
+                       unsigned megsOfMemory, unsigned numCycles)
+{
+	if (params.footprint > ((uint64_t)megsOfMemory << 20))
+	{
+		ERROR("The footprint ("<<params.footprint<<" bytes) is larger than the memory ("<<megsOfMemory<<" MB)");
+		exit(-1);
+	}
+	// only the table is printed
+	SHOW_SIM_OUTPUT = false;
+	string runName = "synthetic_" + params.name;
+
+	// the memory systems print as they are set up, so the table waits until the end
+	stringstream table;
+	table.setf(ios::fixed, ios::floatfield);
+
+	double totalElapsed = 0.0;
+	for (size_t r=0; r<params.rates.size(); r++)
+	{
+		double rate = params.rates[r];
+		MultiChannelMemorySystem *memorySystem = new MultiChannelMemorySystem(deviceIniFilename, systemIniFilename, pwdString, runName, megsOfMemory, iniOverrides);
+		const Config &config = memorySystem->config;
+		// nothing completes that wasn't in flight
+		vector<TransactionCompletion> completions(params.outstanding);
+		memorySystem->RegisterCompletionBuffer(&completions[0], completions.size());
+		TrafficGenerator generator(params, config.transactionSize);
+
+		unordered_map<uint64_t, list<uint64_t> > pendingReads; // address -> cycles the reads were added
+		LatencyHistogram readLatencies;
+		uint64_t writesDone = 0;
+		unsigned inFlight = 0;
+		// transactions owed to the rate, in millionths so that rates like 0.1
+		// add up exactly; what the memory system can't take within a cycle is
+		// dropped rather than queued up
+		const uint64_t unit = 1000000;
+		uint64_t rateUnits = (uint64_t)(rate * unit + 0.5);
+		uint64_t credit = 0;
+
+		double startTime = wallTime();
+		for (size_t i=0;i<numCycles;i++)
+		{
+			credit = min(credit + rateUnits, max(rateUnits, unit));
+			while (credit >= unit && inFlight < params.outstanding && generator.ready())
+			{
+				Transaction trans(generator.nextIsWrite() ? DATA_WRITE : DATA_READ, generator.nextAddress(), NULL);
+				if (!memorySystem->addTransaction(trans))
+				{
+					break;
+				}
+				if (trans.transactionType == DATA_READ)
+				{
+					pendingReads[trans.address].push_back(i);
+				}
+				generator.accept();
+				credit -= unit;
+				inFlight++;
+			}
+
+			memorySystem->update();
+
+			size_t numCompletions = memorySystem->takeCompletions();
+			for (size_t j=0; j<numCompletions; j++)
+			{
+				const TransactionCompletion &completion = completions[j];
+				if (completion.isWrite)
+				{
+					writesDone++;
+				}
+				else
+				{
+					unordered_map<uint64_t, list<uint64_t> >::iterator it = pendingReads.find(completion.address);
+					if (it == pendingReads.end() || it->second.empty())
+					{
+						ERROR("Cant find a pending read for this one");
+						exit(-1);
+					}
+					readLatencies.record(completion.cycle - it->second.front());
+					it->second.pop_front();
+					if (it->second.empty())
+					{
+						pendingReads.erase(it);
+					}
+				}
+				inFlight--;
+				generator.complete();
+			}
+		}
+		double elapsed = wallTime() - startTime;
+		totalElapsed += elapsed;
+
+		MemoryStats stats = memorySystem->getStats();
+		uint64_t columnAccesses = stats.rowBuffer.hits + stats.rowBuffer.misses + stats.rowBuffer.conflicts;
+		// bytes per ns is GB/s
+		double offered = rate * config.transactionSize / config.tCK;
+		double bandwidth = (double)(readLatencies.count() + writesDone) * config.transactionSize / (numCycles * config.tCK);
+		table << setw(8) << setprecision(3) << rate << setw(14) << offered << setw(10) << bandwidth
+		      << setw(12) << readLatencies.count() << setw(12) << writesDone
+		      << setw(12) << setprecision(1) << readLatencies.mean() << setw(12) << readLatencies.percentile(0.99)
+		      << setw(12) << (columnAccesses ? 100.0 * stats.rowBuffer.hits / columnAccesses : 0.0)
+		      << setw(12) << setprecision(3) << numCycles / elapsed / 1e6 << endl;
+		delete memorySystem;
+	}
+	cout << "== "<<params.name<<" traffic over "<<(params.footprint >> 10)<<" KB, "<<params.outstanding
+	     <<(params.pattern == ChaseTraffic ? " chains, " : " outstanding, ")<<numCycles<<" cycles per rate"<<endl;
+	cout << setw(8) << "rate" << setw(14) << "offered GB/s" << setw(10) << "GB/s"
+	     << setw(12) << "reads" << setw(12) << "writes" << setw(12) << "avg rd lat" << setw(12) << "p99 rd lat"
+	     << setw(12) << "row hit %" << setw(12) << "Mcycles/s" << endl;
+	cout << table.str();
+	cout.setf(ios::fixed, ios::floatfield);
+	cout << "== Simulated "<<params.rates.size()*numCycles<<" cycles in "<<setprecision(3)<<totalElapsed<<" s: "
+	     << setprecision(0) << params.rates.size()*numCycles/totalElapsed<<" cycles/s"<<endl;
+}
+
 int main(int argc, char **argv)
 {
 	int c;
-	TraceType traceType;
+	TraceType traceType = mase;
 	string traceFileName;
 	string systemIniFilename("system.ini");
 	string deviceIniFilename;
 	string pwdString;
 	unsigned megsOfMemory=2048;
 	bool useClockCycle=true;
+	bool benchmark=false;
 
-	bool overrideOpt = false;
-	string overrideKey = "";
-	string overrideVal = "";
-	string tmp = "";
-	size_t equalsign;
+	vector<string> iniOverrides;
+	vector<string> sweepConfigs;
+	string binaryTraceFilename;
+	string trafficSpec;
 
 	unsigned numCycles=1000;
 	//getopt stuff
@@ -363,10 +751,15 @@ int main(int argc, char **argv)
 			{"quiet",  no_argument, &SHOW_SIM_OUTPUT, 'q'},
 			{"help", no_argument, 0, 'h'},
 			{"size", required_argument, 0, 'S'},
+			{"notiming", no_argument, 0, 'n'},
+			{"benchmark", no_argument, 0, 'b'},
+			{"sweep", required_argument, 0, 'x'},
+			{"convert", required_argument, 0, 'C'},
+			{"generate", required_argument, 0, 'g'},
 			{0, 0, 0, 0}
 		};
 		int option_index=0; //for getopt
-		c = getopt_long (argc, argv, "t:s:c:d:o:p:S:qn", long_options, &option_index);
+		c = getopt_long (argc, argv, "t:s:c:d:o:p:S:qnbx:C:g:", long_options, &option_index);
 		if (c == -1)
 		{
 			break;
@@ -414,12 +807,26 @@ int main(int argc, char **argv)
 		case 'n':
 			useClockCycle=false;
 			break;
+		case 'b':
+			benchmark=true;
+			break;
 		case 'o':
-			tmp = string(optarg);
-			equalsign = tmp.find_first_of('=');
-			overrideKey = tmp.substr(0,equalsign);
-			overrideVal = tmp.substr(equalsign+1,tmp.size()-equalsign+1);
-			overrideOpt = true;
+			if (string(optarg).find_first_of('=') == string::npos)
+			{
+				ERROR("-o expects KEY=VALUE, got '"<<optarg<<"'");
+				usage();
+				exit(-1);
+			}
+			iniOverrides.push_back(string(optarg));
+			break;
+		case 'x':
+			sweepConfigs.push_back(string(optarg));
+			break;
+		case 'C':
+			binaryTraceFilename = string(optarg);
+			break;
+		case 'g':
+			trafficSpec = string(optarg);
 			break;
 		case '?':
 			usage();
@@ -428,11 +835,26 @@ int main(int argc, char **argv)
 		}
 	}
 
+	if (trafficSpec.length() > 0)
+	{
+		if (deviceIniFilename.length() == 0)
+		{
+			ERROR("Please provide a device ini file");
+			usage();
+			exit(-1);
+		}
+		TrafficParams params;
+		parseTrafficSpec(trafficSpec, params);
+		runTraffic(params, iniOverrides, deviceIniFilename, systemIniFilename, pwdString, megsOfMemory, numCycles);
+		return 0;
+	}
+
 	// get the trace filename
 	string temp = traceFileName.substr(traceFileName.find_last_of("/")+1);
 
-	//get the prefix of the trace name
+	//get the prefix of the trace name (binary traces can be called anything)
 	temp = temp.substr(0,temp.find_first_of("_"));
+	bool knownTraceType = true;
 	if (temp=="mase")
 	{
 		traceType = mase;
@@ -446,11 +868,41 @@ int main(int argc, char **argv)
 		traceType = misc;
 	}
 	else
+	{
+		knownTraceType = false;
+	}
+
+	//ignore the pwd argument if the argument is an absolute path
+	if (pwdString.length() > 0 && traceFileName[0] != '/')
+	{
+		traceFileName = pwdString + "/" +traceFileName;
+	}
+
+	// plain, gzip'd or zstd compressed text, or a binary trace
+	TraceReader traceFile;
+	if (!traceFile.open(traceFileName))
+	{
+		cout << "== Error - Could not open trace file"<<endl;
+		exit(0);
+	}
+	if (!traceFile.isBinary() && !knownTraceType)
 	{
 		ERROR("== Unknown Tracefile Type : "<<temp);
 		exit(0);
 	}
 
+	if (binaryTraceFilename.length() > 0)
+	{
+		vector<TraceRecord> trace;
+		loadTrace(traceFile, traceType, true, trace);
+		if (!writeBinaryTrace(binaryTraceFilename, trace))
+		{
+			ERROR("Cannot write binary trace '"<<binaryTraceFilename<<"'");
+			exit(-1);
+		}
+		cout << "== Wrote "<<trace.size()<<" records to "<<binaryTraceFilename<<endl;
+		return 0;
+	}
 
 	// no default value for the default model name
 	if (deviceIniFilename.length() == 0)
@@ -460,20 +912,19 @@ int main(int argc, char **argv)
 		exit(-1);
 	}
 
+	DEBUG("== Loading trace file '"<<traceFileName<<"' == ");
 
-	//ignore the pwd argument if the argument is an absolute path
-	if (pwdString.length() > 0 && traceFileName[0] != '/')
+	if (sweepConfigs.size() > 0)
 	{
-		traceFileName = pwdString + "/" +traceFileName;
+		runSweep(sweepConfigs, iniOverrides, deviceIniFilename, systemIniFilename, pwdString,
+		         traceFileName, traceFile, traceType, megsOfMemory, numCycles, useClockCycle, benchmark);
+		return 0;
 	}
 
-	DEBUG("== Loading trace file '"<<traceFileName<<"' == ");
-
-	ifstream traceFile;
 	string line;
 
 
-	MultiChannelMemorySystem *memorySystem = new MultiChannelMemorySystem(deviceIniFilename, systemIniFilename, pwdString, traceFileName, megsOfMemory);
+	MultiChannelMemorySystem *memorySystem = new MultiChannelMemorySystem(deviceIniFilename, systemIniFilename, pwdString, traceFileName, megsOfMemory, iniOverrides);
 
 
 #ifdef RETURN_TRANSACTIONS
@@ -493,28 +944,42 @@ int main(int argc, char **argv)
 	int lineNumber = 0;
 	Transaction trans;
 	bool pendingTrans = false;
+	uint64_t transactionsAdded = 0;
 
-	traceFile.open(traceFileName.c_str());
-
-	if (!traceFile.is_open())
-	{
-		cout << "== Error - Could not open trace file"<<endl;
-		exit(0);
-	}
-
+	double startTime = wallTime();
 	for (size_t i=0;i<numCycles;i++)
 	{
 		if (!pendingTrans)
 		{
 			if (!traceFile.eof())
 			{
-				getline(traceFile, line);
+				bool haveTransaction = false;
+				if (traceFile.isBinary())
+				{
+					TraceRecord record;
+					if (traceFile.getRecord(record))
+					{
+						addr = record.address;
+						transType = record.isWrite ? DATA_WRITE : DATA_READ;
+						clockCycle = useClockCycle ? record.cycle : 0;
+						data = NULL;
+						haveTransaction = true;
+					}
+				}
+				else
+				{
+					traceFile.getline(line);
+					if (line.size() > 0)
+					{
+						data = parseTraceFileLine(line, addr, transType,clockCycle, traceType,useClockCycle, memorySystem->config.transactionSize);
+						haveTransaction = true;
+					}
+				}
 
-				if (line.size() > 0)
+				if (haveTransaction)
 				{
-					data = parseTraceFileLine(line, addr, transType,clockCycle, traceType,useClockCycle);
 					trans = Transaction(transType, addr, data);
-					alignTransactionAddress(trans); 
+					alignTransactionAddress(memorySystem->config, trans); 
 
 					if (i>=clockCycle)
 					{
@@ -524,9 +989,12 @@ int main(int argc, char **argv)
 						}
 						else
 						{
+							transactionsAdded++;
 #ifdef RETURN_TRANSACTIONS
 							transactionReceiver.add_pending(trans, i); 
 #endif
+							// the memory system copied it
+							free(trans.data);
 						}
 					}
 					else
@@ -552,17 +1020,29 @@ int main(int argc, char **argv)
 			pendingTrans = !(*memorySystem).addTransaction(trans);
 			if (!pendingTrans)
 			{
+				transactionsAdded++;
 #ifdef RETURN_TRANSACTIONS
 				transactionReceiver.add_pending(trans, i); 
 #endif
+				free(trans.data);
 			}
 		}
 
 		(*memorySystem).update();
 	}
+	if (pendingTrans)
+	{
+		free(trans.data);
+	}
+	double elapsed = wallTime() - startTime;
 
 	traceFile.close();
 	(*memorySystem).printStats();
+	if (benchmark)
+	{
+		cout << "== Simulated "<<numCycles<<" cycles and "<<transactionsAdded<<" transactions in "<<elapsed<<" s: "
+		     << numCycles/elapsed<<" cycles/s, "<<transactionsAdded/elapsed<<" transactions/s"<<endl;
+	}
 	// make valgrind happy
 	delete(memorySystem);
 }
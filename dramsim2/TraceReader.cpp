@@ -0,0 +1,450 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+
+
+
+
+
+
+//TraceReader.cpp
+//
+//Class file for the trace file reader
+//
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "TraceReader.h"
+#include "PrintMacros.h"
+
+using namespace DRAMSim;
+
+// lines or records in each block the prefetch thread hands over
+#define TRACE_BLOCK_LINES 4096
+#define TRACE_BLOCK_RECORDS 65536
+// blocks the prefetch thread may run ahead of the simulation
+#define TRACE_BLOCKS_AHEAD 4
+
+static uint64_t readLittleEndian(const unsigned char *bytes)
+{
+	uint64_t value = 0;
+	for (int i=7; i>=0; i--)
+	{
+		value = (value << 8) | bytes[i];
+	}
+	return value;
+}
+
+static void writeLittleEndian(unsigned char *bytes, uint64_t value)
+{
+	for (int i=0; i<8; i++)
+	{
+		bytes[i] = value & 0xff;
+		value >>= 8;
+	}
+}
+
+bool DRAMSim::writeBinaryTrace(const string &filename, const vector<TraceRecord> &records)
+{
+	FILE *out = fopen(filename.c_str(), "wb");
+	if (out == NULL)
+	{
+		return false;
+	}
+
+	unsigned char bytes[BINARY_TRACE_RECORD_BYTES];
+	memcpy(bytes, BINARY_TRACE_MAGIC, 8);
+	writeLittleEndian(bytes+8, records.size());
+	fwrite(bytes, 1, BINARY_TRACE_HEADER_BYTES, out);
+	for (size_t i=0; i<records.size(); i++)
+	{
+		writeLittleEndian(bytes, records[i].address);
+		writeLittleEndian(bytes+8, ((uint64_t)records[i].cycle << 1) | records[i].isWrite);
+		fwrite(bytes, 1, BINARY_TRACE_RECORD_BYTES, out);
+	}
+	bool failed = ferror(out);
+	return fclose(out) == 0 && !failed;
+}
+
+TraceReader::TraceReader() :
+	binary(false),
+	atEnd(false),
+	textFormat(PlainOrGzip),
+	gzTrace(NULL),
+#ifdef HAVE_ZSTD
+	zstdTrace(NULL),
+	zstdContext(NULL),
+#endif
+	mapped(NULL),
+	mappedLength(0),
+	numRecords(0),
+	current(NULL),
+	position(0),
+	prefetching(false),
+	stopPrefetch(false)
+{
+	pthread_mutex_init(&blockLock, NULL);
+	pthread_cond_init(&blockReady, NULL);
+	pthread_cond_init(&blockTaken, NULL);
+}
+
+TraceReader::~TraceReader()
+{
+	close();
+	pthread_mutex_destroy(&blockLock);
+	pthread_cond_destroy(&blockReady);
+	pthread_cond_destroy(&blockTaken);
+}
+
+bool TraceReader::open(const string &filename)
+{
+	close();
+
+	// the first bytes tell the formats apart
+	unsigned char magic[8];
+	FILE *in = fopen(filename.c_str(), "rb");
+	if (in == NULL)
+	{
+		return false;
+	}
+	size_t magicBytes = fread(magic, 1, sizeof(magic), in);
+	fclose(in);
+
+	binary = magicBytes == 8 && memcmp(magic, BINARY_TRACE_MAGIC, 8) == 0;
+	if (binary)
+	{
+		struct stat statBuf;
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if (fd < 0 || fstat(fd, &statBuf) != 0)
+		{
+			if (fd >= 0)
+			{
+				::close(fd);
+			}
+			return false;
+		}
+		mappedLength = statBuf.st_size;
+		void *map = mappedLength >= BINARY_TRACE_HEADER_BYTES ? mmap(NULL, mappedLength, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+		::close(fd);
+		if (map == MAP_FAILED)
+		{
+			ERROR("Cannot map binary trace '"<<filename<<"'");
+			exit(-1);
+		}
+		madvise(map, mappedLength, MADV_SEQUENTIAL);
+		mapped = (const unsigned char *)map;
+		numRecords = readLittleEndian(mapped+8);
+		if ((mappedLength - BINARY_TRACE_HEADER_BYTES) / BINARY_TRACE_RECORD_BYTES < numRecords)
+		{
+			ERROR("Binary trace '"<<filename<<"' should have "<<numRecords<<" records but is only "<<mappedLength<<" bytes");
+			exit(-1);
+		}
+	}
+	else if (magicBytes >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+	{
+#ifdef HAVE_ZSTD
+		textFormat = Zstd;
+		zstdTrace = fopen(filename.c_str(), "rb");
+		if (zstdTrace == NULL)
+		{
+			return false;
+		}
+		zstdContext = ZSTD_createDCtx();
+		zstdInput.resize(ZSTD_DStreamInSize());
+		zstdIn.src = &zstdInput[0];
+		zstdIn.size = 0;
+		zstdIn.pos = 0;
+#else
+		ERROR("'"<<filename<<"' is zstd compressed, rebuild with ZSTD=1 to read it");
+		exit(-1);
+#endif
+	}
+	else
+	{
+		// zlib reads uncompressed files as they are
+		textFormat = PlainOrGzip;
+		gzTrace = gzopen(filename.c_str(), "rb");
+		if (gzTrace == NULL)
+		{
+			return false;
+		}
+		gzbuffer(gzTrace, 1<<17);
+	}
+
+	atEnd = false;
+	stopPrefetch = false;
+	if (pthread_create(&prefetchThread, NULL, prefetchMain, this) != 0)
+	{
+		ERROR("Cannot start the trace prefetch thread");
+		exit(-1);
+	}
+	prefetching = true;
+	return true;
+}
+
+void TraceReader::close()
+{
+	if (prefetching)
+	{
+		pthread_mutex_lock(&blockLock);
+		stopPrefetch = true;
+		pthread_cond_broadcast(&blockTaken);
+		pthread_mutex_unlock(&blockLock);
+		pthread_join(prefetchThread, NULL);
+		prefetching = false;
+	}
+	delete current;
+	current = NULL;
+	position = 0;
+	for (size_t i=0; i<blocks.size(); i++)
+	{
+		delete blocks[i];
+	}
+	blocks.clear();
+
+	if (gzTrace != NULL)
+	{
+		gzclose(gzTrace);
+		gzTrace = NULL;
+	}
+#ifdef HAVE_ZSTD
+	if (zstdTrace != NULL)
+	{
+		fclose(zstdTrace);
+		zstdTrace = NULL;
+		ZSTD_freeDCtx(zstdContext);
+		zstdContext = NULL;
+	}
+#endif
+	if (mapped != NULL)
+	{
+		munmap((void *)mapped, mappedLength);
+		mapped = NULL;
+	}
+	binary = false;
+}
+
+bool TraceReader::getline(string &line)
+{
+	while (current == NULL || position == current->lines.size())
+	{
+		if (!prefetching || (current != NULL && current->last))
+		{
+			atEnd = true;
+			line.clear();
+			return false;
+		}
+		nextBlock();
+	}
+	line.swap(current->lines[position++]);
+	if (current->last && current->lastLineUnterminated && position == current->lines.size())
+	{
+		atEnd = true;
+	}
+	return true;
+}
+
+bool TraceReader::getRecord(TraceRecord &record)
+{
+	while (current == NULL || position == current->records.size())
+	{
+		if (!prefetching || (current != NULL && current->last))
+		{
+			atEnd = true;
+			return false;
+		}
+		nextBlock();
+	}
+	record = current->records[position++];
+	return true;
+}
+
+// replaces current with the next block from the prefetch thread, waiting
+// for it if need be
+void TraceReader::nextBlock()
+{
+	delete current;
+	position = 0;
+
+	pthread_mutex_lock(&blockLock);
+	while (blocks.empty())
+	{
+		pthread_cond_wait(&blockReady, &blockLock);
+	}
+	current = blocks.front();
+	blocks.pop_front();
+	pthread_cond_signal(&blockTaken);
+	pthread_mutex_unlock(&blockLock);
+}
+
+// hands a block to the consumer, waiting while it is TRACE_BLOCKS_AHEAD
+// blocks behind; returns false if the reader is being closed
+bool TraceReader::pushBlock(Block *block)
+{
+	pthread_mutex_lock(&blockLock);
+	while (blocks.size() >= TRACE_BLOCKS_AHEAD && !stopPrefetch)
+	{
+		pthread_cond_wait(&blockTaken, &blockLock);
+	}
+	if (stopPrefetch)
+	{
+		pthread_mutex_unlock(&blockLock);
+		delete block;
+		return false;
+	}
+	blocks.push_back(block);
+	pthread_cond_signal(&blockReady);
+	pthread_mutex_unlock(&blockLock);
+	return true;
+}
+
+void *TraceReader::prefetchMain(void *arg)
+{
+	TraceReader *reader = (TraceReader *)arg;
+	if (reader->binary)
+	{
+		reader->prefetchBinary();
+	}
+	else
+	{
+		reader->prefetchText();
+	}
+	return NULL;
+}
+
+// fills buffer with up to length decompressed bytes, returning 0 at the end
+size_t TraceReader::readText(char *buffer, size_t length)
+{
+#ifdef HAVE_ZSTD
+	if (textFormat == Zstd)
+	{
+		ZSTD_outBuffer out = {buffer, length, 0};
+		bool inputLeft = true;
+		while (out.pos < out.size && inputLeft)
+		{
+			if (zstdIn.pos == zstdIn.size)
+			{
+				zstdIn.size = fread(&zstdInput[0], 1, zstdInput.size(), zstdTrace);
+				zstdIn.pos = 0;
+				inputLeft = zstdIn.size > 0;
+			}
+			// with no input left this still flushes what the decoder holds
+			size_t ret = ZSTD_decompressStream(zstdContext, &out, &zstdIn);
+			if (ZSTD_isError(ret))
+			{
+				ERROR("Cannot decompress trace: "<<ZSTD_getErrorName(ret));
+				exit(-1);
+			}
+		}
+		return out.pos;
+	}
+#endif
+	int bytesRead = gzread(gzTrace, buffer, length);
+	if (bytesRead < 0)
+	{
+		int errnum;
+		ERROR("Cannot read trace: "<<gzerror(gzTrace, &errnum));
+		exit(-1);
+	}
+	return bytesRead;
+}
+
+void TraceReader::prefetchText()
+{
+	vector<char> buffer(1<<16);
+	string partial;
+	Block *block = new Block();
+	size_t bytesRead;
+	while ((bytesRead = readText(&buffer[0], buffer.size())) > 0)
+	{
+		const char *start = &buffer[0];
+		const char *end = start + bytesRead;
+		const char *newline;
+		while ((newline = (const char *)memchr(start, '\n', end - start)) != NULL)
+		{
+			partial.append(start, newline - start);
+			block->lines.push_back(string());
+			block->lines.back().swap(partial);
+			start = newline + 1;
+			if (block->lines.size() == TRACE_BLOCK_LINES)
+			{
+				if (!pushBlock(block))
+				{
+					return;
+				}
+				block = new Block();
+			}
+		}
+		partial.append(start, end - start);
+	}
+	if (!partial.empty())
+	{
+		block->lines.push_back(partial);
+		block->lastLineUnterminated = true;
+	}
+	block->last = true;
+	pushBlock(block);
+}
+
+void TraceReader::prefetchBinary()
+{
+	const unsigned char *next = mapped + BINARY_TRACE_HEADER_BYTES;
+	uint64_t recordsLeft = numRecords;
+	bool last = false;
+	while (!last)
+	{
+		Block *block = new Block();
+		size_t count = recordsLeft < TRACE_BLOCK_RECORDS ? recordsLeft : TRACE_BLOCK_RECORDS;
+		block->records.resize(count);
+		for (size_t i=0; i<count; i++)
+		{
+			TraceRecord &record = block->records[i];
+			uint64_t cycleAndType = readLittleEndian(next+8);
+			record.address = readLittleEndian(next);
+			record.cycle = cycleAndType >> 1;
+			record.isWrite = cycleAndType & 1;
+			next += BINARY_TRACE_RECORD_BYTES;
+		}
+		recordsLeft -= count;
+		last = recordsLeft == 0;
+		block->last = last;
+		if (!pushBlock(block))
+		{
+			return;
+		}
+	}
+}
@@ -0,0 +1,143 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef TRACEREADER_H
+#define TRACEREADER_H
+
+//TraceReader.h
+//
+//Header file for the trace file reader
+//
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdio>
+#include <pthread.h>
+#include <zlib.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace std;
+
+namespace DRAMSim
+{
+// one parsed trace line
+struct TraceRecord
+{
+	uint64_t address;
+	uint64_t cycle : 63;
+	uint64_t isWrite : 1;
+};
+
+// Binary traces start with the 8 magic bytes below and a little-endian
+// uint64_t record count, followed by that many 16 byte records of two
+// little-endian uint64_t: the address and (cycle << 1 | isWrite)
+#define BINARY_TRACE_MAGIC "DRSMTRC1"
+#define BINARY_TRACE_HEADER_BYTES 16
+#define BINARY_TRACE_RECORD_BYTES 16
+
+bool writeBinaryTrace(const string &filename, const vector<TraceRecord> &records);
+
+// Reads a trace file in the background. Text traces may be plain, gzip'd or
+// (when built with ZSTD=1) zstd compressed and are handed out a line at a
+// time; binary traces are mmap'd and handed out a record at a time. Either
+// way, a prefetch thread decompresses or decodes the file in blocks ahead
+// of the simulation.
+class TraceReader
+{
+public:
+	TraceReader();
+	~TraceReader();
+	bool open(const string &filename);
+	void close();
+	bool isBinary() const { return binary; }
+	// like ifstream: true once a getline()/getRecord() ran into the end of the file
+	bool eof() const { return atEnd; }
+	bool getline(string &line);
+	bool getRecord(TraceRecord &record);
+
+private:
+	enum TextFormat
+	{
+		PlainOrGzip,
+		Zstd
+	};
+
+	struct Block
+	{
+		Block() : last(false), lastLineUnterminated(false) {}
+		vector<string> lines;
+		vector<TraceRecord> records;
+		bool last; // no blocks follow this one
+		bool lastLineUnterminated; // the file didn't end with a newline
+	};
+
+	static void *prefetchMain(void *arg);
+	void prefetchText();
+	void prefetchBinary();
+	size_t readText(char *buffer, size_t length);
+	bool pushBlock(Block *block);
+	void nextBlock();
+
+	bool binary;
+	bool atEnd;
+	TextFormat textFormat;
+	gzFile gzTrace;
+#ifdef HAVE_ZSTD
+	FILE *zstdTrace;
+	ZSTD_DCtx *zstdContext;
+	vector<char> zstdInput;
+	ZSTD_inBuffer zstdIn;
+#endif
+	const unsigned char *mapped;
+	size_t mappedLength;
+	uint64_t numRecords;
+
+	// consumer side: the block being handed out and the position in it
+	Block *current;
+	size_t position;
+
+	// blocks decoded by the prefetch thread, oldest first
+	pthread_t prefetchThread;
+	bool prefetching;
+	pthread_mutex_t blockLock;
+	pthread_cond_t blockReady;
+	pthread_cond_t blockTaken;
+	deque<Block *> blocks;
+	bool stopPrefetch;
+};
+}
+
+#endif
+
@@ -0,0 +1,262 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+
+
+
+
+
+
+//TrafficGenerator.cpp
+//
+//Class file for the synthetic traffic generators of TraceBasedSim
+//
+
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include "TrafficGenerator.h"
+#include "PrintMacros.h"
+
+using namespace DRAMSim;
+
+// "64M" -> 64<<20
+static uint64_t parseSize(const string &value)
+{
+	char *end;
+	uint64_t size = strtoull(value.c_str(), &end, 0);
+	switch (*end)
+	{
+	case 'k': case 'K': size <<= 10; end++; break;
+	case 'm': case 'M': size <<= 20; end++; break;
+	case 'g': case 'G': size <<= 30; end++; break;
+	}
+	if (end == value.c_str() || *end != '\0')
+	{
+		ERROR("Bad size '"<<value<<"' in the traffic spec");
+		exit(-1);
+	}
+	return size;
+}
+
+static double parseDouble(const string &value)
+{
+	char *end;
+	double d = strtod(value.c_str(), &end);
+	if (end == value.c_str() || *end != '\0')
+	{
+		ERROR("Bad number '"<<value<<"' in the traffic spec");
+		exit(-1);
+	}
+	return d;
+}
+
+// "0.5" or "LOW:HIGH:STEP"
+static void parseRates(const string &value, vector<double> &rates)
+{
+	rates.clear();
+	size_t colon = value.find(':');
+	if (colon == string::npos)
+	{
+		rates.push_back(parseDouble(value));
+	}
+	else
+	{
+		size_t colon2 = value.find(':', colon+1);
+		if (colon2 == string::npos)
+		{
+			ERROR("rate ranges are LOW:HIGH:STEP, got '"<<value<<"'");
+			exit(-1);
+		}
+		double low = parseDouble(value.substr(0, colon));
+		double high = parseDouble(value.substr(colon+1, colon2-colon-1));
+		double step = parseDouble(value.substr(colon2+1));
+		if (step <= 0)
+		{
+			ERROR("The rate step has to be positive, got '"<<value<<"'");
+			exit(-1);
+		}
+		// the small slack keeps HIGH in despite rounding
+		for (unsigned i=0; low + i*step <= high + step*1e-6; i++)
+		{
+			rates.push_back(low + i*step);
+		}
+	}
+	for (size_t i=0; i<rates.size(); i++)
+	{
+		if (rates[i] <= 0)
+		{
+			ERROR("The rate has to be positive, got '"<<value<<"'");
+			exit(-1);
+		}
+	}
+}
+
+void DRAMSim::parseTrafficSpec(const string &spec, TrafficParams &params)
+{
+	stringstream ss(spec);
+	string name;
+	getline(ss, name, ',');
+	if (name == "stream")
+		params.pattern = StreamTraffic;
+	else if (name == "stride")
+		params.pattern = StrideTraffic;
+	else if (name == "random")
+		params.pattern = RandomTraffic;
+	else if (name == "chase")
+		params.pattern = ChaseTraffic;
+	else if (name == "hammer")
+		params.pattern = HammerTraffic;
+	else if (name == "mix")
+		params.pattern = MixTraffic;
+	else
+	{
+		ERROR("Unknown traffic pattern '"<<name<<"', expected stream, stride, random, chase, hammer or mix");
+		exit(-1);
+	}
+	params.name = name;
+	params.rates.assign(1, 1.0);
+	params.footprint = 256 << 20;
+	params.outstanding = params.pattern == ChaseTraffic ? 1 : 64;
+	params.stride = 4096;
+	params.rows = 2;
+	params.writeFraction = params.pattern == MixTraffic ? 0.3 : 0.0;
+	params.seed = 1;
+
+	string keyValuePair;
+	while (getline(ss, keyValuePair, ','))
+	{
+		size_t equals = keyValuePair.find('=');
+		if (equals == string::npos)
+		{
+			ERROR("Expected KEY=VALUE in the traffic spec, got '"<<keyValuePair<<"'");
+			exit(-1);
+		}
+		string key = keyValuePair.substr(0, equals);
+		string value = keyValuePair.substr(equals+1);
+		if (key == "rate")
+			parseRates(value, params.rates);
+		else if (key == "footprint")
+			params.footprint = parseSize(value);
+		else if (key == "outstanding")
+			params.outstanding = parseSize(value);
+		else if (key == "stride")
+			params.stride = parseSize(value);
+		else if (key == "rows")
+			params.rows = parseSize(value);
+		else if (key == "writes")
+			params.writeFraction = parseDouble(value);
+		else if (key == "seed")
+			params.seed = parseSize(value);
+		else
+		{
+			ERROR("Unknown traffic parameter '"<<key<<"'");
+			exit(-1);
+		}
+	}
+
+	if (params.outstanding == 0 || params.rows == 0 || params.stride == 0)
+	{
+		ERROR("outstanding, rows and stride have to be positive");
+		exit(-1);
+	}
+	if (params.writeFraction < 0 || params.writeFraction > 1)
+	{
+		ERROR("writes is the share of writes, between 0 and 1");
+		exit(-1);
+	}
+}
+
+TrafficGenerator::TrafficGenerator(const TrafficParams &params_, unsigned transactionSize_) :
+	params(params_),
+	transactionSize(transactionSize_),
+	count(0),
+	// xorshift gets stuck at 0
+	rngState(params_.seed ? params_.seed : 1),
+	readyChains(params_.pattern == ChaseTraffic ? params_.outstanding : 1)
+{
+	lines = params.footprint / transactionSize;
+	if (lines == 0)
+	{
+		lines = 1;
+	}
+	rowDistance = (lines / params.rows) * transactionSize;
+	generate();
+}
+
+// xorshift64*
+uint64_t TrafficGenerator::random()
+{
+	rngState ^= rngState >> 12;
+	rngState ^= rngState << 25;
+	rngState ^= rngState >> 27;
+	return rngState * 2685821657736338717ULL;
+}
+
+void TrafficGenerator::generate()
+{
+	switch (params.pattern)
+	{
+	case StreamTraffic:
+		nextAddr = (count % lines) * transactionSize;
+		break;
+	case StrideTraffic:
+		nextAddr = (count * params.stride) % (lines * transactionSize);
+		nextAddr -= nextAddr % transactionSize;
+		break;
+	case HammerTraffic:
+		nextAddr = (count % params.rows) * rowDistance;
+		break;
+	default:
+		nextAddr = (random() % lines) * transactionSize;
+		break;
+	}
+	// 53 random bits to a double in [0,1)
+	nextWrite = params.writeFraction > 0 && (random() >> 11) * (1.0/9007199254740992.0) < params.writeFraction;
+}
+
+void TrafficGenerator::accept()
+{
+	count++;
+	if (params.pattern == ChaseTraffic)
+	{
+		readyChains--;
+	}
+	generate();
+}
+
+void TrafficGenerator::complete()
+{
+	if (params.pattern == ChaseTraffic)
+	{
+		readyChains++;
+	}
+}
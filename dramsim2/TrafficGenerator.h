@@ -0,0 +1,115 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+
+
+
+
+
+
+#ifndef TRAFFICGENERATOR_H
+#define TRAFFICGENERATOR_H
+
+//TrafficGenerator.h
+//
+//Header file for the synthetic traffic generators of TraceBasedSim
+//
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace DRAMSim
+{
+enum TrafficPattern
+{
+	StreamTraffic, // consecutive transactions
+	StrideTraffic, // every stride bytes
+	RandomTraffic, // uniformly random over the footprint
+	ChaseTraffic, // random, each chain waits for its last read (pointer chasing)
+	HammerTraffic, // alternating between a few rows footprint/rows apart
+	MixTraffic // random, with a share of writes
+};
+
+// what -g PATTERN,KEY=VALUE,... asked for
+struct TrafficParams
+{
+	TrafficPattern pattern;
+	string name;
+	// transactions offered per cycle; several values make a curve
+	vector<double> rates;
+	uint64_t footprint; // bytes
+	unsigned outstanding; // transactions in flight (chains for chase)
+	uint64_t stride; // bytes, for stride
+	unsigned rows; // for hammer
+	double writeFraction;
+	uint64_t seed;
+};
+
+// Parses "PATTERN[,KEY=VALUE...]" (see usage()); exits on a bad spec
+void parseTrafficSpec(const string &spec, TrafficParams &params);
+
+// Hands out the addresses of one pattern. The caller decides when to issue
+// (rate and outstanding limit); the generator only says whether a dependent
+// pattern has a transaction ready, and next() stays valid until accept()
+class TrafficGenerator
+{
+public:
+	TrafficGenerator(const TrafficParams &params, unsigned transactionSize);
+
+	bool ready() const { return readyChains > 0; }
+	bool nextIsWrite() const { return nextWrite; }
+	uint64_t nextAddress() const { return nextAddr; }
+	// the next transaction was added to the memory system
+	void accept();
+	// a transaction finished
+	void complete();
+
+private:
+	void generate();
+	uint64_t random();
+
+	const TrafficParams &params;
+	unsigned transactionSize;
+	uint64_t lines; // transactions in the footprint
+	uint64_t rowDistance; // hammer
+	uint64_t count; // transactions accepted
+	uint64_t rngState;
+	unsigned readyChains;
+
+	bool nextWrite;
+	uint64_t nextAddr;
+};
+}
+
+#endif
@@ -47,13 +47,14 @@
 using namespace DRAMSim;
 using namespace std;
 
-Transaction::Transaction() {}
+Transaction::Transaction() : requestor(0) {}
 
-Transaction::Transaction(TransactionType transType, uint64_t addr, void *dat)
+Transaction::Transaction(TransactionType transType, uint64_t addr, void *dat, unsigned requestor_)
 {
 	transactionType = transType;
 	address = addr;
 	data = dat;
+	requestor = requestor_;
 }
 
 void Transaction::print()
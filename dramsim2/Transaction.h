@@ -55,18 +55,25 @@ public:
 	//fields
 	TransactionType transactionType;
 	uint64_t address;
+	//a write's transactionSize bytes (or NULL). the caller keeps the buffer:
+	//MultiChannelMemorySystem::addTransaction() copies it, and the memory
+	//system frees its copy once the write reaches the bank. a returned
+	//read's data points into the bank's storage
 	void *data;
 	uint64_t timeAdded;
 	uint64_t timeReturned;
+	//the source that sent it (e.g. demand misses, prefetches); selects its
+	//REQUESTOR_QUEUE_LIMITS and REQUESTOR_PRIORITIES entries and its stats
+	unsigned requestor;
 
 
 	//functions
-	Transaction(TransactionType transType, uint64_t addr, void *data);
+	Transaction(TransactionType transType, uint64_t addr, void *data, unsigned requestor = 0);
 	Transaction();
 
 	void print();
 
-	BusPacketType getBusPacketType()
+	BusPacketType getBusPacketType(RowBufferPolicy rowBufferPolicy) const
 	{
 		switch (transactionType)
 		{
@@ -75,7 +82,7 @@ public:
 			{
 				return READ_P;
 			}
-			else if (rowBufferPolicy == OpenPage)
+			else if (rowBufferPolicy == OpenPage || rowBufferPolicy == AdaptivePage)
 			{
 				return READ; 
 			}
@@ -90,7 +97,7 @@ public:
 			{
 				return WRITE_P;
 			}
-			else if (rowBufferPolicy == OpenPage)
+			else if (rowBufferPolicy == OpenPage || rowBufferPolicy == AdaptivePage)
 			{
 				return WRITE; 
 			}
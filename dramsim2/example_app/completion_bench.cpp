@@ -0,0 +1,122 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+
+
+// Completion throughput under streaming traffic: reads to consecutive lines
+// are added whenever the memory system takes them, and the finished ones are
+// received once through the callbacks and once through the completion buffer.
+//
+//   ./completion_bench [device.ini [system.ini [cycles]]]
+//
+// paths are relative to the DRAMSim2 directory
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include <vector>
+#include <DRAMSim.h>
+
+using namespace DRAMSim;
+
+struct completion_counter
+{
+	uint64_t count;
+	uint64_t address_sum;
+
+	completion_counter() : count(0), address_sum(0) {}
+	void complete(unsigned id, uint64_t address, uint64_t clock_cycle)
+	{
+		count++;
+		address_sum += address;
+	}
+};
+
+static double wall_time()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static void run(const char *dev, const char *sys, uint64_t cycles, bool pull)
+{
+	MultiChannelMemorySystem *mem = getMemorySystemInstance(dev, sys, "..", "example_app", 4096);
+	completion_counter counter;
+	std::vector<TransactionCompletion> completions;
+	if (pull)
+	{
+		completions.resize(4096);
+		mem->RegisterCompletionBuffer(&completions[0], completions.size());
+	}
+	else
+	{
+		TransactionCompleteCB *cb = new Callback<completion_counter, void, unsigned, uint64_t, uint64_t>(&counter, &completion_counter::complete);
+		mem->RegisterCallbacks(cb, cb, NULL);
+	}
+
+	uint64_t addr = 0;
+	double start = wall_time();
+	for (uint64_t i=0; i<cycles; i++)
+	{
+		while (mem->willAcceptTransaction(addr))
+		{
+			mem->addTransaction(false, addr);
+			addr = (addr + 64) % (4096ULL << 20);
+		}
+		mem->update();
+		if (pull)
+		{
+			size_t n = mem->takeCompletions();
+			for (size_t j=0; j<n; j++)
+			{
+				counter.complete(completions[j].id, completions[j].address, completions[j].cycle);
+			}
+		}
+	}
+	double elapsed = wall_time() - start;
+
+	printf("%-9s %10lu completions in %7.3f s, %6.2f M completions/s, %6.2f M cycles/s (address sum %lx)\n",
+	       pull ? "buffer" : "callback", counter.count, elapsed, counter.count / elapsed * 1e-6,
+	       cycles / elapsed * 1e-6, counter.address_sum);
+}
+
+int main(int argc, char **argv)
+{
+	const char *dev = argc > 1 ? argv[1] : "ini/DDR3_micron_32M_8B_x8_sg15.ini";
+	const char *sys = argc > 2 ? argv[2] : "system.ini.example";
+	uint64_t cycles = argc > 3 ? strtoull(argv[3], NULL, 10) : 2000000;
+
+	run(dev, sys, cycles, false);
+	run(dev, sys, cycles, true);
+	return 0;
+}
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+"""Reads the binary epoch statistics DRAMSim2 writes with VIS_FILE_FORMAT=binary.
+
+As a script, converts a .visb file to CSV on stdout (or the -o file):
+
+  visb2csv.py results/.../foo.visb > foo.csv
+  visb2csv.py --long foo.visb -o foo_long.csv
+
+The default is one row per epoch and one column per statistic, like the
+epoch data of a csv .vis file. --long writes one row per value instead
+(ms, stat, channel, rank, bank, value), which is easier to group and plot.
+
+As a module:
+
+  import visb2csv
+  names, rows = visb2csv.read("foo.visb")   # lists, or a numpy array if numpy is installed
+  df = visb2csv.dataframe("foo.visb")       # pandas DataFrame, one column per statistic
+"""
+
+import argparse
+import csv
+import re
+import struct
+import sys
+
+MAGIC = b"DRAMVISB"
+VERSION = 1
+HEADER = struct.Struct("=8sIII")
+INDEXED_NAME = re.compile(r"^([^\[]+)((?:\[\d+\])*)$")
+
+
+def read_header(f):
+    magic, version, num_columns, names_length = HEADER.unpack(f.read(HEADER.size))
+    if magic != MAGIC:
+        raise ValueError("not a DRAMSim2 binary vis file")
+    if version != VERSION:
+        raise ValueError("unsupported version %d" % version)
+    names = f.read(names_length).split(b"\0")[:num_columns]
+    return [n.decode() for n in names], HEADER.size + names_length
+
+
+def read(path):
+    """Returns the column names and the rows, as a numpy array if available."""
+    with open(path, "rb") as f:
+        names, offset = read_header(f)
+        try:
+            import numpy
+        except ImportError:
+            data = f.read()
+            row = struct.Struct("=%dd" % len(names))
+            usable = len(data) - len(data) % row.size
+            return names, [row.unpack_from(data, i) for i in range(0, usable, row.size)]
+    rows = numpy.fromfile(path, dtype=numpy.float64, offset=offset)
+    # a run that was cut short may have left a partial row
+    rows = rows[: len(rows) - len(rows) % len(names)] if names else rows[:0]
+    return names, rows.reshape(-1, len(names))
+
+
+def dataframe(path):
+    import pandas
+    names, rows = read(path)
+    return pandas.DataFrame(rows, columns=names)
+
+
+def split_name(name):
+    """Background_Power[0][1] -> ("Background_Power", [0, 1])"""
+    m = INDEXED_NAME.match(name)
+    if not m:
+        return name, []
+    return m.group(1), [int(i) for i in re.findall(r"\d+", m.group(2))]
+
+
+def write_wide(names, rows, out):
+    w = csv.writer(out)
+    w.writerow(names)
+    for row in rows:
+        w.writerow([repr(float(v)) for v in row])
+
+
+def write_long(names, rows, out):
+    w = csv.writer(out)
+    w.writerow(["ms", "stat", "channel", "rank", "bank", "value"])
+    ms = names.index("ms") if "ms" in names else None
+    fields = []
+    for i, name in enumerate(names):
+        if i == ms:
+            continue
+        stat, index = split_name(name)
+        fields.append((i, stat, (index + [""] * 3)[:3]))
+    for row in rows:
+        t = repr(float(row[ms])) if ms is not None else ""
+        for i, stat, index in fields:
+            w.writerow([t, stat] + index + [repr(float(row[i]))])
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert a DRAMSim2 .visb file to CSV")
+    parser.add_argument("visb", help="binary epoch statistics file")
+    parser.add_argument("-o", "--output", help="CSV file to write (default: stdout)")
+    parser.add_argument("--long", action="store_true", help="one row per value instead of per epoch")
+    args = parser.parse_args()
+
+    names, rows = read(args.visb)
+    out = open(args.output, "w", newline="") if args.output else sys.stdout
+    (write_long if args.long else write_wide)(names, rows, out)
+    if args.output:
+        out.close()
+
+
+if __name__ == "__main__":
+    main()